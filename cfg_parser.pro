@@ -16,16 +16,39 @@ INCLUDEPATH += . include src src/gui src/build/CFGParser_autogen/include
 # Input
 HEADERS += ui_mainwindow.h \
            include/analysis_results.h \
+           include/analysis_session.h \
+           include/block_frequency.h \
            include/cfg_analyzer.h \
+           include/cfg_corpus.h \
+           include/cfg_diff.h \
            include/cfg_generation_action.h \
+           include/cfg_hash.h \
+           include/cfg_metrics.h \
            include/cfg_gui.h \
            include/CFGBridge.h \
+           include/clone_detection.h \
+           include/control_dependence.h \
+           include/csr_graph.h \
            include/customgraphview.h \
+           include/dataflow.h \
+           include/dataflow_clients.h \
+           include/dead_code.h \
+           include/dominators.h \
            include/edge.h \
            include/graph_generator.h \
+           include/graph_simplify.h \
+           include/graph_slice.h \
+           include/graph_traversal.h \
            include/graphical_cfg_node.h \
+           include/json_writer.h \
+           include/loop_forest.h \
            include/mainwindow.h \
            include/node.h \
+           include/parallel_for.h \
+           include/path_analysis.h \
+           include/profile_plan.h \
+           include/program_structure.h \
+           include/reachability.h \
            include/parser.h \
            include/visualizer.h \
            src/build/CFGParser_autogen/include/ui_mainwindow.h
@@ -43,19 +66,39 @@ CONFIG += c++17
 
 FORMS += src/gui/mainwindow.ui
 
-SOURCES += src/cfg_analyzer.cpp \
+SOURCES += src/analysis_session.cpp \
+           src/block_frequency.cpp \
+           src/cfg_analyzer.cpp \
+           src/cfg_corpus.cpp \
+           src/cfg_diff.cpp \
            src/cfg_generation_action.cpp \
            src/cfg_graph.cpp \
+           src/cfg_hash.cpp \
+           src/cfg_metrics.cpp \
            src/CFGBridge.cpp \
+           src/clone_detection.cpp \
+           src/control_dependence.cpp \
+           src/csr_graph.cpp \
+           src/dataflow.cpp \
+           src/dataflow_clients.cpp \
+           src/dead_code.cpp \
+           src/dominators.cpp \
            src/edge.cpp \
            src/file.cpp \
            src/graph_generator.cpp \
-           src/graph_generator_impl.cpp \
+           src/graph_simplify.cpp \
+           src/graph_slice.cpp \
            src/graphical_cfg_node.cpp \
            src/input.cpp \
+           src/json_writer.cpp \
+           src/loop_forest.cpp \
            src/main.cpp \
            src/node.cpp \
            src/parser.cpp \
+           src/path_analysis.cpp \
+           src/profile_plan.cpp \
+           src/program_structure.cpp \
+           src/reachability.cpp \
            src/visualizer.cpp \
            src/gui/cfg_gui.cpp \
            src/gui/customgraphview.cpp \
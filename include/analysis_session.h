@@ -0,0 +1,71 @@
+#ifndef ANALYSIS_SESSION_H
+#define ANALYSIS_SESSION_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_set>
+
+namespace GraphGenerator {
+
+    // Allocation counters of an AnalysisSession.
+    struct AllocationStats {
+        size_t arenaAllocations = 0;     // requests served by the arena
+        size_t arenaBytes = 0;
+        size_t upstreamAllocations = 0;  // blocks the arena took from the heap
+        size_t upstreamBytes = 0;
+        size_t internedStrings = 0;      // distinct strings in the pool
+        size_t internHits = 0;           // intern() calls answered by an existing string
+    };
+
+    // Owns the memory of every graph built during one analysis: one
+    // translation unit in the command line tool, one loaded graph in the
+    // GUI. Allocations come from a monotonic arena and are never freed
+    // individually; destroying the session returns the arena's few large
+    // blocks to the heap at once. Graphs built from a session hold a
+    // shared_ptr to it, so it outlives them automatically.
+    //
+    // A session is not thread-safe. Give each analysis thread its own
+    // session rather than sharing one, which also keeps threads from
+    // contending on the global allocator.
+    class AnalysisSession {
+    public:
+        explicit AnalysisSession(size_t initialBlockSize = 16 * 1024);
+        AnalysisSession(const AnalysisSession&) = delete;
+        AnalysisSession& operator=(const AnalysisSession&) = delete;
+
+        std::pmr::memory_resource* resource() { return &m_counter; }
+
+        // Returns a view of an arena copy of text. Equal strings are stored
+        // once and yield the same pointer, so interned views can be compared
+        // by data().
+        std::string_view intern(std::string_view text);
+
+        AllocationStats stats() const;
+
+    private:
+        // Forwards to another resource and counts what passes through.
+        class CountingResource : public std::pmr::memory_resource {
+        public:
+            explicit CountingResource(std::pmr::memory_resource* upstream) : m_upstream(upstream) {}
+            size_t allocations = 0;
+            size_t bytes = 0;
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override;
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+            std::pmr::memory_resource* m_upstream;
+        };
+
+        CountingResource m_upstream;
+        std::pmr::monotonic_buffer_resource m_arena;
+        CountingResource m_counter;
+        std::pmr::unordered_set<std::string_view> m_strings;
+        size_t m_internHits = 0;
+    };
+
+} // namespace GraphGenerator
+
+#endif // ANALYSIS_SESSION_H
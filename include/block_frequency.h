@@ -0,0 +1,54 @@
+#ifndef BLOCK_FREQUENCY_H
+#define BLOCK_FREQUENCY_H
+
+#include <string>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include "csr_graph.h"
+#include "loop_forest.h"
+
+namespace GraphGenerator {
+
+    // Static profile estimation (Wu and Larus, "Static Branch Frequency and
+    // Program Profile Analysis"), for code that has never been run.
+    //
+    // Each two-way branch starts at 50/50 and every heuristic that applies
+    // sharpens it, their evidence combined with Dempster-Shafer's rule:
+    //   loop branch   a back edge is taken, a loop exit from the header is not   0.88
+    //   loop exit     any other edge leaving a loop is not taken                 0.80
+    //   pointer       p == q and !p fail, p != q and p hold                      0.60
+    //   opcode        x < 0, x <= 0 and x == c fail; floats are never equal      0.84
+    //   return        a successor that returns is avoided                        0.72
+    //   call          a successor that makes a call is avoided                   0.78
+    // The pointer and opcode rules read the branch condition, so they need
+    // graphs built from clang. Edges that raise or end in a throw or a call
+    // that does not return are cold whatever the branch: they share
+    // ColdProbability and the other edges split the rest.
+    constexpr double ColdProbability = 1.0 / 1024;
+
+    // Probability of each CSR edge given its source runs; those leaving a
+    // block sum to 1.
+    std::vector<double> estimateBranchProbabilities(const CSRGraph& graph, const LoopForest& loops);
+
+    // Expected executions of each block per call of the function (the
+    // entry block once, unreachable blocks never). Loops are folded
+    // innermost first: a header runs 1 / (1 - p) times as often as its
+    // loop is entered, where p is the probability of getting back to it,
+    // capped so that no loop multiplies by more than MaxLoopScale.
+    constexpr double MaxLoopScale = 1024.0;
+    std::vector<double> estimateBlockFrequencies(const CSRGraph& graph, const LoopForest& loops,
+                                                 llvm::ArrayRef<double> probabilities);
+
+    // Frequency of each CSR edge: its source's frequency times its probability.
+    std::vector<double> edgeFrequencies(const CSRGraph& graph, llvm::ArrayRef<double> frequencies,
+                                        llvm::ArrayRef<double> probabilities);
+
+    // Heat map colour ("#rrggbb", pale yellow through orange to dark red)
+    // for a block frequency, on a log scale from 1/100 up to the hottest
+    // block's frequency but at least 10^4, so code outside loops stays
+    // light even in functions without any.
+    std::string heatColor(double frequency, double maxFrequency);
+
+} // namespace GraphGenerator
+
+#endif // BLOCK_FREQUENCY_H
@@ -11,8 +11,23 @@
 #include <QMutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <set>
 #include <memory>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "cfg_corpus.h"
+#include "cfg_metrics.h"
+#include "clone_detection.h"
+#include "dead_code.h"
+#include "path_analysis.h"
+#include "profile_plan.h"
+
+namespace GraphGenerator {
+    class AnalysisSession;
+}
 
 namespace CFGAnalyzer {
 
@@ -20,8 +35,43 @@ namespace CFGAnalyzer {
         std::string dotOutput;
         std::string jsonOutput;
         std::string report;
-        bool success;
+        bool success = false;
         std::unordered_map<std::string, std::set<std::string>> functionDependencies;
+        std::unordered_map<std::string, uint64_t> functionFingerprints;
+        size_t reusedFunctions = 0;
+        // Per function: (block ID, immediate dominator / post-dominator block ID).
+        std::unordered_map<std::string, std::vector<std::pair<int, int>>> immediateDominators;
+        std::unordered_map<std::string, std::vector<std::pair<int, int>>> immediatePostDominators;
+        // Per function: (block ID, ID of a block whose branch decides whether it runs).
+        std::unordered_map<std::string, std::vector<std::pair<int, int>>> controlDependence;
+        std::unordered_map<std::string, GraphGenerator::FunctionMetrics> functionMetrics;
+        // Numbering-independent CFG shape (computeStructuralHash), equal for
+        // functions that differ only in names and constants.
+        std::unordered_map<std::string, uint64_t> functionShapeHashes;
+        // Clang USRs: stable across edits to a body and distinct per overload,
+        // so diffRuns pairs functions across runs by them.
+        std::unordered_map<std::string, std::string> functionUSRs;
+        // Per function: where its definition lies in the main file.
+        std::unordered_map<std::string, GraphGenerator::SourceSpan> functionSpans;
+        // Per function: IDs of blocks the entry cannot reach, where there are any.
+        std::unordered_map<std::string, std::vector<int>> unreachableBlocks;
+        // Per function: where counters and path-register updates go.
+        std::unordered_map<std::string, GraphGenerator::InstrumentationPlan> instrumentationPlans;
+        // Per function: its acyclic path count and hottest paths, weighted
+        // by estimated block frequency.
+        std::unordered_map<std::string, GraphGenerator::PathSummary> pathSummaries;
+        // Roots for dead-function detection besides the configured names:
+        // externally visible definitions, and functions that may be called
+        // without a direct call (virtual or address-taken).
+        std::unordered_set<std::string> exportedFunctions;
+        std::unordered_set<std::string> indirectlyCalledFunctions;
+        // Functions no root reaches over functionDependencies, sorted.
+        std::vector<std::string> deadFunctions;
+        // When set, every function's CFG is added to it (clone detection).
+        std::shared_ptr<GraphGenerator::CloneIndex> cloneIndex;
+        size_t arenaAllocations = 0;     // graph allocations served by the session arena
+        size_t upstreamAllocations = 0;  // heap blocks the arena needed for them
+        size_t arenaBytes = 0;
     };
 
     class CFGConsumer;  // Forward declaration
@@ -35,6 +85,7 @@ namespace CFGAnalyzer {
         
         bool VisitFunctionDecl(clang::FunctionDecl* FD);
         bool VisitCallExpr(clang::CallExpr* CE);
+        bool VisitDeclRefExpr(clang::DeclRefExpr* DRE);
         void PrintFunctionDependencies() const;
         std::unordered_map<std::string, std::set<std::string>> GetFunctionDependencies() const;
         void FinalizeCombinedFile();
@@ -42,11 +93,25 @@ namespace CFGAnalyzer {
         AnalysisResult& getResults() { return m_results; }
         
     private:
+        void LoadFingerprintCache();
+        void SaveFingerprintCache() const;
+        // Cache entries are keyed by USR, which overloads do not share and
+        // which survives a function gaining or losing an overload.
+        std::string CacheKey(const std::string& funcName) const;
+        std::string MainFileName() const;
+
         clang::ASTContext* Context;
         std::string OutputDir;
         std::string CurrentFunction;
         AnalysisResult& m_results;
         std::unordered_map<std::string, std::set<std::string>> FunctionDependencies;
+        std::unordered_set<const clang::DeclRefExpr*> CalleeReferences;  // callees of direct calls
+        std::unordered_map<std::string, nlohmann::json> PreviousEntries;  // cache manifest of the last run over OutputDir, by CacheKey
+        std::vector<std::pair<std::string, std::shared_ptr<const GraphGenerator::CSRGraph>>> FunctionGraphs;  // built this run
+        std::vector<std::pair<std::string, std::shared_ptr<const GraphGenerator::CSRGraph>>> ReusedGraphs;  // unchanged, for the corpus only
+        std::unordered_set<std::string> UnchangedFunctions;  // in FunctionGraphs for clone detection only; their DOT is kept
+        std::shared_ptr<const GraphGenerator::CFGCorpus> PreviousCorpus;  // cfg_corpus.bin of the last run, if any
+        std::shared_ptr<GraphGenerator::AnalysisSession> Session;  // owns the TU's graph memory
     };
 
     class CFGConsumer : public clang::ASTConsumer {
@@ -81,17 +146,30 @@ namespace CFGAnalyzer {
     
         AnalysisResult analyzeFile(const QString& filePath);
         AnalysisResult analyze(const std::string& filename);
+        // Clone-detection mode: analyzes all files, then reports groups of
+        // near-duplicate functions across them (report and jsonOutput).
+        AnalysisResult findClones(const std::vector<std::string>& filenames,
+                                  const GraphGenerator::CloneDetectionOptions& options = {});
+        // Diff mode: compares the outputs of two earlier runs and writes a
+        // coloured <function>_diff.dot into afterDir for each changed function.
+        AnalysisResult compareRuns(const std::string& beforeDir, const std::string& afterDir);
+        // Which functions analyze() treats as live when reporting dead ones.
+        void setCallGraphRoots(GraphGenerator::CallGraphRoots roots) { m_callGraphRoots = std::move(roots); }
     
         void lock() { m_analysisMutex.lock(); }
         void unlock() { m_analysisMutex.unlock(); }
     
     private:
+        // Runs the CFG action over the sources into m_results. Returns the
+        // tool's exit code, or -1 (with result.report set) on setup failure.
+        int runTool(const std::vector<std::string>& sources, AnalysisResult& result);
         std::string generateDotOutput(const AnalysisResult& result) const;
         std::string generateReport(const AnalysisResult& result) const;
         static std::string getCurrentDateTime();
         
         mutable QMutex m_analysisMutex;
         AnalysisResult m_results;
+        GraphGenerator::CallGraphRoots m_callGraphRoots;
     };    
 } // namespace CFGAnalyzer
 #endif // CFG_ANALYZER_H
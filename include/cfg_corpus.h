@@ -0,0 +1,109 @@
+#ifndef CFG_CORPUS_H
+#define CFG_CORPUS_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "csr_graph.h"
+
+namespace llvm {
+    class MemoryBuffer;
+}
+
+namespace GraphGenerator {
+
+    // Where a function lies in its source file. Lines and columns are
+    // 1-based; zero when unknown.
+    struct SourceSpan {
+        std::string file;
+        uint32_t beginLine = 0;
+        uint32_t beginColumn = 0;
+        uint32_t endLine = 0;
+        uint32_t endColumn = 0;
+    };
+
+    // Binary container for the CFGs of many functions, in host byte order,
+    // laid out so that a mapped file can back CSRGraph views directly:
+    //   header: "CFGG", uint32 version, uint32 function count,
+    //           uint32 hash slot count, uint64 offset and size of the
+    //           string blob holding names and file paths, uint64 file size;
+    //   function count fixed-size records: name, key, source span,
+    //           element counts, entry, exit and the offset of the
+    //           function's arrays;
+    //   hash slot count uint32, record index + 1 by FNV-1a of the key
+    //           (open addressing, 0 for empty);
+    //   the string blob;
+    //   per function, its CSR arrays in CSRGraph order, each padded to
+    //           8 bytes: block IDs, forward and reverse adjacency, edge
+    //           flags, attributes, labels, statements, its own string
+    //           table as offsets plus characters, and the def-use rows
+    //           when the graph has them.
+    // AST handles (statement, terminator and variable decl pointers) are
+    // not stored, so graphs read back behave like graphs parsed from DOT.
+    class CorpusWriter {
+    public:
+        // CFGGraph::freeze() gives the snapshot of a graph being built.
+        // Lookups go by key, the name when none is given; the analyzer
+        // passes the USR, which overloads do not share. Functions keep the
+        // order they are added in; of ones with equal keys, lookups find
+        // the first. Empty graphs are skipped.
+        void addFunction(std::string name, std::shared_ptr<const CSRGraph> graph, SourceSpan span = {},
+                         std::string key = {});
+        size_t size() const { return m_functions.size(); }
+
+        // Writes a sibling temporary file and renames it over `filename`,
+        // so readers that still map the old corpus keep valid memory.
+        bool write(const std::string& filename) const;
+
+    private:
+        struct Function {
+            std::string name;
+            std::string key;
+            std::shared_ptr<const CSRGraph> graph;
+            SourceSpan span;
+        };
+        std::vector<Function> m_functions;
+    };
+
+    // Read-only view of a corpus file. open() maps the file and checks
+    // only the header and record table; graph(i) checks the sizes recorded
+    // for function i and returns views into the mapping, so loading a
+    // function costs the same whatever its size or position. The arrays
+    // themselves are trusted, as for the other binary tables. Graphs keep
+    // the corpus, and with it the mapping, alive.
+    class CFGCorpus : public std::enable_shared_from_this<CFGCorpus> {
+    public:
+        static constexpr size_t npos = ~size_t(0);
+
+        // Null if the file cannot be read or is not a corpus of this version.
+        static std::shared_ptr<const CFGCorpus> open(const std::string& filename);
+
+        size_t size() const { return m_functionCount; }
+        std::string_view name(size_t i) const;
+        std::string_view key(size_t i) const;
+        SourceSpan span(size_t i) const;
+        size_t find(std::string_view key) const;  // npos if absent
+
+        // Null if i is out of range or the function's arrays do not fit.
+        std::shared_ptr<const CSRGraph> graph(size_t i) const;
+        std::shared_ptr<const CSRGraph> graph(std::string_view key) const;
+
+        ~CFGCorpus();
+
+    private:
+        CFGCorpus() = default;
+
+        std::unique_ptr<llvm::MemoryBuffer> m_buffer;
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+        size_t m_functionCount = 0;
+        uint32_t m_hashSlots = 0;
+        uint64_t m_strings = 0;
+        uint64_t m_stringBytes = 0;
+    };
+
+} // namespace GraphGenerator
+
+#endif // CFG_CORPUS_H
@@ -0,0 +1,73 @@
+#ifndef CFG_DIFF_H
+#define CFG_DIFF_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    // Block-level differences between two versions of a function's CFG.
+    // Blocks are matched in three steps: entry and exit anchor each other;
+    // blocks whose structural label (after two, one, then zero refinement
+    // rounds, with their variable accesses mixed in) is unique on both
+    // sides are paired; then matches spread greedily to neighbours along
+    // edges with the same flags, first where labels agree and then where
+    // a single unmatched neighbour is left on each side.
+    struct GraphDiff {
+        std::vector<CSRGraph::Index> matchOf;             // before index -> after index, or InvalidIndex
+        std::vector<CSRGraph::Index> addedBlocks;          // after indices
+        std::vector<CSRGraph::Index> removedBlocks;        // before indices
+        std::vector<CSRGraph::Index> changedBlocks;        // after indices matched to a different block
+        std::vector<std::pair<int, int>> addedEdges;       // after block IDs
+        std::vector<std::pair<int, int>> removedEdges;     // before block IDs
+
+        bool empty() const {
+            return addedBlocks.empty() && removedBlocks.empty() && changedBlocks.empty() &&
+                   addedEdges.empty() && removedEdges.empty();
+        }
+    };
+
+    GraphDiff diffGraphs(const CSRGraph& before, const CSRGraph& after);
+
+    // One graph holding both versions, coloured for the GUI: the after
+    // graph with added blocks and edges green and changed blocks orange,
+    // plus the removed blocks and edges in red. Removed blocks are given
+    // IDs above the after graph's largest.
+    std::string diffToDot(const CSRGraph& before, const CSRGraph& after, const GraphDiff& diff);
+
+    // Reads a CFG written by Visualizer::exportToDot back without Qt:
+    // nodes, edges, exception flags and attributes, def-use sets, and the
+    // entry and exit recorded on the graph line. Null if unreadable.
+    std::shared_ptr<const CSRGraph> loadCfgDot(const std::string& path);
+    std::shared_ptr<const CSRGraph> parseCfgDot(std::string_view content);
+
+    enum class DiffStatus { Unchanged, Added, Removed, Changed };
+
+    struct FunctionDiff {
+        std::string name;
+        DiffStatus status = DiffStatus::Unchanged;
+        GraphDiff graph;    // filled for Changed
+        std::string dot;    // diff graph, filled for Changed
+    };
+
+    // Compares two analysis output directories through their cfg_cache.json
+    // manifests. Functions are paired by USR where both runs recorded one,
+    // otherwise by qualified name. Pairs with equal shape hashes and body
+    // fingerprints are reported unchanged without reading their graphs;
+    // the rest are loaded, from both runs' cfg_corpus.bin (looked up by the
+    // cache key, so overloads stay apart) when both hold the function and
+    // from the DOT files otherwise, and diffed in parallel.
+    // Sorted by name.
+    std::vector<FunctionDiff> diffRuns(const std::string& beforeDir, const std::string& afterDir,
+                                       unsigned threads = 0);
+
+    // Plain-text summary of diffRuns, listing only functions that differ.
+    std::string formatDiffReport(const std::vector<FunctionDiff>& diffs);
+
+} // namespace GraphGenerator
+
+#endif // CFG_DIFF_H
@@ -0,0 +1,40 @@
+#ifndef CFG_HASH_H
+#define CFG_HASH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    constexpr unsigned DefaultHashRounds = 3;
+
+    // Hash of a CFG's shape that does not depend on how its blocks are
+    // numbered (Weisfeiler-Lehman refinement). Every block starts from its
+    // entry/exit role, exception attributes and the clang statement classes
+    // it contains, so renamed variables or changed constants keep the
+    // hash. Each round mixes in the sorted labels of the block's successors
+    // and predecessors together with the edge flags; the result hashes the
+    // sorted multiset of final labels. Cost is O(rounds * (V + E log d)).
+    //
+    // Graphs without statement handles (read back from DOT) hash their
+    // statement counts instead, so they only compare among themselves.
+    // Equal graphs always hash equal; unequal graphs that the refinement
+    // cannot tell apart (e.g. some regular graphs) hash equal too.
+    uint64_t computeStructuralHash(const CSRGraph& graph, unsigned rounds = DefaultHashRounds);
+
+    // The refinement itself, for analyses that work on per-block labels:
+    // the starting label of every block, and one round applied in place.
+    std::vector<uint64_t> initialStructuralLabels(const CSRGraph& graph);
+    void refineStructuralLabels(const CSRGraph& graph, std::vector<uint64_t>& labels);
+
+    // The process-independent 64-bit mixing step used by the hashes above.
+    uint64_t mixHash(uint64_t seed, uint64_t value);
+
+    // Fixed-width lower-case hex, as the hash is written to DOT and JSON.
+    std::string formatStructuralHash(uint64_t hash);
+
+} // namespace GraphGenerator
+
+#endif // CFG_HASH_H
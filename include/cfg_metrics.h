@@ -0,0 +1,56 @@
+#ifndef CFG_METRICS_H
+#define CFG_METRICS_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include "csr_graph.h"
+#include "dominators.h"
+#include "loop_forest.h"
+
+namespace GraphGenerator {
+
+    // Structural metrics of one function's CFG.
+    struct FunctionMetrics {
+        uint32_t blocks = 0;
+        uint32_t edges = 0;
+        uint32_t exceptionEdges = 0;
+        int32_t cyclomaticComplexity = 0;  // E - N + 2
+        uint32_t maxLoopDepth = 0;
+        uint32_t maxNesting = 0;  // deepest block, counted in enclosing branch regions
+        uint32_t fanOut = 0;      // distinct direct callees, filled in by the analyzer
+    };
+
+    // A block is nested in a branch when the branch dominates it and the
+    // branch's immediate post-dominator (where its arms join) does not, so
+    // nesting comes from the trees in one pass in reverse post-order.
+    FunctionMetrics computeMetrics(const CSRGraph& graph, const FunctionDominators& trees,
+                                   const LoopForest& loops);
+
+    // computeMetrics for every graph on up to `threads` threads (hardware
+    // concurrency when 0). trees[i] and loops[i] belong to graphs[i]; null
+    // graphs give zeroed metrics.
+    std::vector<FunctionMetrics> computeMetricsBatch(
+        llvm::ArrayRef<std::shared_ptr<const CSRGraph>> graphs,
+        llvm::ArrayRef<FunctionDominators> trees,
+        llvm::ArrayRef<LoopForest> loops, unsigned threads = 0);
+
+    using MetricsTable = std::vector<std::pair<std::string, FunctionMetrics>>;
+
+    // One row per function with a header line.
+    bool writeMetricsCSV(const std::string& filename, const MetricsTable& rows);
+
+    // Binary table, in host byte order:
+    //   "CFGM", uint32 version, uint32 row count,
+    //   row count x 7 uint32 (the FunctionMetrics fields in order),
+    //   row count + 1 uint32 name offsets, then the concatenated names.
+    // Fixed-width records let readers rank or filter without parsing text.
+    bool writeMetricsTable(const std::string& filename, const MetricsTable& rows);
+    bool readMetricsTable(const std::string& filename, MetricsTable& rows);
+
+} // namespace GraphGenerator
+
+#endif // CFG_METRICS_H
@@ -0,0 +1,72 @@
+#ifndef CLONE_DETECTION_H
+#define CLONE_DETECTION_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    struct CloneDetectionOptions {
+        uint32_t signatureSize = 64;  // MinHash values per function
+        uint32_t rowsPerBand = 4;     // LSH band width; signatureSize / rowsPerBand bands
+        double minSimilarity = 0.8;   // estimated Jaccard similarity to report a pair
+        uint32_t minBlocks = 5;       // smaller functions all look alike and are skipped
+        unsigned threads = 0;         // 0: hardware concurrency
+    };
+
+    // Functions whose CFGs are near-duplicates of each other. The
+    // similarity of each member is estimated against functions[0].
+    struct CloneGroup {
+        std::vector<uint32_t> functions;  // indices into the CloneIndex
+        std::vector<double> similarity;
+    };
+
+    // Shingles describing a CFG, sorted and unique: the structural labels
+    // of every block after zero, one and two refinement rounds (its
+    // neighbourhood up to that radius), every edge between round-zero
+    // labels, and the 3-grams of clang statement classes inside blocks.
+    std::vector<uint64_t> cfgShingles(const CSRGraph& graph);
+
+    // Near-duplicate detection over a corpus of CFGs. Each function is
+    // reduced to a MinHash signature of its shingles as it is added, so
+    // graphs need not be kept alive. findGroups() buckets signatures by
+    // LSH bands, verifies the candidates inside each bucket against the
+    // bucket's first and previous member (linear even when thousands of
+    // functions share a bucket) and joins verified pairs into groups.
+    class CloneIndex {
+    public:
+        explicit CloneIndex(const CloneDetectionOptions& options = {});
+
+        // Signatures are computed in parallel. Safe to call from several
+        // threads.
+        void addFunctions(const std::vector<std::string>& names,
+                          const std::vector<std::shared_ptr<const CSRGraph>>& graphs);
+
+        size_t size() const { return m_names.size(); }
+        const std::string& name(uint32_t function) const { return m_names[function]; }
+
+        // Estimated Jaccard similarity of two functions' shingle sets.
+        double similarity(uint32_t a, uint32_t b) const;
+
+        // Groups of two or more functions, largest first.
+        std::vector<CloneGroup> findGroups() const;
+
+    private:
+        const uint32_t* signature(uint32_t function) const {
+            return m_signatures.data() + size_t(function) * m_options.signatureSize;
+        }
+
+        CloneDetectionOptions m_options;
+        std::vector<uint64_t> m_multipliers;  // one hash function per signature slot
+        std::vector<std::string> m_names;
+        std::vector<uint32_t> m_signatures;   // signatureSize values per function
+        mutable std::mutex m_mutex;
+    };
+
+} // namespace GraphGenerator
+
+#endif // CLONE_DETECTION_H
@@ -0,0 +1,73 @@
+#ifndef CONTROL_DEPENDENCE_H
+#define CONTROL_DEPENDENCE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include "csr_graph.h"
+#include "dominators.h"
+
+namespace GraphGenerator {
+
+    // Control dependence of a CFG: block B depends on block A when one of
+    // A's edges leads to B on every path while another can bypass it, so
+    // A's branch decides whether B runs. B's controllers are its
+    // post-dominance frontier, found by walking up the post-dominator tree
+    // from each edge target to the source's immediate post-dominator
+    // (Cytron et al.). Both directions are kept as CSR lists, and each
+    // dependence records the edge that induces it, so callers can tell
+    // which branch decides.
+    //
+    // Blocks that cannot reach the exit are absent from the post-dominator
+    // tree; walks through them stop at the tree's edge, so they only get
+    // the dependences found before that.
+    class ControlDependence {
+    public:
+        using Index = CSRGraph::Index;
+
+        ControlDependence() = default;
+        static ControlDependence build(const CSRGraph& graph, const DominatorTree& postDominators);
+
+        size_t nodeCount() const { return m_controllerOffsets.empty() ? 0 : m_controllerOffsets.size() - 1; }
+        size_t dependenceCount() const { return m_controllers.size(); }
+
+        // Blocks whose branch decides whether n runs, ascending.
+        llvm::ArrayRef<Index> controllers(Index n) const {
+            return llvm::ArrayRef<Index>(m_controllers).slice(m_controllerOffsets[n], m_controllerOffsets[n + 1] - m_controllerOffsets[n]);
+        }
+        // For each of controllers(n), the CSR edge out of it that leads to n.
+        llvm::ArrayRef<uint32_t> controllingEdges(Index n) const {
+            return llvm::ArrayRef<uint32_t>(m_controllingEdges).slice(m_controllerOffsets[n], m_controllerOffsets[n + 1] - m_controllerOffsets[n]);
+        }
+        // Blocks whose execution n's branch decides, ascending.
+        llvm::ArrayRef<Index> dependents(Index n) const {
+            return llvm::ArrayRef<Index>(m_dependents).slice(m_dependentOffsets[n], m_dependentOffsets[n + 1] - m_dependentOffsets[n]);
+        }
+
+    private:
+        std::vector<uint32_t> m_controllerOffsets;
+        std::vector<Index> m_controllers;
+        std::vector<uint32_t> m_controllingEdges;
+        std::vector<uint32_t> m_dependentOffsets;
+        std::vector<Index> m_dependents;
+    };
+
+    // (block ID, controlling block ID) for every dependence, in block ID
+    // order, as idomBlockPairs does for dominators.
+    std::vector<std::pair<int, int>> controlDependencePairs(const CSRGraph& graph, const ControlDependence& dependence);
+
+    using ControlDependenceTable = std::vector<std::pair<std::string, std::vector<std::pair<int, int>>>>;
+
+    // Binary table, in host byte order:
+    //   "CFGC", uint32 version, uint32 function count,
+    //   function count + 1 uint32 pair offsets,
+    //   pair count x 2 int32 (block ID, controlling block ID),
+    //   function count + 1 uint32 name offsets, then the concatenated names.
+    bool writeControlDependenceTable(const std::string& filename, const ControlDependenceTable& rows);
+    bool readControlDependenceTable(const std::string& filename, ControlDependenceTable& rows);
+
+} // namespace GraphGenerator
+
+#endif // CONTROL_DEPENDENCE_H
@@ -0,0 +1,412 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+#include <llvm/ADT/ArrayRef.h>
+#include "analysis_session.h"
+
+namespace clang {
+    class Stmt;
+    class VarDecl;
+}
+
+namespace GraphGenerator {
+
+    // One byte per edge, stored next to the CSR targets.
+    enum EdgeFlags : uint8_t {
+        EdgeNone        = 0,
+        EdgeException   = 1 << 0,
+        EdgeTrueBranch  = 1 << 1,
+        EdgeFalseBranch = 1 << 2,
+    };
+
+    // How a statement accesses a variable. Read-modify-write forms such as
+    // `x += 1` or `++x` are both a use and a definition.
+    enum class AccessKind { Read, Write, ReadWrite };
+
+    // Per-node attribute bits.
+    enum NodeAttributes : uint32_t {
+        NodeNone            = 0,
+        NodeTryBlock        = 1u << 0,
+        NodeThrowsException = 1u << 1,
+        NodeEntry           = 1u << 2,
+        NodeExit            = 1u << 3,
+    };
+
+    // Immutable control flow graph in compressed sparse row form.
+    //
+    // Nodes are addressed by a dense Index in [0, nodeCount()), ordered by
+    // block ID. The successors of node n are the targets in
+    // [edgeBegin(n), edgeEnd(n)), sorted by block ID, each with one flag byte.
+    // A reverse index with the same layout gives the predecessors.
+    // Labels and statements are indices into a string table, held either
+    // as string views or as an offsets array over one character blob (the
+    // form a CFGCorpus maps straight from disk).
+    // Graphs built from clang also carry a def-use index: the local
+    // variables their statements access, with the sites defining and using
+    // each one, kept as sorted CSR rows in both directions.
+    //
+    // All arrays are views into storage owned by a shared handle, so copies
+    // are cheap and a graph can be backed by session arena memory or by
+    // externally managed memory alike.
+    class CSRGraph {
+    public:
+        using Index = uint32_t;
+        static constexpr Index InvalidIndex = ~Index(0);
+
+        // Range of strings from the graph's string table.
+        class StringRange {
+        public:
+            class iterator {
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = std::string_view;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = std::string_view;
+
+                iterator(const CSRGraph* graph, const uint32_t* pos) : m_graph(graph), m_pos(pos) {}
+                std::string_view operator*() const { return m_graph->string(*m_pos); }
+                iterator& operator++() { ++m_pos; return *this; }
+                bool operator==(const iterator& other) const { return m_pos == other.m_pos; }
+                bool operator!=(const iterator& other) const { return m_pos != other.m_pos; }
+                difference_type operator-(const iterator& other) const { return m_pos - other.m_pos; }
+
+            private:
+                const CSRGraph* m_graph;
+                const uint32_t* m_pos;
+            };
+
+            StringRange(const CSRGraph* graph, llvm::ArrayRef<uint32_t> ids) : m_graph(graph), m_ids(ids) {}
+            iterator begin() const { return iterator(m_graph, m_ids.begin()); }
+            iterator end() const { return iterator(m_graph, m_ids.end()); }
+            size_t size() const { return m_ids.size(); }
+            bool empty() const { return m_ids.empty(); }
+            std::string_view operator[](size_t i) const { return m_graph->string(m_ids[i]); }
+
+        private:
+            const CSRGraph* m_graph;
+            llvm::ArrayRef<uint32_t> m_ids;
+        };
+
+        // Successors of a node, yielded as block IDs.
+        class IdRange {
+        public:
+            class iterator {
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = int;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = int;
+
+                iterator(const CSRGraph* graph, const Index* pos) : m_graph(graph), m_pos(pos) {}
+                int operator*() const { return m_graph->blockId(*m_pos); }
+                iterator& operator++() { ++m_pos; return *this; }
+                bool operator==(const iterator& other) const { return m_pos == other.m_pos; }
+                bool operator!=(const iterator& other) const { return m_pos != other.m_pos; }
+                difference_type operator-(const iterator& other) const { return m_pos - other.m_pos; }
+
+            private:
+                const CSRGraph* m_graph;
+                const Index* m_pos;
+            };
+
+            IdRange(const CSRGraph* graph, llvm::ArrayRef<Index> targets) : m_graph(graph), m_targets(targets) {}
+            iterator begin() const { return iterator(m_graph, m_targets.begin()); }
+            iterator end() const { return iterator(m_graph, m_targets.end()); }
+            size_t size() const { return m_targets.size(); }
+            bool empty() const { return m_targets.empty(); }
+
+        private:
+            const CSRGraph* m_graph;
+            llvm::ArrayRef<Index> m_targets;
+        };
+
+        // Same shape as the CFGNode values of CFGGraph::getNodes(), so
+        // existing loops of the form
+        //     for (const auto& [id, node] : graph.nodes())
+        // keep working on id, label, successors and statements.
+        struct NodeView {
+            int id;
+            Index index;
+            std::string_view label;
+            IdRange successors;
+            StringRange statements;
+            uint32_t attributes;
+        };
+
+        class NodeRange {
+        public:
+            class iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = std::pair<int, NodeView>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = value_type;
+
+                iterator(const CSRGraph* graph, Index index) : m_graph(graph), m_index(index) {}
+                value_type operator*() const { return {m_graph->blockId(m_index), m_graph->node(m_index)}; }
+                iterator& operator++() { ++m_index; return *this; }
+                bool operator==(const iterator& other) const { return m_index == other.m_index; }
+                bool operator!=(const iterator& other) const { return m_index != other.m_index; }
+
+            private:
+                const CSRGraph* m_graph;
+                Index m_index;
+            };
+
+            explicit NodeRange(const CSRGraph* graph) : m_graph(graph) {}
+            iterator begin() const { return iterator(m_graph, 0); }
+            iterator end() const { return iterator(m_graph, static_cast<Index>(m_graph->nodeCount())); }
+            size_t size() const { return m_graph->nodeCount(); }
+
+        private:
+            const CSRGraph* m_graph;
+        };
+
+        CSRGraph() = default;
+
+        size_t nodeCount() const { return m_ids.size(); }
+        size_t edgeCount() const { return m_targets.size(); }
+        bool empty() const { return m_ids.empty(); }
+
+        Index entry() const { return m_entry; }
+        Index exit() const { return m_exit; }
+
+        int blockId(Index n) const { return m_ids[n]; }
+        Index indexOf(int blockId) const;
+        llvm::ArrayRef<int> blockIds() const { return m_ids; }
+
+        // Forward adjacency.
+        uint32_t edgeBegin(Index n) const { return m_offsets[n]; }
+        uint32_t edgeEnd(Index n) const { return m_offsets[n + 1]; }
+        Index edgeTarget(uint32_t edge) const { return m_targets[edge]; }
+        uint8_t edgeFlags(uint32_t edge) const { return m_edgeFlags[edge]; }
+        llvm::ArrayRef<Index> successors(Index n) const { return m_targets.slice(edgeBegin(n), edgeEnd(n) - edgeBegin(n)); }
+        llvm::ArrayRef<uint8_t> successorFlags(Index n) const { return m_edgeFlags.slice(edgeBegin(n), edgeEnd(n) - edgeBegin(n)); }
+        size_t outDegree(Index n) const { return edgeEnd(n) - edgeBegin(n); }
+        uint32_t findEdge(Index from, Index to) const;  // InvalidIndex if absent
+
+        // Reverse adjacency. predecessors(n) is sorted by index and
+        // predecessorEdges(n) holds the forward edge of each entry, so the
+        // flags of an incoming edge are edgeFlags(predecessorEdges(n)[i]).
+        llvm::ArrayRef<Index> predecessors(Index n) const {
+            return m_predSources.slice(m_predOffsets[n], m_predOffsets[n + 1] - m_predOffsets[n]);
+        }
+        llvm::ArrayRef<uint32_t> predecessorEdges(Index n) const {
+            return m_predEdges.slice(m_predOffsets[n], m_predOffsets[n + 1] - m_predOffsets[n]);
+        }
+        size_t inDegree(Index n) const { return m_predOffsets[n + 1] - m_predOffsets[n]; }
+
+        // Node attributes and text.
+        uint32_t attributes(Index n) const { return m_attributes[n]; }
+        bool hasAttribute(Index n, NodeAttributes attr) const { return (m_attributes[n] & attr) != 0; }
+        std::string_view label(Index n) const { return string(m_labels[n]); }
+        StringRange statements(Index n) const { return StringRange(this, statementIds(n)); }
+        llvm::ArrayRef<uint32_t> statementIds(Index n) const {
+            return m_stmtStrings.slice(m_stmtOffsets[n], m_stmtOffsets[n + 1] - m_stmtOffsets[n]);
+        }
+        // AST handles parallel to statements(n); empty when the graph was
+        // not built from a clang::CFG (e.g. parsed from DOT).
+        llvm::ArrayRef<const clang::Stmt*> statementHandles(Index n) const;
+        const clang::Stmt* terminator(Index n) const { return m_terminators.empty() ? nullptr : m_terminators[n]; }
+
+        // A variable access: the block and the position of the element in
+        // statements(block). Rows are sorted by block, then element.
+        struct VariableSite {
+            Index block;
+            uint32_t element;
+
+            bool operator<(const VariableSite& other) const {
+                return block != other.block ? block < other.block : element < other.element;
+            }
+            bool operator==(const VariableSite& other) const {
+                return block == other.block && element == other.element;
+            }
+        };
+
+        size_t variableCount() const { return m_varNames.size(); }
+        std::string_view variableName(uint32_t v) const { return string(m_varNames[v]); }
+        // Null for graphs without AST handles.
+        const clang::VarDecl* variableDecl(uint32_t v) const { return m_varDecls.empty() ? nullptr : m_varDecls[v]; }
+        uint32_t findVariable(const clang::VarDecl* decl) const;  // InvalidIndex if absent
+        std::vector<uint32_t> findVariables(std::string_view name) const;  // shadowed names give several
+        llvm::ArrayRef<VariableSite> definitions(uint32_t v) const {
+            return m_defSites.slice(m_defOffsets[v], m_defOffsets[v + 1] - m_defOffsets[v]);
+        }
+        llvm::ArrayRef<VariableSite> uses(uint32_t v) const {
+            return m_useSites.slice(m_useOffsets[v], m_useOffsets[v + 1] - m_useOffsets[v]);
+        }
+        // Variables defined or used anywhere in block n, ascending.
+        llvm::ArrayRef<uint32_t> variablesDefinedIn(Index n) const;
+        llvm::ArrayRef<uint32_t> variablesUsedIn(Index n) const;
+
+        // String table.
+        size_t stringCount() const { return m_stringOffsets.empty() ? m_strings.size() : m_stringOffsets.size() - 1; }
+        std::string_view string(uint32_t id) const {
+            if (m_stringOffsets.empty()) return m_strings[id];
+            return std::string_view(m_stringData.data() + m_stringOffsets[id], m_stringOffsets[id + 1] - m_stringOffsets[id]);
+        }
+
+        NodeView node(Index n) const {
+            return NodeView{blockId(n), n, label(n), IdRange(this, successors(n)), statements(n), attributes(n)};
+        }
+        NodeRange nodes() const { return NodeRange(this); }
+
+        // Block-ID based queries mirroring CFGGraph.
+        bool isExceptionEdge(int sourceID, int targetID) const;
+        bool isNodeTryBlock(int nodeID) const;
+        bool isNodeThrowingException(int nodeID) const;
+
+    private:
+        friend class CSRGraphBuilder;
+        friend class CorpusCodec;
+
+        std::shared_ptr<const void> m_storage;  // owns the memory behind every view below
+        llvm::ArrayRef<int> m_ids;
+        llvm::ArrayRef<uint32_t> m_offsets;
+        llvm::ArrayRef<Index> m_targets;
+        llvm::ArrayRef<uint8_t> m_edgeFlags;
+        llvm::ArrayRef<uint32_t> m_predOffsets;
+        llvm::ArrayRef<Index> m_predSources;
+        llvm::ArrayRef<uint32_t> m_predEdges;
+        llvm::ArrayRef<uint32_t> m_attributes;
+        llvm::ArrayRef<uint32_t> m_labels;
+        llvm::ArrayRef<uint32_t> m_stmtOffsets;
+        llvm::ArrayRef<uint32_t> m_stmtStrings;
+        llvm::ArrayRef<const clang::Stmt*> m_stmtHandles;
+        llvm::ArrayRef<const clang::Stmt*> m_terminators;
+        llvm::ArrayRef<std::string_view> m_strings;
+        llvm::ArrayRef<uint32_t> m_stringOffsets;  // used instead of m_strings when not empty
+        llvm::ArrayRef<char> m_stringData;
+        llvm::ArrayRef<uint32_t> m_varNames;
+        llvm::ArrayRef<const clang::VarDecl*> m_varDecls;
+        llvm::ArrayRef<uint32_t> m_varsByDecl;  // variable IDs sorted by decl pointer
+        llvm::ArrayRef<uint32_t> m_defOffsets;
+        llvm::ArrayRef<VariableSite> m_defSites;
+        llvm::ArrayRef<uint32_t> m_useOffsets;
+        llvm::ArrayRef<VariableSite> m_useSites;
+        llvm::ArrayRef<uint32_t> m_blockDefOffsets;
+        llvm::ArrayRef<uint32_t> m_blockDefVars;
+        llvm::ArrayRef<uint32_t> m_blockUseOffsets;
+        llvm::ArrayRef<uint32_t> m_blockUseVars;
+        Index m_entry = InvalidIndex;
+        Index m_exit = InvalidIndex;
+        bool m_denseIds = true;
+    };
+
+    // The graph with every edge reversed, as a view over a CSRGraph: no
+    // adjacency is copied, successors and predecessors simply trade places
+    // and entry and exit swap. Algorithms written against the common
+    // interface (nodeCount, entry, exit, successors, predecessors, blockId)
+    // run backwards when given this view, e.g. post-dominators are the
+    // dominators of the reversed graph.
+    class ReversedGraph {
+    public:
+        using Index = CSRGraph::Index;
+
+        explicit ReversedGraph(const CSRGraph& graph) : m_graph(&graph) {}
+
+        size_t nodeCount() const { return m_graph->nodeCount(); }
+        size_t edgeCount() const { return m_graph->edgeCount(); }
+        Index entry() const { return m_graph->exit(); }
+        Index exit() const { return m_graph->entry(); }
+        int blockId(Index n) const { return m_graph->blockId(n); }
+        llvm::ArrayRef<Index> successors(Index n) const { return m_graph->predecessors(n); }
+        llvm::ArrayRef<Index> predecessors(Index n) const { return m_graph->successors(n); }
+        size_t outDegree(Index n) const { return m_graph->inDegree(n); }
+        size_t inDegree(Index n) const { return m_graph->outDegree(n); }
+        const CSRGraph& base() const { return *m_graph; }
+
+    private:
+        const CSRGraph* m_graph;
+    };
+
+    // Mutable staging area for a CSRGraph. Nodes, edges and statements may
+    // be added in any order; freeze() sorts them by block ID, merges
+    // duplicate edges (OR-ing their flags) and packs everything into
+    // contiguous arrays. Nodes referenced only by edges are created with a
+    // default label.
+    //
+    // Text is interned in the session's string pool as it is added and the
+    // frozen arrays are allocated from the session arena; staging itself
+    // uses the heap and is released by freeze(). Without a session the
+    // builder creates a private one that the resulting graph owns.
+    class CSRGraphBuilder {
+    public:
+        explicit CSRGraphBuilder(std::shared_ptr<AnalysisSession> session = nullptr);
+
+        void reserve(size_t nodes, size_t edges, size_t statements);
+
+        void addNode(int id, std::string_view label = {});
+        void addEdge(int fromID, int toID, uint8_t flags = EdgeNone);
+        void addStatement(int nodeID, std::string_view text, const clang::Stmt* handle = nullptr);
+        void setTerminator(int nodeID, const clang::Stmt* terminator);
+        void addAttributes(int nodeID, uint32_t attributes);
+        void setEntry(int nodeID);
+        void setExit(int nodeID);
+        // Records that element `element` of the node accesses a variable.
+        // Variables are told apart by decl when one is given, otherwise
+        // by name.
+        void addVariableAccess(int nodeID, uint32_t element, std::string_view name,
+                               const clang::VarDecl* decl, AccessKind kind);
+
+        // Packs the staged graph. The builder is empty afterwards and keeps
+        // using the same session.
+        CSRGraph freeze();
+
+    private:
+        struct PendingEdge {
+            uint32_t from;
+            uint32_t to;
+            uint8_t flags;
+        };
+        struct PendingStatement {
+            uint32_t node;
+            uint32_t text;
+            const clang::Stmt* handle;
+        };
+        struct PendingAccess {
+            uint32_t node;
+            uint32_t element;
+            uint32_t variable;
+            AccessKind kind;
+        };
+
+        uint32_t slotFor(int id);
+        uint32_t appendString(std::string_view text);
+
+        std::vector<int> m_ids;                    // slot -> block ID
+        std::vector<uint32_t> m_labels;            // slot -> string, or ~0u for the default label
+        std::vector<uint32_t> m_attributes;        // slot -> NodeAttributes
+        std::vector<const clang::Stmt*> m_terminators;
+        std::unordered_map<int, uint32_t> m_slots; // block ID -> slot
+        std::vector<PendingEdge> m_edges;
+        std::vector<PendingStatement> m_statements;
+        std::shared_ptr<AnalysisSession> m_session;
+        std::vector<std::string_view> m_strings;              // interned, by string ID
+        std::unordered_map<const char*, uint32_t> m_stringIds; // interned data() -> string ID
+        std::vector<PendingAccess> m_accesses;
+        std::vector<uint32_t> m_varNames;                      // variable -> string ID
+        std::vector<const clang::VarDecl*> m_varDecls;
+        std::unordered_map<const void*, uint32_t> m_varIds;    // decl, or interned name -> variable
+        bool m_hasHandles = false;
+        bool m_hasTerminators = false;
+        int m_entryID = 0;
+        int m_exitID = 0;
+        bool m_hasEntry = false;
+        bool m_hasExit = false;
+    };
+
+} // namespace GraphGenerator
+
+#endif // CSR_GRAPH_H
@@ -9,8 +9,17 @@
 >>>>>>> e4e3a1ee3e7575d1f091a453a24f18f29459330b
 #include <QGraphicsTextItem>
 #include <QMap>
+#include <QSet>
+#include <QHash>
+#include <QStringList>
 #include <QJsonObject>
 #include <string>
+#include <memory>
+#include "reachability.h"
+#include "graph_slice.h"
+#include "control_dependence.h"
+#include "program_structure.h"
+#include "block_frequency.h"
 
 <<<<<<< HEAD
 // Define the LayoutAlgorithm enum
@@ -48,7 +57,50 @@ public:
     
     // Visualization features
     bool parseDotFormat(const QString& dotContent);
+    // Shows a graph already in memory, such as one mapped from a CFG
+    // corpus: large ones go to the region view without a DOT round trip,
+    // the rest are drawn as their DOT export would be.
+    bool showGraph(std::shared_ptr<const GraphGenerator::CSRGraph> graph);
     void highlightFunction(const QString& functionName);
+    // Colours the blocks defining (orange) and using (green) a variable,
+    // from the defs/uses node attributes. False if no block mentions it.
+    bool highlightVariable(const QString& variable);
+    bool hasVariable(const QString& variable) const;
+    // Colours every block on some path from one block to the other and
+    // thickens the edges between them. False if there is no such path.
+    bool highlightBetween(const QString& from, const QString& to);
+    // Control dependence overlay (Ctrl+click): the blocks whose branch
+    // decides whether this one runs in gold, the blocks its own branch
+    // decides in light cyan. False if it has neither.
+    bool highlightControlDependence(const QString& block);
+
+    // Graphs with more blocks than CollapseThreshold are kept as a
+    // CSRGraph and only part of them becomes scene items. They open as
+    // their program structure tree: top-level single-entry/single-exit
+    // regions drawn as boxes, each expanding in place when clicked.
+    // Right-clicking a block instead shows a slice around it, and the "+n"
+    // marker on a slice's boundary block expands its hidden neighbours.
+    // A region view of more than SliceThreshold items starts as a slice.
+    enum class SliceKind { Neighborhood, Loop, DominatorRegion, PathsToExit, PathsFromEntry };
+    static constexpr int CollapseThreshold = 300;
+    static constexpr int SliceThreshold = 2000;
+    static constexpr unsigned SliceHops = 3;
+    static constexpr uint32_t RegionFanout = 20;
+    bool isSliced() const { return m_sliceGraph != nullptr; }
+    // Blocks tagged unreachable="true" are drawn faded; this hides them
+    // and their edges instead. Also offered by right-clicking the background.
+    void setUnreachableHidden(bool hidden);
+    // Fills blocks by their estimated execution frequency (the freq node
+    // attribute) from pale yellow to dark red. Also offered by
+    // right-clicking the background.
+    void setHeatMapEnabled(bool enabled);
+    bool showSlice(SliceKind kind, int blockId);
+    bool expandSlice(int blockId);
+    // Region view: back to the top-level regions, or one level more or
+    // less of a region (a preorder index of m_sliceRegions).
+    bool showRegions();
+    bool expandRegion(uint32_t region);
+    bool collapseRegion(uint32_t region);
     void addFunctionCallHierarchy(const QJsonObject& functionCalls);
     void parsePlainFormat(const QString& plainOutput);
     void parseJson(const QByteArray &jsonData);
@@ -87,6 +139,33 @@ private:
     QGraphicsScene* m_scene;
     QMap<QString, QGraphicsEllipseItem*> m_nodes;
     QList<QPair<QString, QString>> m_edges;
+    QSet<QPair<QString, QString>> m_backEdges;  // edges marked constraint=false, ignored by layering
+    QHash<QString, QSet<QString>> m_variableDefs;  // variable -> IDs of blocks defining it
+    QHash<QString, QSet<QString>> m_variableUses;  // variable -> IDs of blocks using it
+    QHash<QString, QStringList> m_nodeVariables;   // block ID -> variables it accesses
+    QHash<QString, QStringList> m_controllers;     // block ID -> cdeps entries ("5:T")
+    // Reachability over the displayed graph, rebuilt when edges were added
+    std::unique_ptr<GraphGenerator::ReachabilityIndex> m_reachability;
+    QHash<QString, int> m_reachabilityIndexOf;
+    QStringList m_reachabilityIds;
+    int m_reachabilityEdgeCount = 0;
+    QString m_pathSource;  // first block of a shift-click pair
+    // Slice mode: the whole graph, and the part of it in the scene
+    std::shared_ptr<const GraphGenerator::CSRGraph> m_sliceGraph;
+    std::unique_ptr<GraphGenerator::LoopForest> m_sliceLoops;
+    std::unique_ptr<GraphGenerator::DominatorTree> m_sliceDominators;  // built on first use
+    GraphGenerator::GraphSlice m_slice;
+    std::vector<GraphGenerator::CSRGraph::Index> m_sliceUnreachable;
+    GraphGenerator::ControlDependence m_sliceControlDependence;
+    std::unique_ptr<GraphGenerator::ProgramStructureTree> m_sliceRegions;
+    std::vector<char> m_expandedRegions;  // per region, while m_regionView
+    bool m_regionView = false;
+    QSet<QString> m_unreachableNodes;
+    bool m_hideUnreachable = false;
+    std::vector<double> m_sliceFrequencies;        // per block of m_sliceGraph
+    QHash<QString, double> m_blockFrequencies;     // block ID -> freq attribute
+    double m_maxFrequency = 0;
+    bool m_heatMap = false;
     QMap<QString, int> m_nodeLevels;
     double m_zoomFactor;
     bool m_panning;
@@ -100,8 +179,19 @@ private:
 
     // Private helper methods
     void calculateLevels();  // Removed duplicate declaration
+    void ensureReachabilityIndex();
+    bool openCollapsed(std::shared_ptr<const GraphGenerator::CSRGraph> graph);
+    void syncSliceItems();
+    void syncRegionItems();
+    void pruneSliceItems(const QSet<QString>& visible);
+    void createSliceBlockItem(GraphGenerator::CSRGraph::Index n);
+    void createRegionItem(uint32_t region);
+    uint32_t regionOfItem(const QString& id) const;  // NoRegion unless a region box
+    void removeNodeItem(const QString& id);
+    void updateEdgeGeometry();
     void createNodeFromDot(int id, const QString& label, const QMap<QString, QString>& attributes);
     void createEdgeFromDot(int source, int target, const QMap<QString, QString>& attributes);
+    void createEdgeFromDot(const QString& source, const QString& target, const QMap<QString, QString>& attributes);
 =======
 
     void addNode(const std::string& id, const std::string& label);
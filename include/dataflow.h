@@ -0,0 +1,108 @@
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <llvm/ADT/SparseBitVector.h>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    // Fixed-width rows of bits stored in one contiguous uint64_t array, one
+    // row per graph node. Row operations are plain word loops the compiler
+    // vectorizes.
+    class BitMatrix {
+    public:
+        BitMatrix() = default;
+        BitMatrix(size_t rows, size_t bits)
+            : m_words((bits + 63) / 64), m_data(rows * m_words, 0) {}
+
+        size_t words() const { return m_words; }
+        uint64_t* row(size_t r) { return m_data.data() + r * m_words; }
+        const uint64_t* row(size_t r) const { return m_data.data() + r * m_words; }
+
+        bool test(size_t r, uint32_t bit) const { return (row(r)[bit / 64] >> (bit % 64)) & 1; }
+        void set(size_t r, uint32_t bit) { row(r)[bit / 64] |= uint64_t(1) << (bit % 64); }
+        size_t count(size_t r) const;
+
+    private:
+        size_t m_words = 0;
+        std::vector<uint64_t> m_data;
+    };
+
+    // Per-node fact sets produced by the solver, dense or sparse depending on
+    // the domain width.
+    class DataflowSets {
+    public:
+        bool isSparse() const { return m_isSparse; }
+        bool test(CSRGraph::Index n, uint32_t bit) const {
+            return m_isSparse ? m_sparse[n].test(bit) : m_dense.test(n, bit);
+        }
+        size_t count(CSRGraph::Index n) const {
+            return m_isSparse ? m_sparse[n].count() : m_dense.count(n);
+        }
+        // Calls fn(bit) for every set bit of node n, ascending.
+        template <typename Fn>
+        void forEach(CSRGraph::Index n, Fn&& fn) const {
+            if (m_isSparse) {
+                for (unsigned bit : m_sparse[n]) fn(static_cast<uint32_t>(bit));
+                return;
+            }
+            const uint64_t* words = m_dense.row(n);
+            for (size_t w = 0; w < m_dense.words(); ++w) {
+                for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+                    fn(static_cast<uint32_t>(w * 64 + __builtin_ctzll(bits)));
+                }
+            }
+        }
+
+    private:
+        friend class DataflowEngine;
+
+        bool m_isSparse = false;
+        BitMatrix m_dense;
+        std::vector<llvm::SparseBitVector<>> m_sparse;
+    };
+
+    enum class DataflowDirection { Forward, Backward };
+    enum class DataflowMeet { Union, Intersection };
+
+    // A gen/kill problem over facts numbered [0, domainSize). The transfer
+    // function of node n is out = gen(n) | (in & ~kill(n)); in is the meet
+    // of the neighbours' out sets, or `boundary` for the start node (entry
+    // for forward problems, exit for backward ones) and nodes without
+    // incoming edges.
+    struct GenKillProblem {
+        uint32_t domainSize = 0;
+        DataflowDirection direction = DataflowDirection::Forward;
+        DataflowMeet meet = DataflowMeet::Union;
+        std::vector<std::pair<CSRGraph::Index, uint32_t>> gen;   // (node, fact)
+        std::vector<std::pair<CSRGraph::Index, uint32_t>> kill;  // (node, fact)
+        // Kills by class: each (node, class) pair of killClasses kills every
+        // fact f with factClass[f] == class, so a node killing all facts of
+        // a variable needs one pair rather than one per fact.
+        std::vector<uint32_t> factClass;
+        std::vector<std::pair<CSRGraph::Index, uint32_t>> killClasses;  // (node, class)
+        std::vector<uint32_t> boundary;
+    };
+
+    struct DataflowResult {
+        DataflowSets in;   // facts on entry to each block, in program order
+        DataflowSets out;  // facts on exit from each block, in program order
+        size_t evaluations = 0;  // transfer function applications
+    };
+
+    // Above this many bits per set matrix the solver switches from dense
+    // rows to llvm::SparseBitVector.
+    constexpr size_t DenseDataflowBitLimit = size_t(1) << 28;  // 32 MiB per matrix
+
+    // Solves the problem to its fixed point with a worklist ordered by
+    // reverse post-order of the direction of flow, so acyclic regions settle
+    // in one pass. Backward problems run forward on the ReversedGraph view
+    // and have in/out mapped back to program order.
+    DataflowResult solveDataflow(const CSRGraph& graph, const GenKillProblem& problem);
+
+} // namespace GraphGenerator
+
+#endif // DATAFLOW_H
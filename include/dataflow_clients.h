@@ -0,0 +1,84 @@
+#ifndef DATAFLOW_CLIENTS_H
+#define DATAFLOW_CLIENTS_H
+
+#include <cstdint>
+#include <vector>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include "csr_graph.h"
+#include "dataflow.h"
+
+namespace clang {
+    class Stmt;
+    class VarDecl;
+}
+
+namespace GraphGenerator {
+
+    using VarAccessCallback =
+        llvm::function_ref<void(CSRGraph::Index block, const clang::VarDecl* var, AccessKind kind, const clang::Stmt* element)>;
+
+    // Walks one CFG element at a time and reports its variable accesses.
+    // `elements` is every statement of the function's CFG; children found
+    // in it are skipped, as they are walked with their own block.
+    class VarAccessWalker {
+    public:
+        VarAccessWalker(const llvm::DenseSet<const clang::Stmt*>& elements, VarAccessCallback fn)
+            : m_elements(elements), m_fn(fn) {}
+
+        void walk(CSRGraph::Index block, const clang::Stmt* element);
+
+    private:
+        void visit(const clang::Stmt* S, AccessKind context);
+        void visitChild(const clang::Stmt* S, AccessKind context);
+
+        const llvm::DenseSet<const clang::Stmt*>& m_elements;
+        VarAccessCallback m_fn;
+        CSRGraph::Index m_block = 0;
+        const clang::Stmt* m_element = nullptr;
+    };
+
+    // Reports every read and write of a local variable or parameter in the
+    // graph's statement handles, block by block and in evaluation order
+    // within a block. Subexpressions that clang also lists as CFG elements
+    // of their own (operands split off by short-circuit and conditional
+    // operators) are reported with those elements only. Writes are tracked
+    // on plain variables: a declaration and `x = ...` write x, `x += ...`, `++x` and `&x`
+    // read and write it, and stores through members, subscripts, pointers
+    // or references count as reads of the base variable.
+    void forEachVarAccess(const CSRGraph& graph, VarAccessCallback fn);
+
+    // Backward may-liveness over the variables accessed in the graph.
+    // sets.in(n) holds the variables live on entry to block n, sets.out(n)
+    // those live on exit; bit i is variables[i].
+    struct LivenessResult {
+        std::vector<const clang::VarDecl*> variables;
+        llvm::DenseMap<const clang::VarDecl*, uint32_t> variableIndex;
+        DataflowResult sets;
+
+        bool isLiveIn(CSRGraph::Index n, const clang::VarDecl* var) const;
+        bool isLiveOut(CSRGraph::Index n, const clang::VarDecl* var) const;
+    };
+
+    LivenessResult computeLiveness(const CSRGraph& graph);
+
+    // Forward reaching definitions. Every write reported by
+    // forEachVarAccess is one definition; a block kills all definitions of
+    // the variables it writes and generates the last one of each.
+    struct Definition {
+        const clang::VarDecl* var;
+        const clang::Stmt* element;
+        CSRGraph::Index block;
+    };
+
+    struct ReachingDefinitionsResult {
+        std::vector<Definition> definitions;  // bit i is definitions[i], grouped by block
+        DataflowResult sets;
+    };
+
+    ReachingDefinitionsResult computeReachingDefinitions(const CSRGraph& graph);
+
+} // namespace GraphGenerator
+
+#endif // DATAFLOW_CLIENTS_H
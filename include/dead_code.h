@@ -0,0 +1,45 @@
+#ifndef DEAD_CODE_H
+#define DEAD_CODE_H
+
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    // Blocks no path from the entry reaches, ascending. One DFS; every
+    // block counts as reachable when the graph has no entry.
+    std::vector<CSRGraph::Index> unreachableBlocks(const CSRGraph& graph);
+
+    // Which functions count as live without being called.
+    struct CallGraphRoots {
+        // Names matched in full; '*' stands for any run of characters.
+        // The defaults cover main and common test entry points.
+        std::vector<std::string> patterns = {"main", "test*", "Test*", "*::TestBody"};
+        // Externally visible definitions may be called from other
+        // translation units. While this is set only internal-linkage
+        // functions (static, in an anonymous namespace) can be reported
+        // dead; clear it when the file is the whole program.
+        bool exported = true;
+    };
+
+    bool matchesRootPattern(std::string_view name, std::string_view pattern);
+
+    // Functions defined in `calls` (its keys, caller -> callees) that no
+    // root reaches, sorted. Roots are the functions matching a pattern,
+    // those in `exported` when roots.exported is set, and those in
+    // `indirect` (virtual or address-taken), which may be reached without
+    // a direct call. Linear in the size of the call graph.
+    std::vector<std::string> findDeadFunctions(
+        const std::unordered_map<std::string, std::set<std::string>>& calls,
+        const CallGraphRoots& roots,
+        const std::unordered_set<std::string>& exported,
+        const std::unordered_set<std::string>& indirect);
+
+} // namespace GraphGenerator
+
+#endif // DEAD_CODE_H
@@ -0,0 +1,84 @@
+#ifndef DOMINATORS_H
+#define DOMINATORS_H
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    // Dominator tree of a CSRGraph, rooted at its entry (or, when built from
+    // a ReversedGraph, the post-dominator tree rooted at the exit).
+    //
+    // Computed with Semi-NCA in O(E log V). The tree is kept as an idom
+    // array plus child lists; each node also carries its DFS interval in the
+    // tree, which makes dominates() a constant-time comparison. Nodes not
+    // reachable from the root have no idom and dominate nothing.
+    class DominatorTree {
+    public:
+        using Index = CSRGraph::Index;
+
+        DominatorTree() = default;
+
+        static DominatorTree build(const CSRGraph& graph);
+        static DominatorTree build(const ReversedGraph& graph);
+
+        size_t nodeCount() const { return m_idom.size(); }
+        Index root() const { return m_root; }
+        bool isReachable(Index n) const { return n == m_root || m_idom[n] != CSRGraph::InvalidIndex; }
+
+        // Immediate dominator, InvalidIndex for the root and unreachable nodes.
+        Index idom(Index n) const { return m_idom[n]; }
+        llvm::ArrayRef<Index> idoms() const { return m_idom; }
+        llvm::ArrayRef<Index> children(Index n) const {
+            return llvm::ArrayRef<Index>(m_children).slice(m_childOffsets[n], m_childOffsets[n + 1] - m_childOffsets[n]);
+        }
+        uint32_t depth(Index n) const { return m_depth[n]; }
+
+        // Does a dominate b? Every reachable node dominates itself.
+        bool dominates(Index a, Index b) const {
+            return isReachable(a) && isReachable(b) &&
+                   m_tin[a] <= m_tin[b] && m_tout[b] <= m_tout[a];
+        }
+        bool strictlyDominates(Index a, Index b) const { return a != b && dominates(a, b); }
+
+        // Deepest node dominating both a and b, InvalidIndex if either is
+        // unreachable. O(depth).
+        Index nearestCommonDominator(Index a, Index b) const;
+
+    private:
+        template <typename GraphT>
+        static DominatorTree compute(const GraphT& graph);
+        void buildTreeIndex();
+
+        Index m_root = CSRGraph::InvalidIndex;
+        std::vector<Index> m_idom;
+        std::vector<uint32_t> m_childOffsets;
+        std::vector<Index> m_children;
+        std::vector<uint32_t> m_tin;
+        std::vector<uint32_t> m_tout;
+        std::vector<uint32_t> m_depth;
+    };
+
+    struct FunctionDominators {
+        DominatorTree dominators;
+        DominatorTree postDominators;
+    };
+
+    // Dominator and post-dominator trees for every graph, computed on up to
+    // `threads` threads (hardware concurrency when 0). Null entries yield
+    // empty trees.
+    std::vector<FunctionDominators> computeDominatorsBatch(
+        llvm::ArrayRef<std::shared_ptr<const CSRGraph>> graphs, unsigned threads = 0);
+
+    // (block ID, immediate dominator block ID) for every node with an idom,
+    // in block ID order. Used where results leave the process, e.g. the
+    // cache manifest.
+    std::vector<std::pair<int, int>> idomBlockPairs(const CSRGraph& graph, const DominatorTree& tree);
+
+} // namespace GraphGenerator
+
+#endif // DOMINATORS_H
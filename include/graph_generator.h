@@ -6,6 +6,7 @@
 =======
 >>>>>>> e4e3a1ee3e7575d1f091a453a24f18f29459330b
 #include <set>
+#include <cstdint>
 #include <utility>
 #include <memory>
 #include <string>
@@ -14,7 +15,9 @@
 #include <clang/AST/Stmt.h>
 #include <clang/Analysis/CFG.h>
 #include <clang/AST/Decl.h>
+#include <llvm/ADT/ArrayRef.h>
 #include <nlohmann/json.hpp>
+#include "csr_graph.h"
 
 namespace GraphGenerator {
     using json = nlohmann::json;
@@ -22,9 +25,43 @@ namespace GraphGenerator {
     // Forward declaration of the CFGGraph class
     class CFGGraph;
 
+    // Contiguous copy of a clang::CFG. clang numbers blocks densely from 0
+    // to getNumBlockIDs() - 1, so block IDs index the offset arrays directly:
+    // the successors of block b are succTargets[succOffsets[b], succOffsets[b + 1])
+    // and its statements are stmts[stmtOffsets[b], stmtOffsets[b + 1]).
+    // Statement handles point into the ASTContext and stay valid as long as it does.
+    struct FlatCFG {
+        uint32_t numBlocks = 0;
+        uint32_t entryID = 0;
+        uint32_t exitID = 0;
+        std::vector<uint32_t> succOffsets;
+        std::vector<uint32_t> succTargets;
+        std::vector<uint32_t> stmtOffsets;
+        std::vector<const clang::Stmt*> stmts;
+        std::vector<const clang::Stmt*> terminators;  // one per block, may be null
+        std::vector<uint8_t> succFlags;               // EdgeFlags, parallel to succTargets
+
+        llvm::ArrayRef<uint32_t> successors(uint32_t blockID) const {
+            return llvm::ArrayRef<uint32_t>(succTargets).slice(
+                succOffsets[blockID], succOffsets[blockID + 1] - succOffsets[blockID]);
+        }
+
+        llvm::ArrayRef<const clang::Stmt*> blockStmts(uint32_t blockID) const {
+            return llvm::ArrayRef<const clang::Stmt*>(stmts).slice(
+                stmtOffsets[blockID], stmtOffsets[blockID + 1] - stmtOffsets[blockID]);
+        }
+    };
+
+    // Converts a clang::CFG into FlatCFG in a single pass over its blocks.
+    FlatCFG flattenCFG(const clang::CFG& cfg);
+
     // Use the forward declaration for the function signatures
     std::unique_ptr<CFGGraph> generateCFG(const std::vector<std::string>& sourceFiles);
     std::unique_ptr<CFGGraph> generateCFG(const clang::FunctionDecl* FD);
+    // Builds the CSR snapshot straight from the flattened clang::CFG, with
+    // all graph and label memory taken from session (a private session if
+    // null). The returned graph only builds its std::map form on demand.
+    std::unique_ptr<CFGGraph> generateCFG(const clang::FunctionDecl* FD, std::shared_ptr<AnalysisSession> session);
     std::unique_ptr<CFGGraph> generateCustomCFG(const clang::FunctionDecl* FD);
 <<<<<<< HEAD
     std::unique_ptr<CFGGraph> generateCFG(const Parser::FunctionInfo& functionInfo, clang::ASTContext* context);
@@ -32,6 +69,11 @@ namespace GraphGenerator {
 >>>>>>> e4e3a1ee3e7575d1f091a453a24f18f29459330b
     std::string getStmtString(const clang::Stmt* S);
 
+    // Structural hash of a function's signature and body. Stable across runs
+    // and insensitive to source locations, so it can be used to detect that
+    // a definition is unchanged since the previous analysis.
+    uint64_t computeBodyFingerprint(const clang::FunctionDecl* FD);
+
     // Typedef for Graph if needed
     using Graph = CFGGraph;
 
@@ -70,9 +112,20 @@ namespace GraphGenerator {
 
     class CFGGraph {
     public:
+        CFGGraph() = default;
+
+        // Wraps a snapshot built directly with CSRGraphBuilder. Readers and
+        // exporters work from the snapshot; the node map is materialized
+        // from it only when getNodes() or a mutator needs it.
+        explicit CFGGraph(std::shared_ptr<const CSRGraph> snapshot);
+
         // Methods remain the same
         void writeToDotFile(const std::string& filename) const;
-        void writeToJsonFile(const std::string& filename, const json& astJson, const json& functionCallJson);
+        // Streams nodes, edges and the given AST and call JSON to the file
+        // without building a document; pretty output is laid out as
+        // json::dump(4) would, compact output as json::dump().
+        void writeToJsonFile(const std::string& filename, const json& astJson, const json& functionCallJson,
+                             bool pretty = true);
         std::string getNodeLabel(int nodeID) const;
 
         // New methods for exception handling
@@ -84,6 +137,22 @@ namespace GraphGenerator {
         bool isNodeTryBlock(int nodeID) const;
         bool isNodeThrowingException(int nodeID) const;
 
+        // Branch direction of a two-way conditional edge.
+        void markBranchEdge(int sourceID, int targetID, bool isTrueBranch);
+        void setEntryNode(int nodeID);
+        void setExitNode(int nodeID);
+
+        // Immutable CSR snapshot of the current graph. Built on first use and
+        // cached until the next mutation, so repeated traversals and exports
+        // share one packed copy. Not synchronized: do not mutate the graph
+        // while another thread is freezing or reading it.
+        std::shared_ptr<const CSRGraph> freeze() const;
+
+        // Block IDs of the predecessors of nodeID, ascending. Served from the
+        // reverse index of the frozen snapshot.
+        std::vector<int> predecessors(int nodeID) const;
+        size_t inDegree(int nodeID) const;
+
 <<<<<<< HEAD
         void addNode(int id, const std::string& label);
         size_t getNodeCount() const;
@@ -92,6 +161,7 @@ namespace GraphGenerator {
         // Get function names
         std::vector<std::string> getFunctionNames() const {
             std::vector<std::string> names;
+            materialize();
             for (const auto& pair : nodes) {
                 if (!pair.second.functionName.empty()) {
                     names.push_back(pair.second.functionName);
@@ -104,12 +174,14 @@ namespace GraphGenerator {
 >>>>>>> e4e3a1ee3e7575d1f091a453a24f18f29459330b
         // Existing methods remain the same
         void addNode(int nodeID) {
+            invalidate();
             if (nodes.find(nodeID) == nodes.end()) {
                 nodes[nodeID] = CFGNode(nodeID, "Block " + std::to_string(nodeID));
             }
         }
         
         void addStatementToNode(int nodeID, const std::string& stmt) {
+            invalidate();
             if (nodes.find(nodeID) == nodes.end()) {
                 addNode(nodeID);
             }
@@ -117,21 +189,38 @@ namespace GraphGenerator {
         }       
         
         void addEdge(int fromID, int toID) {
+            invalidate();
             if (nodes.find(fromID) == nodes.end()) {
                 addNode(fromID);
             }
             nodes[fromID].successors.insert(toID);
         }    
         
-        const std::map<int, CFGNode>& getNodes() const noexcept { 
+        const std::map<int, CFGNode>& getNodes() const { 
+            materialize();
             return nodes; 
         }
         
     private:
-        std::map<int, CFGNode> nodes;
-        std::set<std::pair<int, int>> exceptionEdges;
-        std::set<int> tryBlocks;
-        std::set<int> throwingBlocks;
+        // Fills the containers below from the snapshot of a graph that was
+        // constructed from one. No-op otherwise.
+        void materialize() const;
+        // Called by every mutator: the snapshot no longer matches.
+        void invalidate() {
+            materialize();
+            frozen.reset();
+        }
+
+        mutable std::map<int, CFGNode> nodes;
+        mutable std::set<std::pair<int, int>> exceptionEdges;
+        mutable std::set<int> tryBlocks;
+        mutable std::set<int> throwingBlocks;
+        mutable std::set<std::pair<int, int>> trueEdges;
+        mutable std::set<std::pair<int, int>> falseEdges;
+        mutable int entryNode = -1;
+        mutable int exitNode = -1;
+        mutable bool materialized = true;
+        mutable std::shared_ptr<const CSRGraph> frozen;
     };
 }
 
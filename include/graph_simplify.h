@@ -0,0 +1,68 @@
+#ifndef GRAPH_SIMPLIFY_H
+#define GRAPH_SIMPLIFY_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    struct SimplifyOptions {
+        // Merge maximal chains u -> v where u has no other successor and v
+        // no other predecessor. Entry and exit are never merged.
+        bool mergeChains = true;
+        // Drop blocks without statements or terminator that only jump to
+        // their single successor; their predecessors jump there directly.
+        bool collapseEmpty = true;
+        // Fold the cases of a switch that each fall straight through to
+        // the same block into a single node.
+        bool foldSwitches = false;
+    };
+
+    // A reduced view of a CFG. Each reduced node stands for a group of
+    // original blocks: the members of a chain in order, preceded by the
+    // empty blocks that were collapsed into it. The reduced graph is
+    // identified by the block ID of each group's first non-empty member,
+    // so IDs stay meaningful to the user, and carries no statements of its
+    // own: they are read from the original blocks on demand.
+    class SimplifiedGraph {
+    public:
+        using Index = CSRGraph::Index;
+
+        static SimplifiedGraph build(std::shared_ptr<const CSRGraph> original,
+                                     const SimplifyOptions& options = {});
+
+        const CSRGraph& graph() const { return m_reduced; }
+        const CSRGraph& original() const { return *m_original; }
+
+        // Original nodes making up a reduced node, in execution order.
+        llvm::ArrayRef<Index> members(Index reduced) const {
+            return llvm::ArrayRef<Index>(m_members).slice(m_memberOffsets[reduced],
+                                                          m_memberOffsets[reduced + 1] - m_memberOffsets[reduced]);
+        }
+        // The reduced node an original node ended up in.
+        Index reducedNode(Index original) const { return m_reducedOf[original]; }
+
+        // Calls fn(text) for the statements of all members, in order,
+        // without copying them.
+        template <typename Fn>
+        void forEachStatement(Index reduced, Fn fn) const {
+            for (Index member : members(reduced)) {
+                for (std::string_view text : m_original->statements(member)) fn(text);
+            }
+        }
+
+    private:
+        std::shared_ptr<const CSRGraph> m_original;
+        CSRGraph m_reduced;
+        std::vector<uint32_t> m_memberOffsets;  // reduced index -> range of m_members
+        std::vector<Index> m_members;
+        std::vector<Index> m_reducedOf;         // original index -> reduced index
+    };
+
+} // namespace GraphGenerator
+
+#endif // GRAPH_SIMPLIFY_H
@@ -0,0 +1,57 @@
+#ifndef GRAPH_SLICE_H
+#define GRAPH_SLICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "csr_graph.h"
+#include "dominators.h"
+#include "loop_forest.h"
+
+namespace GraphGenerator {
+
+    // A connected piece of a CFG around one focus block, for views that
+    // cannot afford to show the whole graph. Every slice is grown
+    // breadth-first from the focus inside its region, so when the region
+    // is larger than the node budget the blocks nearest the focus are the
+    // ones kept. Blocks with neighbours outside the slice form its
+    // boundary, which a view can offer to expand.
+    struct GraphSlice {
+        using Index = CSRGraph::Index;
+
+        Index focus = CSRGraph::InvalidIndex;
+        std::vector<Index> nodes;       // ascending
+        std::vector<uint32_t> edges;    // CSR edges with both ends in the slice
+        std::vector<Index> boundary;    // ascending
+        bool truncated = false;         // the region had more nodes than the budget
+
+        bool contains(Index n) const;
+        bool isBoundary(Index n) const;
+    };
+
+    constexpr size_t DefaultSliceNodes = 400;
+
+    // Blocks within `hops` edges of the focus, in either direction.
+    GraphSlice neighborhoodSlice(const CSRGraph& graph, CSRGraph::Index focus, unsigned hops,
+                                 size_t maxNodes = DefaultSliceNodes);
+
+    // The innermost loop containing the focus, nested loops included; just
+    // the focus outside loops.
+    GraphSlice loopSlice(const CSRGraph& graph, const LoopForest& loops, CSRGraph::Index focus,
+                         size_t maxNodes = DefaultSliceNodes);
+
+    // Blocks the focus dominates.
+    GraphSlice dominatorRegionSlice(const CSRGraph& graph, const DominatorTree& dominators,
+                                    CSRGraph::Index focus, size_t maxNodes = DefaultSliceNodes);
+
+    // Blocks on some path from the focus to the exit, or from the entry to
+    // the focus.
+    GraphSlice exitPathSlice(const CSRGraph& graph, CSRGraph::Index focus, size_t maxNodes = DefaultSliceNodes);
+    GraphSlice entryPathSlice(const CSRGraph& graph, CSRGraph::Index focus, size_t maxNodes = DefaultSliceNodes);
+
+    // The slice plus every neighbour of one of its blocks.
+    GraphSlice expandSlice(const CSRGraph& graph, const GraphSlice& slice, CSRGraph::Index node);
+
+} // namespace GraphGenerator
+
+#endif // GRAPH_SLICE_H
@@ -0,0 +1,68 @@
+#ifndef GRAPH_TRAVERSAL_H
+#define GRAPH_TRAVERSAL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    // Traversals shared by the graph analyses. They are templates over any
+    // graph exposing nodeCount(), successors(n) and predecessors(n) on dense
+    // indices, so the same code walks a CSRGraph forwards and a
+    // ReversedGraph backwards.
+
+    // Nodes reachable from root in DFS post-order. Iterative, so deep
+    // graphs cannot overflow the call stack.
+    template <typename GraphT>
+    std::vector<CSRGraph::Index> postOrder(const GraphT& graph, CSRGraph::Index root) {
+        using Index = CSRGraph::Index;
+        std::vector<Index> order;
+        if (root == CSRGraph::InvalidIndex) return order;
+
+        order.reserve(graph.nodeCount());
+        std::vector<bool> visited(graph.nodeCount(), false);
+        std::vector<std::pair<Index, uint32_t>> stack;  // node, next successor position
+        visited[root] = true;
+        stack.push_back({root, 0});
+        while (!stack.empty()) {
+            auto& [node, next] = stack.back();
+            auto succs = graph.successors(node);
+            if (next < succs.size()) {
+                Index succ = succs[next++];
+                if (!visited[succ]) {
+                    visited[succ] = true;
+                    stack.push_back({succ, 0});
+                }
+            } else {
+                order.push_back(node);
+                stack.pop_back();
+            }
+        }
+        return order;
+    }
+
+    template <typename GraphT>
+    std::vector<CSRGraph::Index> reversePostOrder(const GraphT& graph, CSRGraph::Index root) {
+        std::vector<CSRGraph::Index> order = postOrder(graph, root);
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    // Nodes without predecessors, in index order.
+    template <typename GraphT>
+    std::vector<CSRGraph::Index> rootNodes(const GraphT& graph) {
+        std::vector<CSRGraph::Index> roots;
+        for (CSRGraph::Index n = 0; n < graph.nodeCount(); ++n) {
+            if (graph.predecessors(n).empty()) {
+                roots.push_back(n);
+            }
+        }
+        return roots;
+    }
+
+} // namespace GraphGenerator
+
+#endif // GRAPH_TRAVERSAL_H
@@ -6,15 +6,16 @@
 #include <QColor>
 #include <QString>
 #include <memory>
+#include "node.h"
 
 // Forward declarations to minimize includes
-class CFGNode;
 class QGraphicsSceneMouseEvent;
 
 class GraphicalCFGNode : public QGraphicsItem {
 public:
-    // Constructor for CFG node
-    explicit GraphicalCFGNode(const std::shared_ptr<CFGNode>& cfgNode, QGraphicsItem* parent = nullptr);
+    // Constructor for a node of a CFGNodeGraph, which the item keeps alive
+    GraphicalCFGNode(std::shared_ptr<const CFGNodeGraph> graph, CFGNodeGraph::NodeId node,
+                     QGraphicsItem* parent = nullptr);
 
     // Constructor for general graphical node
     GraphicalCFGNode(const QString& id, const QString& label, bool isNewFile, QGraphicsItem* parent = nullptr);
@@ -30,14 +31,16 @@ public:
     bool isNewFile() const;
 
     // Optional: get underlying CFG node if applicable
-    std::shared_ptr<CFGNode> getCFGNode() const { return m_cfgNode; }
+    const CFGNodeGraph* getGraph() const { return m_graph.get(); }
+    CFGNodeGraph::NodeId getCFGNode() const { return m_node; }
 
 protected:
     void mousePressEvent(QGraphicsSceneMouseEvent* event) override;
     void mouseReleaseEvent(QGraphicsSceneMouseEvent* event) override;
 
 private:
-    std::shared_ptr<CFGNode> m_cfgNode;
+    std::shared_ptr<const CFGNodeGraph> m_graph;
+    CFGNodeGraph::NodeId m_node = CFGNodeGraph::InvalidNode;
     QColor m_color;
     QString m_id;
     QString m_label;
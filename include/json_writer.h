@@ -0,0 +1,65 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/raw_ostream.h>
+#include <nlohmann/json.hpp>
+
+namespace GraphGenerator {
+
+    // Event-style JSON output: values go to the stream as they are
+    // produced, so no document is built in memory. With an indent the
+    // text is what nlohmann::json::dump(indent) gives for the same
+    // document, without one what dump() gives, as long as object keys
+    // are written in ascending order the way nlohmann's std::map keeps
+    // them. Strings are UTF-8; where dump() would throw on an invalid
+    // byte, it is written as U+FFFD instead.
+    //
+    // Nesting is up to the caller: every begin needs its end, and inside
+    // an object every value follows a key().
+    class JsonWriter {
+    public:
+        explicit JsonWriter(llvm::raw_ostream& out, unsigned indent = 0)
+            : m_out(out), m_indent(indent) {}
+
+        void beginObject();
+        void endObject();
+        void beginArray();
+        void endArray();
+        void key(std::string_view name);
+
+        void value(std::string_view text);
+        void value(const char* text) { value(std::string_view(text)); }
+        void value(bool flag);
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+        void value(T number) {
+            separator();
+            if constexpr (std::is_signed_v<T>) {
+                m_out << static_cast<int64_t>(number);
+            } else {
+                m_out << static_cast<uint64_t>(number);
+            }
+        }
+        void null();
+
+        // A value that already exists as a DOM, laid out as if it had
+        // been written event by event at the current depth.
+        void embed(const nlohmann::json& json);
+
+    private:
+        void separator();
+        void newline(size_t depth);
+        void writeString(std::string_view text);
+
+        llvm::raw_ostream& m_out;
+        unsigned m_indent;
+        llvm::SmallVector<bool, 16> m_empty;  // per open container: nothing written yet
+        bool m_afterKey = false;
+    };
+
+} // namespace GraphGenerator
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,82 @@
+#ifndef LOOP_FOREST_H
+#define LOOP_FOREST_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    // Loop nesting forest of a CSRGraph, computed with Havlak's algorithm
+    // (union-find over a DFS spanning forest), which is almost linear and
+    // also handles irreducible control flow.
+    //
+    // Every node is covered: the DFS starts at the entry and then restarts
+    // from any node it did not reach, so cycles in unreachable code are
+    // found too. An edge is a back edge when its target is a DFS ancestor of
+    // its source; removing all back edges leaves an acyclic graph, which is
+    // what layout and path analyses rely on. A loop is irreducible when it
+    // can be entered other than through its header; its header is then
+    // simply the first node of the region the DFS reached.
+    class LoopForest {
+    public:
+        using Index = CSRGraph::Index;
+        static constexpr uint32_t NoLoop = ~uint32_t(0);
+
+        struct Loop {
+            Index header;
+            uint32_t parent;   // enclosing loop, NoLoop at top level
+            uint32_t depth;    // 1 for outermost loops
+            bool irreducible;
+        };
+
+        LoopForest() = default;
+        static LoopForest build(const CSRGraph& graph);
+
+        size_t loopCount() const { return m_loops.size(); }
+        const Loop& loop(uint32_t id) const { return m_loops[id]; }
+
+        // Innermost loop containing n, NoLoop if none.
+        uint32_t innermostLoop(Index n) const { return m_innermost[n]; }
+        // Number of loops containing n; 0 outside loops.
+        uint32_t loopDepth(Index n) const {
+            return m_innermost[n] == NoLoop ? 0 : m_loops[m_innermost[n]].depth;
+        }
+        bool isLoopHeader(Index n) const {
+            return m_innermost[n] != NoLoop && m_loops[m_innermost[n]].header == n;
+        }
+        bool contains(uint32_t loopId, Index n) const;
+
+        // All nodes of a loop, nested loops included, in index order.
+        llvm::ArrayRef<Index> body(uint32_t loopId) const {
+            return llvm::ArrayRef<Index>(m_bodies).slice(m_bodyOffsets[loopId], m_bodyOffsets[loopId + 1] - m_bodyOffsets[loopId]);
+        }
+        // CSR edge indices leaving the loop body.
+        llvm::ArrayRef<uint32_t> exitEdges(uint32_t loopId) const {
+            return llvm::ArrayRef<uint32_t>(m_exits).slice(m_exitOffsets[loopId], m_exitOffsets[loopId + 1] - m_exitOffsets[loopId]);
+        }
+
+        bool isBackEdge(uint32_t edge) const { return m_backEdges[edge]; }
+        size_t backEdgeCount() const { return m_backEdgeCount; }
+
+    private:
+        std::vector<Loop> m_loops;
+        std::vector<uint32_t> m_innermost;
+        std::vector<uint32_t> m_bodyOffsets;
+        std::vector<Index> m_bodies;
+        std::vector<uint32_t> m_exitOffsets;
+        std::vector<uint32_t> m_exits;
+        std::vector<bool> m_backEdges;
+        size_t m_backEdgeCount = 0;
+    };
+
+    // LoopForest::build for every graph on up to `threads` threads
+    // (hardware concurrency when 0). Null entries yield empty forests.
+    std::vector<LoopForest> buildLoopForestsBatch(
+        llvm::ArrayRef<std::shared_ptr<const CSRGraph>> graphs, unsigned threads = 0);
+
+} // namespace GraphGenerator
+
+#endif // LOOP_FOREST_H
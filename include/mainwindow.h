@@ -46,6 +46,9 @@ public:
     bool tryInitializeView(bool tryHardware);
     bool testRendering();
     void visualizeCFG(std::shared_ptr<GraphGenerator::CFGGraph> graph);
+    // Shows a function from a cfg_corpus.bin written by the analyzer,
+    // asking which one when no name is given.
+    bool openCorpus(const QString& filePath, const QString& functionName = QString());
 
 
 public slots:
@@ -1,12 +1,22 @@
 #ifndef CFG_NODE_H
 #define CFG_NODE_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <memory>
-
-class CFGNode {
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseSet.h>
+
+// Graph of CFG nodes addressed by index. The graph owns every node and
+// its adjacency, so nodes hold no pointers to each other: there are no
+// reference cycles, and a NodeId stays valid for the graph's lifetime.
+// Duplicate edges are rejected through a hash set in O(1), and
+// successors and predecessors are returned as views rather than copies.
+class CFGNodeGraph {
 public:
+    using NodeId = uint32_t;
+    static constexpr NodeId InvalidNode = ~NodeId(0);
+
     enum NodeType {
         ENTRY,
         EXIT,
@@ -15,32 +25,38 @@ public:
         FUNCTION_CALL
     };
 
-    CFGNode(const std::string& content, NodeType type);
-
-    // Node identification and content
-    std::string getContent() const;
-    NodeType getType() const;
-    std::string getTypeString() const;
+    NodeId addNode(const std::string& content, NodeType type);
+    // Adds from -> to and the matching predecessor; false if it exists.
+    bool addEdge(NodeId from, NodeId to);
+    bool hasEdge(NodeId from, NodeId to) const;
 
-    // Control flow management
-    void addSuccessor(std::shared_ptr<CFGNode> node);
-    void addPredecessor(std::shared_ptr<CFGNode> node);
+    size_t nodeCount() const { return m_nodes.size(); }
+    size_t edgeCount() const { return m_edges.size(); }
 
-    // Get successors and predecessors
-    std::vector<std::shared_ptr<CFGNode>> getSuccessors() const;
-    std::vector<std::shared_ptr<CFGNode>> getPredecessors() const;
+    // Node identification and content
+    const std::string& getContent(NodeId node) const { return m_nodes[node].content; }
+    NodeType getType(NodeId node) const { return m_nodes[node].type; }
+    std::string getTypeString(NodeId node) const;
+    // "node_0042": the index, so IDs are unique within the graph without
+    // any process-wide counter.
+    std::string getUniqueId(NodeId node) const;
 
-    // Unique identifier
-    std::string getUniqueId() const;
+    // Views into the graph; adding edges to a node invalidates its own.
+    llvm::ArrayRef<NodeId> getSuccessors(NodeId node) const { return m_nodes[node].successors; }
+    llvm::ArrayRef<NodeId> getPredecessors(NodeId node) const { return m_nodes[node].predecessors; }
 
 private:
-    std::string m_content;
-    NodeType m_type;
-    std::vector<std::shared_ptr<CFGNode>> m_successors;
-    std::vector<std::shared_ptr<CFGNode>> m_predecessors;
-    std::string m_uniqueId;
+    struct Node {
+        std::string content;
+        NodeType type;
+        std::vector<NodeId> successors;
+        std::vector<NodeId> predecessors;
+    };
+
+    static uint64_t edgeKey(NodeId from, NodeId to) { return (static_cast<uint64_t>(from) << 32) | to; }
 
-    static size_t s_nodeCounter;
+    std::vector<Node> m_nodes;
+    llvm::DenseSet<uint64_t> m_edges;
 };
 
 #endif // CFG_NODE_H
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace GraphGenerator {
+
+    // Calls body(i) for every i in [0, count) using up to `threads` threads
+    // (hardware concurrency when 0), the calling thread included. Indices
+    // are handed out one at a time, so functions of very different sizes
+    // still balance. body must be safe to run concurrently and must not
+    // throw.
+    template <typename Body>
+    void parallelFor(size_t count, Body body, unsigned threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+        if (threads <= 1) {
+            for (size_t i = 0; i < count; ++i) {
+                body(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                body(i);
+            }
+        };
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for (unsigned t = 1; t < threads; ++t) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+    }
+
+} // namespace GraphGenerator
+
+#endif // PARALLEL_FOR_H
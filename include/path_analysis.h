@@ -0,0 +1,79 @@
+#ifndef PATH_ANALYSIS_H
+#define PATH_ANALYSIS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include "csr_graph.h"
+#include "loop_forest.h"
+
+namespace GraphGenerator {
+
+    // Unsigned integer of unbounded size. Path counts double with every
+    // sequential two-way branch, so they leave uint64_t quickly; only
+    // addition is needed to count them.
+    class BigUInt {
+    public:
+        BigUInt(uint64_t value = 0);
+
+        BigUInt& operator+=(const BigUInt& other);
+        bool operator==(const BigUInt& other) const { return m_limbs == other.m_limbs; }
+        bool operator!=(const BigUInt& other) const { return m_limbs != other.m_limbs; }
+
+        bool fitsUInt64() const { return m_limbs.size() <= 2; }
+        uint64_t toUInt64() const;  // saturates at UINT64_MAX
+        std::string toString() const;  // decimal
+
+    private:
+        std::vector<uint32_t> m_limbs;  // base 2^32, least significant first, no leading zeros
+    };
+
+    // Path analyses run on the acyclic graph left after removing the back
+    // edges of the loop forest, i.e. every loop is taken at most once. A
+    // path runs from the entry to a block without remaining successors:
+    // the exit, or a loop latch whose only edge went back to its header.
+
+    struct PathCount {
+        uint64_t saturated = 0;  // UINT64_MAX when the exact count does not fit
+        BigUInt exact;
+    };
+
+    // Number of acyclic entry-to-sink paths, by dynamic programming over
+    // a topological order in O(V + E) additions. The exact count is only
+    // computed with BigUInt when the 64-bit pass saturates.
+    PathCount countPaths(const CSRGraph& graph, const LoopForest& loops);
+
+    struct WeightedPath {
+        double weight = 0;
+        std::vector<CSRGraph::Index> nodes;  // entry first
+    };
+
+    using NodeWeight = llvm::function_ref<double(CSRGraph::Index)>;
+
+    // The k heaviest acyclic paths from the entry, heaviest first. A path
+    // weighs the sum of its nodes' weights; without a weight function every
+    // block counts 1, giving the k longest paths. Each node keeps its k best
+    // suffixes (weight, successor, rank in the successor's list), so the
+    // cost is O(E k log k) however many paths there are. Ties are broken
+    // towards lower successor indices.
+    std::vector<WeightedPath> topKPaths(const CSRGraph& graph, const LoopForest& loops,
+                                        size_t k, NodeWeight weight = nullptr);
+
+    // Block IDs along a path, in order, as taken by
+    // Visualizer::generateDotRepresentation's highlightPaths.
+    std::vector<int> pathBlockIds(const CSRGraph& graph, const WeightedPath& path);
+
+    // What the analyzer reports per function: the path count, and the
+    // block IDs of the k heaviest paths, heaviest first.
+    struct PathSummary {
+        std::string count;  // decimal, as it may not fit 64 bits
+        std::vector<std::vector<int>> heaviest;
+    };
+
+    PathSummary summarizePaths(const CSRGraph& graph, const LoopForest& loops,
+                               size_t k, NodeWeight weight = nullptr);
+
+} // namespace GraphGenerator
+
+#endif // PATH_ANALYSIS_H
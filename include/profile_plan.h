@@ -0,0 +1,100 @@
+#ifndef PROFILE_PLAN_H
+#define PROFILE_PLAN_H
+
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include "csr_graph.h"
+#include "loop_forest.h"
+
+namespace GraphGenerator {
+
+    // Where to put profiling probes so that as few as possible are needed
+    // (Ball and Larus, "Optimally Profiling and Tracing Programs" and
+    // "Efficient Path Profiling").
+    //
+    // Joining every block that ends the function back to the entry with a
+    // virtual edge makes edge counts conserve flow: what enters a block
+    // leaves it. The counts on a spanning tree then follow from those off
+    // it, so only the chords need counters. Building a maximum spanning
+    // tree over estimated frequencies keeps the hottest edges uncounted.
+
+    // Static estimate when no profile is at hand: an edge weighs
+    // LoopWeight^(loop depth of its source), split over the source's
+    // successors.
+    constexpr double LoopWeight = 10.0;
+    std::vector<double> estimateEdgeWeights(const CSRGraph& graph, const LoopForest& loops);
+
+    struct EdgeProfilePlan {
+        std::vector<uint32_t> counters;   // CSR edges to count, ascending
+        // Blocks the entry reaches that have no successors; virtual edge
+        // edgeCount() + i runs from virtualSources[i] back to the entry.
+        std::vector<CSRGraph::Index> virtualSources;
+        // The other edges, virtual ones included, each with the block whose
+        // flow balance gives its count, in the order they can be solved.
+        std::vector<std::pair<uint32_t, CSRGraph::Index>> derived;
+    };
+
+    // Empty weights (one per CSR edge otherwise) use estimateEdgeWeights.
+    // Edges the entry cannot reach are never executed and get no counter.
+    EdgeProfilePlan planEdgeProfile(const CSRGraph& graph, llvm::ArrayRef<double> edgeWeights = {});
+
+    // Count of every CSR edge from the counters' values, given in
+    // plan.counters order.
+    std::vector<uint64_t> reconstructEdgeCounts(const CSRGraph& graph, const EdgeProfilePlan& plan,
+                                                llvm::ArrayRef<uint64_t> counterValues);
+
+    // Path profiling numbers the acyclic paths of the graph without its
+    // loop back edges 0 .. pathCount-1: a register r starts at 0 at the
+    // entry, taking an edge adds its increment, and where the path ends
+    // count[r] is bumped. A back edge ends one path and starts the next at
+    // its loop header; back edges leaving one block end the same path, and
+    // those entering one header start the same one. Increments come from
+    // the chords of a maximum spanning tree, so the hot edges add nothing;
+    // paths ending at a back edge or a block without successors fold their
+    // increment into the count update.
+    struct PathProfilePlan {
+        struct LoopEdge {
+            uint32_t edge;           // CSR back edge
+            int64_t endIncrement;    // count[r + endIncrement]++ on taking it
+            int64_t restart;         // then r = restart
+            uint64_t endValue;       // path numbers of the two dummy edges
+            uint64_t startValue;     // that stand in for it, for decodePath
+        };
+        uint64_t pathCount = 0;
+        bool overflow = false;       // more than 2^62 paths: no numbering
+        std::vector<std::pair<uint32_t, int64_t>> increments;   // (CSR edge, r += amount), non-zero only
+        std::vector<LoopEdge> loopEdges;                        // by CSR edge
+        std::vector<std::pair<CSRGraph::Index, int64_t>> pathEnds;  // count[r + amount]++ at these blocks
+        std::vector<uint64_t> edgeValues;  // path number contribution per CSR edge, 0 on back edges
+    };
+
+    PathProfilePlan planPathProfile(const CSRGraph& graph, const LoopForest& loops,
+                                    llvm::ArrayRef<double> edgeWeights = {});
+
+    // Blocks along the path numbered pathId. A path that starts at a back
+    // edge begins at the loop header; one that ends at a back edge ends at
+    // the block taking it. Empty if the ID is out of range.
+    std::vector<CSRGraph::Index> decodePath(const CSRGraph& graph, const LoopForest& loops,
+                                            const PathProfilePlan& plan, uint64_t pathId);
+
+    // Both plans in block IDs, as the analyzer reports and caches them,
+    // keeping the hottest edges uncounted. Empty weights (one per CSR edge
+    // otherwise) are estimated with estimateBlockFrequencies.
+    struct InstrumentationPlan {
+        uint32_t edges = 0;                          // edges the entry reaches
+        std::vector<std::pair<int, int>> counters;   // (from, to)
+        uint64_t paths = 0;                          // 0 if the numbering overflowed
+        std::vector<std::tuple<int, int, int64_t>> pathIncrements;          // (from, to, amount)
+        std::vector<std::tuple<int, int, int64_t, int64_t>> loopEdges;      // (from, to, end increment, restart)
+        std::vector<std::pair<int, int64_t>> pathEnds;                      // (block, amount)
+    };
+
+    InstrumentationPlan planInstrumentation(const CSRGraph& graph, const LoopForest& loops,
+                                            llvm::ArrayRef<double> edgeWeights = {});
+
+} // namespace GraphGenerator
+
+#endif // PROFILE_PLAN_H
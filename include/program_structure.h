@@ -0,0 +1,83 @@
+#ifndef PROGRAM_STRUCTURE_H
+#define PROGRAM_STRUCTURE_H
+
+#include <cstdint>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include "csr_graph.h"
+
+namespace GraphGenerator {
+
+    // Program structure tree: the nesting of a CFG's single-entry,
+    // single-exit regions (Johnson, Pearson and Pingali).
+    //
+    // With an edge added from the exit back to the entry, two edges are
+    // cycle equivalent when every cycle through one passes through the
+    // other. Such edges are ordered by dominance, and every consecutive
+    // pair bounds a canonical SESE region. Equivalence classes come from
+    // one undirected DFS that keeps, per node, the list of back edges
+    // ("brackets") spanning it. The regions come from one directed DFS that
+    // opens and closes a region at each edge of a class. Both are linear.
+    //
+    // Sibling regions of one class follow each other in sequence. When
+    // maxChildren is set, long runs of them are grouped into sequence
+    // regions so that no region shows more than about that many children,
+    // which keeps a collapsed view of a long function small. Regions are
+    // numbered in preorder, children in DFS order, and region 0 is the
+    // whole function.
+    class ProgramStructureTree {
+    public:
+        using Index = CSRGraph::Index;
+        static constexpr uint32_t Root = 0;
+        static constexpr uint32_t NoRegion = ~uint32_t(0);
+        static constexpr uint32_t NoEdge = ~uint32_t(0);
+
+        struct Region {
+            uint32_t entryEdge;    // CSR edge into the region, NoEdge for the root
+            uint32_t exitEdge;     // CSR edge out of it, NoEdge for the root
+            uint32_t parent;       // NoRegion for the root
+            uint32_t depth;        // 0 for the root
+            uint32_t blockCount;   // blocks inside, nested regions included
+            bool sequence;         // groups consecutive sibling regions
+        };
+
+        ProgramStructureTree() = default;
+        static ProgramStructureTree build(const CSRGraph& graph, uint32_t maxChildren = 0);
+
+        size_t regionCount() const { return m_regions.size(); }
+        const Region& region(uint32_t r) const { return m_regions[r]; }
+        llvm::ArrayRef<uint32_t> children(uint32_t r) const {
+            return llvm::ArrayRef<uint32_t>(m_children).slice(m_childOffsets[r], m_childOffsets[r + 1] - m_childOffsets[r]);
+        }
+        // Blocks directly in a region, not in any of its children, ascending.
+        llvm::ArrayRef<Index> blocks(uint32_t r) const {
+            return llvm::ArrayRef<Index>(m_blocks).slice(m_blockOffsets[r], m_blockOffsets[r + 1] - m_blockOffsets[r]);
+        }
+        // Innermost region containing a block; unreachable blocks sit in the root.
+        uint32_t regionOf(Index n) const { return m_regionOf[n]; }
+        // Is block n inside region r or one of its descendants?
+        bool contains(uint32_t r, Index n) const {
+            return m_regionOf[n] >= r && m_regionOf[n] < m_subtreeEnd[r];
+        }
+        // Cycle-equivalence class of a CSR edge.
+        uint32_t edgeClass(uint32_t edge) const { return m_edgeClass[edge]; }
+
+    private:
+        std::vector<Region> m_regions;
+        std::vector<uint32_t> m_subtreeEnd;     // preorder number past the last descendant
+        std::vector<uint32_t> m_childOffsets;
+        std::vector<uint32_t> m_children;
+        std::vector<uint32_t> m_blockOffsets;
+        std::vector<Index> m_blocks;
+        std::vector<uint32_t> m_regionOf;
+        std::vector<uint32_t> m_edgeClass;
+    };
+
+    // Cycle-equivalence classes of the CSR edges, with an exit-to-entry
+    // edge implied. Used by ProgramStructureTree; exposed for tests and
+    // other structural passes.
+    std::vector<uint32_t> cycleEquivalenceClasses(const CSRGraph& graph);
+
+} // namespace GraphGenerator
+
+#endif // PROGRAM_STRUCTURE_H
@@ -0,0 +1,61 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include <cstdint>
+#include <vector>
+#include "csr_graph.h"
+#include "dataflow.h"
+
+namespace GraphGenerator {
+
+    // Answers "can block A reach block B" without searching the graph.
+    // Strongly connected components are condensed first, numbered in
+    // topological order, and given two post-order intervals from one DFS
+    // of the condensation:
+    //  - the spanning-tree interval, whose containment proves reachability;
+    //  - the interval widened over all descendants (GRAIL), whose
+    //    non-containment disproves it.
+    // Up to ClosureComponentLimit components the full transitive closure
+    // is also kept as 64-bit words; larger graphs fall back to a search
+    // that the labels prune.
+    class ReachabilityIndex {
+    public:
+        using Index = CSRGraph::Index;
+        static constexpr size_t ClosureComponentLimit = 1 << 14;  // 32 MiB of closure
+
+        ReachabilityIndex() = default;
+        static ReachabilityIndex build(const CSRGraph& graph);
+
+        size_t nodeCount() const { return m_component.size(); }
+        size_t componentCount() const { return m_treeLow.size(); }
+        uint32_t component(Index n) const { return m_component[n]; }
+        bool hasClosure() const { return m_closure.words() != 0; }
+
+        // True if a path leads from one node to the other; every node
+        // reaches itself.
+        bool reaches(Index from, Index to) const;
+
+        // Nodes lying on some path from one node to the other, ascending;
+        // empty if there is no such path.
+        std::vector<Index> between(Index from, Index to) const;
+
+    private:
+        bool reachesComponent(uint32_t from, uint32_t to) const;
+        std::vector<bool> reachableComponents(uint32_t start, uint32_t bound, bool forward) const;
+
+        std::vector<uint32_t> m_component;      // node -> component, topological
+        std::vector<uint32_t> m_memberOffsets;  // component -> its nodes
+        std::vector<Index> m_members;
+        std::vector<uint32_t> m_dagOffsets;     // condensation edges, both ways
+        std::vector<uint32_t> m_dagTargets;
+        std::vector<uint32_t> m_dagPredOffsets;
+        std::vector<uint32_t> m_dagSources;
+        std::vector<uint32_t> m_post;           // post-order number
+        std::vector<uint32_t> m_treeLow;        // lowest post number in the DFS subtree
+        std::vector<uint32_t> m_reachLow;       // lowest post number of any descendant
+        BitMatrix m_closure;                    // row c: components reachable from c
+    };
+
+} // namespace GraphGenerator
+
+#endif // REACHABILITY_H
@@ -1,17 +1,47 @@
 #ifndef VISUALIZER_H
 #define VISUALIZER_H
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
 #include "graph_generator.h"
 
+namespace GraphGenerator {
+    class ControlDependence;
+    class LoopForest;
+}
+
 namespace Visualizer {
 <<<<<<< HEAD
 
+// Analyses of the snapshot being drawn that the caller already has, so
+// that an export does not repeat them. Those left unset are computed.
+struct GraphAnalyses {
+    const GraphGenerator::LoopForest* loops = nullptr;
+    llvm::ArrayRef<double> frequencies;  // per block, from estimateBlockFrequencies
+    const GraphGenerator::ControlDependence* controlDependence = nullptr;
+    std::optional<uint64_t> shapeHash;  // computeStructuralHash
+};
+
 std::string generateDotRepresentation(
     const GraphGenerator::CFGGraph* graph,
     bool showLineNumbers = true,
     bool simplifyGraph = false,
-    const std::vector<int>& highlightPaths = {}
+    const std::vector<int>& highlightPaths = {},
+    bool heatMap = false
+);
+
+// The same for a snapshot (CFGGraph::freeze()) and its analyses.
+std::string generateDotRepresentation(
+    std::shared_ptr<const GraphGenerator::CSRGraph> graph,
+    const GraphAnalyses& analyses,
+    bool showLineNumbers = true,
+    bool simplifyGraph = false,
+    const std::vector<int>& highlightPaths = {},
+    bool heatMap = false
 );
 
 bool exportToDot(
@@ -19,7 +49,18 @@ bool exportToDot(
     const std::string& filename,
     bool showLineNumbers = true,
     bool simplifyGraph = false,
-    const std::vector<int>& highlightPaths = {}
+    const std::vector<int>& highlightPaths = {},
+    bool heatMap = false
+);
+
+bool exportToDot(
+    std::shared_ptr<const GraphGenerator::CSRGraph> graph,
+    const std::string& filename,
+    const GraphAnalyses& analyses,
+    bool showLineNumbers = true,
+    bool simplifyGraph = false,
+    const std::vector<int>& highlightPaths = {},
+    bool heatMap = false
 );
 
 enum class ExportFormat {
@@ -35,9 +76,15 @@ bool exportGraph(
     ExportFormat format = ExportFormat::DOT,
     bool showLineNumbers = true,
     bool simplifyGraph = false,
-    const std::vector<int>& highlightPaths = {}
+    const std::vector<int>& highlightPaths = {},
+    bool heatMap = false
 );
 
+// Version of the DOT this exporter writes. Raise it whenever the output
+// changes (attributes, styling, layout of labels), so that DOT cached by an
+// earlier version is regenerated instead of reused.
+constexpr int DotFormatVersion = 1;
+
 } // namespace Visualizer
 =======
     // Function to generate DOT representation of the graph
@@ -0,0 +1,49 @@
+#include "analysis_session.h"
+#include <cstring>
+
+namespace GraphGenerator {
+
+void* AnalysisSession::CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    ++allocations;
+    this->bytes += bytes;
+    return m_upstream->allocate(bytes, alignment);
+}
+
+void AnalysisSession::CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    m_upstream->deallocate(p, bytes, alignment);
+}
+
+bool AnalysisSession::CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+AnalysisSession::AnalysisSession(size_t initialBlockSize)
+    : m_upstream(std::pmr::new_delete_resource()),
+      m_arena(initialBlockSize, &m_upstream),
+      m_counter(&m_arena),
+      m_strings(&m_counter) {}
+
+std::string_view AnalysisSession::intern(std::string_view text) {
+    auto it = m_strings.find(text);
+    if (it != m_strings.end()) {
+        ++m_internHits;
+        return *it;
+    }
+    char* copy = static_cast<char*>(m_counter.allocate(text.size() + 1, alignof(char)));
+    std::memcpy(copy, text.data(), text.size());
+    copy[text.size()] = '\0';
+    return *m_strings.insert(std::string_view(copy, text.size())).first;
+}
+
+AllocationStats AnalysisSession::stats() const {
+    AllocationStats stats;
+    stats.arenaAllocations = m_counter.allocations;
+    stats.arenaBytes = m_counter.bytes;
+    stats.upstreamAllocations = m_upstream.allocations;
+    stats.upstreamBytes = m_upstream.bytes;
+    stats.internedStrings = m_strings.size();
+    stats.internHits = m_internHits;
+    return stats;
+}
+
+} // namespace GraphGenerator
@@ -0,0 +1,321 @@
+#include "block_frequency.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <clang/AST/Decl.h>
+#include <clang/AST/Expr.h>
+#include <clang/AST/Stmt.h>
+
+namespace GraphGenerator {
+
+namespace {
+
+using Index = CSRGraph::Index;
+constexpr uint32_t None = ~uint32_t(0);
+
+constexpr double LoopBranchTaken = 0.88;
+constexpr double LoopExitAvoided = 0.80;
+constexpr double PointerUnequal = 0.60;
+constexpr double OpcodeHolds = 0.84;
+constexpr double ReturnAvoided = 0.72;
+constexpr double CallAvoided = 0.78;
+
+// Dempster-Shafer: the belief in an outcome after two independent
+// pieces of evidence for it.
+double combine(double p, double q) {
+    return p * q / (p * q + (1 - p) * (1 - q));
+}
+
+// The condition a block's terminator decides on. A block ending in `a && b`
+// tests a; the block after it tests b under the enclosing statement.
+const clang::Expr* branchCondition(const clang::Stmt* terminator) {
+    const clang::Expr* condition = nullptr;
+    if (const auto* s = llvm::dyn_cast<clang::IfStmt>(terminator)) condition = s->getCond();
+    else if (const auto* s = llvm::dyn_cast<clang::WhileStmt>(terminator)) condition = s->getCond();
+    else if (const auto* s = llvm::dyn_cast<clang::ForStmt>(terminator)) condition = s->getCond();
+    else if (const auto* s = llvm::dyn_cast<clang::DoStmt>(terminator)) condition = s->getCond();
+    else if (const auto* s = llvm::dyn_cast<clang::AbstractConditionalOperator>(terminator)) condition = s->getCond();
+    else if (const auto* s = llvm::dyn_cast<clang::BinaryOperator>(terminator)) {
+        if (s->isLogicalOp()) return s->getLHS();
+    }
+    while (condition) {
+        const auto* logical = llvm::dyn_cast<clang::BinaryOperator>(condition->IgnoreParenImpCasts());
+        if (!logical || !logical->isLogicalOp()) break;
+        condition = logical->getRHS();
+    }
+    return condition;
+}
+
+bool isConstant(const clang::Expr* e) {
+    e = e->IgnoreParenImpCasts();
+    if (llvm::isa<clang::IntegerLiteral>(e) || llvm::isa<clang::CharacterLiteral>(e)) return true;
+    const auto* ref = llvm::dyn_cast<clang::DeclRefExpr>(e);
+    return ref && llvm::isa<clang::EnumConstantDecl>(ref->getDecl());
+}
+
+bool isZero(const clang::Expr* e) {
+    const auto* literal = llvm::dyn_cast<clang::IntegerLiteral>(e->IgnoreParenImpCasts());
+    return literal && literal->getValue() == 0;
+}
+
+bool isPointer(const clang::Expr* e) {
+    const clang::QualType type = e->IgnoreParenImpCasts()->getType();
+    return type->isAnyPointerType() || type->isNullPtrType() || type->isMemberPointerType();
+}
+
+// Probability that a condition holds by the pointer and opcode rules,
+// 0.5 when neither applies.
+double conditionBias(const clang::Expr* condition) {
+    condition = condition->IgnoreParenImpCasts();
+    if (const auto* unary = llvm::dyn_cast<clang::UnaryOperator>(condition)) {
+        if (unary->getOpcode() == clang::UO_LNot) return 1 - conditionBias(unary->getSubExpr());
+    }
+    const auto* binary = llvm::dyn_cast<clang::BinaryOperator>(condition);
+    if (!binary || !binary->isComparisonOp()) {
+        return isPointer(condition) ? PointerUnequal : 0.5;
+    }
+    const clang::Expr* lhs = binary->getLHS();
+    const clang::Expr* rhs = binary->getRHS();
+    clang::BinaryOperatorKind op = binary->getOpcode();
+    if (isConstant(lhs) && !isConstant(rhs)) {
+        std::swap(lhs, rhs);
+        op = clang::BinaryOperator::reverseComparisonOp(op);
+    }
+    const bool equality = op == clang::BO_EQ || op == clang::BO_NE;
+    if (isPointer(lhs) || isPointer(rhs)) {
+        if (!equality) return 0.5;
+        return op == clang::BO_NE ? PointerUnequal : 1 - PointerUnequal;
+    }
+    if (lhs->IgnoreParenImpCasts()->getType()->isRealFloatingType()) {
+        if (!equality) return 0.5;
+        return op == clang::BO_NE ? OpcodeHolds : 1 - OpcodeHolds;
+    }
+    if (equality && isConstant(rhs)) return op == clang::BO_NE ? OpcodeHolds : 1 - OpcodeHolds;
+    if (isZero(rhs)) {
+        if (op == clang::BO_LT || op == clang::BO_LE) return 1 - OpcodeHolds;
+        if (op == clang::BO_GT || op == clang::BO_GE) return OpcodeHolds;
+    }
+    return 0.5;
+}
+
+bool hasStatement(const CSRGraph& graph, Index n, bool (*match)(const clang::Stmt*)) {
+    for (const clang::Stmt* stmt : graph.statementHandles(n)) {
+        if (stmt && match(stmt)) return true;
+    }
+    return false;
+}
+
+// Blocks ending the function through a return. Without AST handles any
+// block whose only successor is the exit counts.
+bool returns(const CSRGraph& graph, Index n) {
+    if (n == graph.exit()) return true;
+    if (graph.outDegree(n) != 1 || graph.successors(n)[0] != graph.exit()) return false;
+    return graph.statementHandles(n).empty() ||
+           hasStatement(graph, n, [](const clang::Stmt* s) { return llvm::isa<clang::ReturnStmt>(s); });
+}
+
+bool calls(const CSRGraph& graph, Index n) {
+    return hasStatement(graph, n, [](const clang::Stmt* s) { return llvm::isa<clang::CallExpr>(s); });
+}
+
+bool isCold(const CSRGraph& graph, uint32_t e) {
+    const Index target = graph.edgeTarget(e);
+    return (graph.edgeFlags(e) & EdgeException) || graph.hasAttribute(target, NodeThrowsException) ||
+           (graph.outDegree(target) == 0 && target != graph.exit());
+}
+
+// Probability of taking a rather than b out of n.
+double twoWayBias(const CSRGraph& graph, const LoopForest& loops, Index n, uint32_t a, uint32_t b) {
+    const Index targetA = graph.edgeTarget(a);
+    const Index targetB = graph.edgeTarget(b);
+    double p = 0.5;
+    if (loops.isBackEdge(a) != loops.isBackEdge(b)) {
+        p = combine(p, loops.isBackEdge(a) ? LoopBranchTaken : 1 - LoopBranchTaken);
+    } else if (const uint32_t loop = loops.innermostLoop(n); loop != LoopForest::NoLoop) {
+        const bool exitA = !loops.contains(loop, targetA);
+        const bool exitB = !loops.contains(loop, targetB);
+        if (exitA != exitB) {
+            const double stay = loops.isLoopHeader(n) ? LoopBranchTaken : LoopExitAvoided;
+            p = combine(p, exitA ? 1 - stay : stay);
+        }
+    }
+
+    const uint8_t flagsA = graph.edgeFlags(a);
+    const uint8_t flagsB = graph.edgeFlags(b);
+    if (((flagsA & EdgeTrueBranch) && (flagsB & EdgeFalseBranch)) ||
+        ((flagsA & EdgeFalseBranch) && (flagsB & EdgeTrueBranch))) {
+        if (const clang::Expr* condition = graph.terminator(n) ? branchCondition(graph.terminator(n)) : nullptr) {
+            const double holds = conditionBias(condition);
+            if (holds != 0.5) p = combine(p, flagsA & EdgeTrueBranch ? holds : 1 - holds);
+        }
+    }
+
+    // The return and call rules are about what a branch guards, so they
+    // skip an if without else, where one side is the join point.
+    if (graph.findEdge(targetA, targetB) != CSRGraph::InvalidIndex ||
+        graph.findEdge(targetB, targetA) != CSRGraph::InvalidIndex) {
+        return p;
+    }
+    const bool returnA = returns(graph, targetA);
+    if (returnA != returns(graph, targetB)) {
+        p = combine(p, returnA ? 1 - ReturnAvoided : ReturnAvoided);
+    }
+    const bool callA = calls(graph, targetA);
+    if (callA != calls(graph, targetB)) {
+        p = combine(p, callA ? 1 - CallAvoided : CallAvoided);
+    }
+    return p;
+}
+
+} // namespace
+
+std::vector<double> estimateBranchProbabilities(const CSRGraph& graph, const LoopForest& loops) {
+    std::vector<double> probabilities(graph.edgeCount(), 0.0);
+    std::vector<uint32_t> hot;
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        const uint32_t begin = graph.edgeBegin(n), end = graph.edgeEnd(n);
+        if (begin == end) continue;
+        hot.clear();
+        for (uint32_t e = begin; e < end; ++e) {
+            if (!isCold(graph, e)) hot.push_back(e);
+        }
+        // All cold is no information: split evenly.
+        double rest = 1.0;
+        if (hot.empty()) {
+            for (uint32_t e = begin; e < end; ++e) hot.push_back(e);
+        } else {
+            for (uint32_t e = begin; e < end; ++e) {
+                if (std::find(hot.begin(), hot.end(), e) != hot.end()) continue;
+                probabilities[e] = ColdProbability;
+                rest -= ColdProbability;
+            }
+        }
+        if (hot.size() == 2) {
+            const double p = twoWayBias(graph, loops, n, hot[0], hot[1]);
+            probabilities[hot[0]] = rest * p;
+            probabilities[hot[1]] = rest * (1 - p);
+        } else {
+            for (uint32_t e : hot) probabilities[e] = rest / hot.size();
+        }
+    }
+    return probabilities;
+}
+
+std::vector<double> estimateBlockFrequencies(const CSRGraph& graph, const LoopForest& loops,
+                                             llvm::ArrayRef<double> probabilities) {
+    const size_t nodeCount = graph.nodeCount();
+    std::vector<double> frequencies(nodeCount, 0.0);
+    const Index entry = graph.entry();
+    if (entry == CSRGraph::InvalidIndex) return frequencies;
+
+    // Topological order of the blocks the entry reaches, without back edges.
+    std::vector<char> reached(nodeCount, 0);
+    std::vector<Index> stack{entry};
+    reached[entry] = 1;
+    while (!stack.empty()) {
+        const Index n = stack.back();
+        stack.pop_back();
+        for (Index s : graph.successors(n)) {
+            if (!reached[s]) {
+                reached[s] = 1;
+                stack.push_back(s);
+            }
+        }
+    }
+    std::vector<uint32_t> waiting(nodeCount, 0);
+    for (Index n = 0; n < nodeCount; ++n) {
+        if (!reached[n]) continue;
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            if (!loops.isBackEdge(e)) ++waiting[graph.edgeTarget(e)];
+        }
+    }
+    std::vector<Index> order{entry};
+    std::vector<uint32_t> position(nodeCount, None);
+    for (size_t i = 0; i < order.size(); ++i) {
+        position[order[i]] = static_cast<uint32_t>(i);
+        for (uint32_t e = graph.edgeBegin(order[i]); e < graph.edgeEnd(order[i]); ++e) {
+            if (!loops.isBackEdge(e) && --waiting[graph.edgeTarget(e)] == 0) order.push_back(graph.edgeTarget(e));
+        }
+    }
+
+    // Flow into n over forward edges from blocks accepted by from.
+    auto inflow = [&](Index n, const std::vector<double>& values, auto&& from) {
+        double sum = 0;
+        llvm::ArrayRef<Index> preds = graph.predecessors(n);
+        llvm::ArrayRef<uint32_t> predEdges = graph.predecessorEdges(n);
+        for (size_t i = 0; i < preds.size(); ++i) {
+            if (!loops.isBackEdge(predEdges[i]) && from(preds[i])) sum += values[preds[i]] * probabilities[predEdges[i]];
+        }
+        return sum;
+    };
+
+    // Innermost loops first: with the header at 1, the flow reaching its
+    // back edges is the probability of another iteration.
+    std::vector<double> scale(nodeCount, 1.0);
+    std::vector<double> local(nodeCount, 0.0);
+    std::vector<uint32_t> byDepth(loops.loopCount());
+    std::iota(byDepth.begin(), byDepth.end(), 0);
+    std::stable_sort(byDepth.begin(), byDepth.end(),
+                     [&](uint32_t a, uint32_t b) { return loops.loop(a).depth > loops.loop(b).depth; });
+    std::vector<Index> body;
+    for (uint32_t loop : byDepth) {
+        const Index header = loops.loop(loop).header;
+        if (!reached[header]) continue;
+        body.clear();
+        for (Index n : loops.body(loop)) {
+            if (reached[n] && n != header) body.push_back(n);
+        }
+        std::sort(body.begin(), body.end(), [&](Index a, Index b) { return position[a] < position[b]; });
+        auto inLoop = [&](Index n) { return loops.contains(loop, n); };
+        local[header] = 1.0;
+        for (Index n : body) local[n] = inflow(n, local, inLoop) * scale[n];
+        double again = 0;
+        llvm::ArrayRef<Index> preds = graph.predecessors(header);
+        llvm::ArrayRef<uint32_t> predEdges = graph.predecessorEdges(header);
+        for (size_t i = 0; i < preds.size(); ++i) {
+            if (loops.isBackEdge(predEdges[i]) && reached[preds[i]] && inLoop(preds[i])) {
+                again += local[preds[i]] * probabilities[predEdges[i]];
+            }
+        }
+        scale[header] = 1.0 / (1.0 - std::min(again, 1.0 - 1.0 / MaxLoopScale));
+    }
+
+    frequencies[entry] = scale[entry];
+    for (size_t i = 1; i < order.size(); ++i) {
+        frequencies[order[i]] = inflow(order[i], frequencies, [](Index) { return true; }) * scale[order[i]];
+    }
+    return frequencies;
+}
+
+std::vector<double> edgeFrequencies(const CSRGraph& graph, llvm::ArrayRef<double> frequencies,
+                                    llvm::ArrayRef<double> probabilities) {
+    std::vector<double> result(graph.edgeCount(), 0.0);
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            result[e] = frequencies[n] * probabilities[e];
+        }
+    }
+    return result;
+}
+
+std::string heatColor(double frequency, double maxFrequency) {
+    // Colour stops of ColorBrewer's YlOrRd scale.
+    static const double stops[3][3] = {{255, 255, 204}, {253, 141, 60}, {189, 0, 38}};
+    const double low = std::log10(0.01);
+    const double high = std::log10(std::max(maxFrequency, 10000.0));
+    double level = 0;
+    if (frequency > 0 && high > low) {
+        level = std::clamp((std::log10(frequency) - low) / (high - low), 0.0, 1.0);
+    }
+    const int segment = level < 0.5 ? 0 : 1;
+    const double t = level * 2 - segment;
+    char color[8];
+    std::snprintf(color, sizeof(color), "#%02x%02x%02x",
+                  static_cast<int>(std::lround(stops[segment][0] + (stops[segment + 1][0] - stops[segment][0]) * t)),
+                  static_cast<int>(std::lround(stops[segment][1] + (stops[segment + 1][1] - stops[segment][1]) * t)),
+                  static_cast<int>(std::lround(stops[segment][2] + (stops[segment + 1][2] - stops[segment][2]) * t)));
+    return color;
+}
+
+} // namespace GraphGenerator
@@ -4,46 +4,339 @@
 #include "parser.h"
 #include "graph_generator.h"
 #include "visualizer.h"
+#include "analysis_session.h"
+#include "dominators.h"
+#include "cfg_metrics.h"
+#include "cfg_hash.h"
+#include "cfg_diff.h"
+#include "control_dependence.h"
+#include "block_frequency.h"
 #include <QString>
 #include <clang/Tooling/Tooling.h>
 #include <clang/Tooling/CommonOptionsParser.h>
+#include <clang/Index/USRGeneration.h>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/xxhash.h>
 #include <iomanip>
 #include <chrono>
 #include <ctime>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
 namespace CFGAnalyzer {
 
+// Qualified name, with the parameter types appended when the name is
+// overloaded in its scope so that every overload keeps its own results.
+// Calls to template instantiations name the template they come from.
+static std::string functionName(const clang::FunctionDecl* FD) {
+    if (const clang::FunctionDecl* pattern = FD->getTemplateInstantiationPattern()) {
+        FD = pattern;
+    }
+    std::string name = FD->getQualifiedNameAsString();
+    clang::DeclContext::lookup_result decls = FD->getDeclContext()->getRedeclContext()->lookup(FD->getDeclName());
+    if (decls.empty() || decls.isSingleResult()) {
+        return name;
+    }
+    name += "(";
+    for (unsigned i = 0; i < FD->getNumParams(); ++i) {
+        if (i != 0) name += ", ";
+        name += FD->getParamDecl(i)->getType().getAsString();
+    }
+    name += ")";
+    if (auto* MD = llvm::dyn_cast<clang::CXXMethodDecl>(FD); MD && MD->isConst()) {
+        name += " const";
+    }
+    return name;
+}
+
+// Function names are used as file names where they are safe ones. Others
+// (operators, overloads) get the unsafe characters replaced and a hash of
+// the full name appended, so that they still differ.
+static std::string dotFileName(const std::string& funcName, const char* suffix) {
+    std::string stem = funcName;
+    bool replaced = false;
+    for (char& c : stem) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && !std::strchr("_:.~-", c)) {
+            c = '_';
+            replaced = true;
+        }
+    }
+    if (replaced) {
+        stem += "-" + llvm::utohexstr(llvm::xxHash64(funcName) & 0xffffffffu, /*LowerCase=*/true);
+    }
+    return stem + suffix;
+}
+
+static json metricsToJson(const GraphGenerator::FunctionMetrics& metrics) {
+    // fanOut is left out: call dependencies are collected again every run.
+    return {
+        {"blocks", metrics.blocks},
+        {"edges", metrics.edges},
+        {"exceptionEdges", metrics.exceptionEdges},
+        {"cyclomaticComplexity", metrics.cyclomaticComplexity},
+        {"maxLoopDepth", metrics.maxLoopDepth},
+        {"maxNesting", metrics.maxNesting}
+    };
+}
+
+static GraphGenerator::FunctionMetrics metricsFromJson(const json& entry) {
+    GraphGenerator::FunctionMetrics metrics;
+    metrics.blocks = entry.value("blocks", 0u);
+    metrics.edges = entry.value("edges", 0u);
+    metrics.exceptionEdges = entry.value("exceptionEdges", 0u);
+    metrics.cyclomaticComplexity = entry.value("cyclomaticComplexity", 0);
+    metrics.maxLoopDepth = entry.value("maxLoopDepth", 0u);
+    metrics.maxNesting = entry.value("maxNesting", 0u);
+    return metrics;
+}
+
+static json planToJson(const GraphGenerator::InstrumentationPlan& plan) {
+    return {
+        {"edges", plan.edges},
+        {"counters", plan.counters},
+        {"paths", plan.paths},
+        {"pathIncrements", plan.pathIncrements},
+        {"loopEdges", plan.loopEdges},
+        {"pathEnds", plan.pathEnds}
+    };
+}
+
+static GraphGenerator::InstrumentationPlan planFromJson(const json& entry) {
+    GraphGenerator::InstrumentationPlan plan;
+    plan.edges = entry.value("edges", 0u);
+    plan.counters = entry.value("counters", plan.counters);
+    plan.paths = entry.value("paths", uint64_t{0});
+    plan.pathIncrements = entry.value("pathIncrements", plan.pathIncrements);
+    plan.loopEdges = entry.value("loopEdges", plan.loopEdges);
+    plan.pathEnds = entry.value("pathEnds", plan.pathEnds);
+    return plan;
+}
+
+static json pathsToJson(const GraphGenerator::PathSummary& paths) {
+    return {
+        {"count", paths.count},
+        {"hottest", paths.heaviest}
+    };
+}
+
+static GraphGenerator::PathSummary pathsFromJson(const json& entry) {
+    GraphGenerator::PathSummary paths;
+    paths.count = entry.value("count", std::string());
+    paths.heaviest = entry.value("hottest", paths.heaviest);
+    return paths;
+}
+
+// Hottest paths kept per function.
+static constexpr size_t HotPathCount = 3;
+
 CFGVisitor::CFGVisitor(clang::ASTContext* Context,
                      const std::string& outputDir,
                      AnalysisResult& results)
     : Context(Context), 
       OutputDir(outputDir), 
-      m_results(results) 
+      m_results(results),
+      Session(std::make_shared<GraphGenerator::AnalysisSession>())
 {
     if (!llvm::sys::fs::exists(outputDir)) {
         llvm::sys::fs::create_directory(outputDir);
     }
+    LoadFingerprintCache();
+}
+
+void CFGVisitor::LoadFingerprintCache() {
+    std::ifstream cacheFile(OutputDir + "/cfg_cache.json");
+    if (!cacheFile.is_open()) return;
+
+    json cache = json::parse(cacheFile, nullptr, /*allow_exceptions=*/false);
+    if (!cache.is_object() || !cache["functions"].is_object()) {
+        llvm::errs() << "Ignoring malformed fingerprint cache in " << OutputDir << "\n";
+        return;
+    }
+
+    // Version 1 caches were keyed by name, and DOT written by another
+    // exporter version may be stale; their functions are rebuilt.
+    if (cache.value("version", 0) == 2 && cache.value("dotFormat", 0) == Visualizer::DotFormatVersion) {
+        for (const auto& [key, entry] : cache["functions"].items()) {
+            if (entry.contains("fingerprint") && entry["fingerprint"].is_number_unsigned()) {
+                PreviousEntries[key] = entry;
+            }
+        }
+    }
+    PreviousCorpus = GraphGenerator::CFGCorpus::open(OutputDir + "/cfg_corpus.bin");
+}
+
+void CFGVisitor::SaveFingerprintCache() const {
+    json cache;
+    cache["version"] = 2;
+    cache["dotFormat"] = Visualizer::DotFormatVersion;
+    cache["functions"] = json::object();
+    for (const auto& [funcName, fingerprint] : m_results.functionFingerprints) {
+        json entry = {
+            {"name", funcName},
+            {"fingerprint", fingerprint},
+            {"dot", dotFileName(funcName, "_cfg.dot")}
+        };
+        auto span = m_results.functionSpans.find(funcName);
+        if (span != m_results.functionSpans.end()) {
+            entry["file"] = span->second.file;
+        }
+        auto idom = m_results.immediateDominators.find(funcName);
+        if (idom != m_results.immediateDominators.end()) {
+            entry["idom"] = idom->second;
+        }
+        auto ipdom = m_results.immediatePostDominators.find(funcName);
+        if (ipdom != m_results.immediatePostDominators.end()) {
+            entry["ipdom"] = ipdom->second;
+        }
+        auto cdeps = m_results.controlDependence.find(funcName);
+        if (cdeps != m_results.controlDependence.end()) {
+            entry["cdeps"] = cdeps->second;
+        }
+        auto metrics = m_results.functionMetrics.find(funcName);
+        if (metrics != m_results.functionMetrics.end()) {
+            entry["metrics"] = metricsToJson(metrics->second);
+        }
+        auto shapeHash = m_results.functionShapeHashes.find(funcName);
+        if (shapeHash != m_results.functionShapeHashes.end()) {
+            entry["shapeHash"] = shapeHash->second;
+        }
+        auto usr = m_results.functionUSRs.find(funcName);
+        if (usr != m_results.functionUSRs.end()) {
+            entry["usr"] = usr->second;
+        }
+        auto unreachable = m_results.unreachableBlocks.find(funcName);
+        if (unreachable != m_results.unreachableBlocks.end()) {
+            entry["unreachable"] = unreachable->second;
+        }
+        auto probes = m_results.instrumentationPlans.find(funcName);
+        if (probes != m_results.instrumentationPlans.end()) {
+            entry["probes"] = planToJson(probes->second);
+        }
+        auto paths = m_results.pathSummaries.find(funcName);
+        if (paths != m_results.pathSummaries.end()) {
+            entry["paths"] = pathsToJson(paths->second);
+        }
+        cache["functions"][CacheKey(funcName)] = std::move(entry);
+    }
+    // Functions of other files analyzed into the same directory keep their
+    // entries; those of this file that are gone lose theirs.
+    const std::string mainFile = MainFileName();
+    for (const auto& [key, entry] : PreviousEntries) {
+        if (!cache["functions"].contains(key) && entry.value("file", std::string()) != mainFile) {
+            cache["functions"][key] = entry;
+        }
+    }
+
+    std::ofstream cacheFile(OutputDir + "/cfg_cache.json");
+    if (!cacheFile.is_open()) {
+        llvm::errs() << "Could not write fingerprint cache to " << OutputDir << "\n";
+        return;
+    }
+    cacheFile << cache.dump(2);
+}
+
+std::string CFGVisitor::CacheKey(const std::string& funcName) const {
+    auto usr = m_results.functionUSRs.find(funcName);
+    return usr != m_results.functionUSRs.end() ? usr->second : funcName;
+}
+
+std::string CFGVisitor::MainFileName() const {
+    const clang::SourceManager& SM = Context->getSourceManager();
+    if (clang::OptionalFileEntryRef file = SM.getFileEntryRefForID(SM.getMainFileID())) {
+        return file->getName().str();
+    }
+    return {};
 }
 
 bool CFGVisitor::VisitFunctionDecl(clang::FunctionDecl* FD) {
-    if (!FD || !FD->hasBody()) return true;
+    // hasBody() is also true of a prototype whose definition comes later,
+    // which would visit (and export) the function twice.
+    if (!FD || !FD->doesThisDeclarationHaveABody()) return true;
     
     clang::SourceManager& SM = Context->getSourceManager();
     if (!SM.isInMainFile(FD->getLocation())) return true;
     
-    std::string funcName = FD->getQualifiedNameAsString();
+    std::string funcName = functionName(FD);
     CurrentFunction = funcName;
     FunctionDependencies[funcName] = std::set<std::string>();
     
-    std::string funcFilename = OutputDir + "/" + funcName + "_cfg.dot";
-    auto cfgGraph = GraphGenerator::generateCFG(FD);
+    std::string funcFilename = OutputDir + "/" + dotFileName(funcName, "_cfg.dot");
+
+    llvm::SmallString<128> usr;
+    if (!clang::index::generateUSRForDecl(FD, usr)) {
+        m_results.functionUSRs[funcName] = std::string(usr);
+    }
+    if (FD->isExternallyVisible()) {
+        m_results.exportedFunctions.insert(funcName);
+    }
+    if (auto* MD = llvm::dyn_cast<clang::CXXMethodDecl>(FD); MD && MD->isVirtual()) {
+        m_results.indirectlyCalledFunctions.insert(funcName);
+    }
+    const clang::PresumedLoc begin = SM.getPresumedLoc(FD->getBeginLoc());
+    const clang::PresumedLoc end = SM.getPresumedLoc(FD->getEndLoc());
+    if (begin.isValid() && end.isValid()) {
+        m_results.functionSpans[funcName] = {MainFileName(), begin.getLine(), begin.getColumn(),
+                                             end.getLine(), end.getColumn()};
+    }
+
+    // Unchanged bodies keep the outputs written by the previous run; only
+    // the call dependencies (collected by VisitCallExpr) are refreshed.
+    uint64_t fingerprint = GraphGenerator::computeBodyFingerprint(FD);
+    m_results.functionFingerprints[funcName] = fingerprint;
+    auto previous = PreviousEntries.find(CacheKey(funcName));
+    if (previous != PreviousEntries.end() && previous->second["fingerprint"] == fingerprint &&
+        llvm::sys::fs::exists(funcFilename)) {
+        ++m_results.reusedFunctions;
+        const json& entry = previous->second;
+        if (entry.contains("idom") && entry.contains("ipdom")) {
+            m_results.immediateDominators[funcName] = entry["idom"].get<std::vector<std::pair<int, int>>>();
+            m_results.immediatePostDominators[funcName] = entry["ipdom"].get<std::vector<std::pair<int, int>>>();
+        }
+        if (entry.contains("cdeps") && entry["cdeps"].is_array()) {
+            m_results.controlDependence[funcName] = entry["cdeps"].get<std::vector<std::pair<int, int>>>();
+        }
+        if (entry.contains("metrics") && entry["metrics"].is_object()) {
+            m_results.functionMetrics[funcName] = metricsFromJson(entry["metrics"]);
+        }
+        if (entry.contains("shapeHash") && entry["shapeHash"].is_number_unsigned()) {
+            m_results.functionShapeHashes[funcName] = entry["shapeHash"].get<uint64_t>();
+        }
+        if (entry.contains("unreachable") && entry["unreachable"].is_array()) {
+            m_results.unreachableBlocks[funcName] = entry["unreachable"].get<std::vector<int>>();
+        }
+        if (entry.contains("probes") && entry["probes"].is_object()) {
+            m_results.instrumentationPlans[funcName] = planFromJson(entry["probes"]);
+        }
+        if (entry.contains("paths") && entry["paths"].is_object()) {
+            m_results.pathSummaries[funcName] = pathsFromJson(entry["paths"]);
+        }
+        // Clone detection still needs the graph of an unchanged function,
+        // with its AST. Otherwise the corpus only needs the graph, which the
+        // previous corpus usually still holds.
+        if (m_results.cloneIndex) {
+            if (auto cfgGraph = GraphGenerator::generateCFG(FD, Session)) {
+                FunctionGraphs.emplace_back(funcName, cfgGraph->freeze());
+                UnchangedFunctions.insert(funcName);
+            }
+        } else if (auto stored = PreviousCorpus ? PreviousCorpus->graph(CacheKey(funcName)) : nullptr) {
+            ReusedGraphs.emplace_back(funcName, std::move(stored));
+        } else if (auto cfgGraph = GraphGenerator::generateCFG(FD, Session)) {
+            ReusedGraphs.emplace_back(funcName, cfgGraph->freeze());
+        }
+        return true;
+    }
+
+    // Its DOT is written by FinalizeCombinedFile, with the analyses there.
+    auto cfgGraph = GraphGenerator::generateCFG(FD, Session);
     if (cfgGraph) {
-        Visualizer::exportToDot(cfgGraph.get(), funcFilename);
+        FunctionGraphs.emplace_back(funcName, cfgGraph->freeze());
     }
     
     return true;
@@ -52,8 +345,23 @@ bool CFGVisitor::VisitFunctionDecl(clang::FunctionDecl* FD) {
 bool CFGVisitor::VisitCallExpr(clang::CallExpr* CE) {
     if (!CurrentFunction.empty() && CE) {
         if (auto* CalledFunc = CE->getDirectCallee()) {
-            FunctionDependencies[CurrentFunction].insert(
-                CalledFunc->getQualifiedNameAsString());
+            FunctionDependencies[CurrentFunction].insert(functionName(CalledFunc));
+        }
+    }
+    // Calls are visited before their callee expression, so the reference
+    // below can tell a call from a function whose address escapes.
+    if (CE) {
+        if (auto* Callee = llvm::dyn_cast<clang::DeclRefExpr>(CE->getCallee()->IgnoreParenImpCasts())) {
+            CalleeReferences.insert(Callee);
+        }
+    }
+    return true;
+}
+
+bool CFGVisitor::VisitDeclRefExpr(clang::DeclRefExpr* DRE) {
+    if (auto* FD = llvm::dyn_cast<clang::FunctionDecl>(DRE->getDecl())) {
+        if (!CalleeReferences.count(DRE)) {
+            m_results.indirectlyCalledFunctions.insert(functionName(FD));
         }
     }
     return true;
@@ -85,6 +393,120 @@ void CFGVisitor::FinalizeCombinedFile() {
     }
     
     m_results.functionDependencies = FunctionDependencies;
+
+    // Dominator trees for every function rebuilt in this run, in parallel.
+    std::vector<std::shared_ptr<const GraphGenerator::CSRGraph>> graphs;
+    graphs.reserve(FunctionGraphs.size());
+    for (const auto& [funcName, graph] : FunctionGraphs) {
+        graphs.push_back(graph);
+    }
+    std::vector<GraphGenerator::FunctionDominators> dominators = GraphGenerator::computeDominatorsBatch(graphs);
+    std::vector<GraphGenerator::LoopForest> loops = GraphGenerator::buildLoopForestsBatch(graphs);
+    std::vector<GraphGenerator::FunctionMetrics> metrics = GraphGenerator::computeMetricsBatch(graphs, dominators, loops);
+    for (size_t i = 0; i < FunctionGraphs.size(); ++i) {
+        const auto& [funcName, graph] = FunctionGraphs[i];
+        m_results.immediateDominators[funcName] = GraphGenerator::idomBlockPairs(*graph, dominators[i].dominators);
+        m_results.immediatePostDominators[funcName] = GraphGenerator::idomBlockPairs(*graph, dominators[i].postDominators);
+        const GraphGenerator::ControlDependence controlDependence =
+            GraphGenerator::ControlDependence::build(*graph, dominators[i].postDominators);
+        m_results.controlDependence[funcName] = GraphGenerator::controlDependencePairs(*graph, controlDependence);
+        m_results.functionMetrics[funcName] = metrics[i];
+        const uint64_t shapeHash = GraphGenerator::computeStructuralHash(*graph);
+        m_results.functionShapeHashes[funcName] = shapeHash;
+        const std::vector<double> probabilities = GraphGenerator::estimateBranchProbabilities(*graph, loops[i]);
+        const std::vector<double> frequencies = GraphGenerator::estimateBlockFrequencies(*graph, loops[i], probabilities);
+        m_results.instrumentationPlans[funcName] = GraphGenerator::planInstrumentation(
+            *graph, loops[i], GraphGenerator::edgeFrequencies(*graph, frequencies, probabilities));
+        m_results.pathSummaries[funcName] = GraphGenerator::summarizePaths(
+            *graph, loops[i], HotPathCount, [&](GraphGenerator::CSRGraph::Index n) { return frequencies[n]; });
+        const std::vector<GraphGenerator::CSRGraph::Index> unreachable = GraphGenerator::unreachableBlocks(*graph);
+        if (!unreachable.empty()) {
+            std::vector<int>& ids = m_results.unreachableBlocks[funcName];
+            for (GraphGenerator::CSRGraph::Index n : unreachable) {
+                ids.push_back(graph->blockId(n));
+            }
+        }
+        if (!UnchangedFunctions.count(funcName)) {
+            Visualizer::GraphAnalyses analyses;
+            analyses.loops = &loops[i];
+            analyses.frequencies = frequencies;
+            analyses.controlDependence = &controlDependence;
+            analyses.shapeHash = shapeHash;
+            Visualizer::exportToDot(graph, OutputDir + "/" + dotFileName(funcName, "_cfg.dot"), analyses);
+        }
+    }
+
+    // Fan-out is refreshed for reused functions too, and the table is
+    // written sorted by name so runs diff cleanly.
+    GraphGenerator::MetricsTable table;
+    table.reserve(m_results.functionMetrics.size());
+    for (auto& [funcName, functionMetrics] : m_results.functionMetrics) {
+        auto deps = FunctionDependencies.find(funcName);
+        functionMetrics.fanOut = deps != FunctionDependencies.end() ? static_cast<uint32_t>(deps->second.size()) : 0;
+        table.emplace_back(funcName, functionMetrics);
+    }
+    std::sort(table.begin(), table.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    if (!GraphGenerator::writeMetricsCSV(OutputDir + "/cfg_metrics.csv", table) ||
+        !GraphGenerator::writeMetricsTable(OutputDir + "/cfg_metrics.bin", table)) {
+        llvm::errs() << "Could not write metrics tables to " << OutputDir << "\n";
+    }
+    GraphGenerator::ControlDependenceTable dependenceTable(m_results.controlDependence.begin(),
+                                                           m_results.controlDependence.end());
+    std::sort(dependenceTable.begin(), dependenceTable.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    if (!GraphGenerator::writeControlDependenceTable(OutputDir + "/cfg_control_dependence.bin", dependenceTable)) {
+        llvm::errs() << "Could not write control dependence table to " << OutputDir << "\n";
+    }
+
+    // Every function of this translation unit, rebuilt or unchanged, goes
+    // into the corpus; as in the cache, the previous corpus's functions of
+    // other files are carried over. It stays mapped until the new corpus
+    // replaces it.
+    GraphGenerator::CorpusWriter corpus;
+    std::unordered_set<std::string> corpusKeys;
+    for (const auto* list : {&FunctionGraphs, &ReusedGraphs}) {
+        for (const auto& [funcName, graph] : *list) {
+            auto span = m_results.functionSpans.find(funcName);
+            std::string key = CacheKey(funcName);
+            corpusKeys.insert(key);
+            corpus.addFunction(funcName, graph, span != m_results.functionSpans.end() ? span->second : GraphGenerator::SourceSpan{},
+                               std::move(key));
+        }
+    }
+    if (PreviousCorpus) {
+        const std::string mainFile = MainFileName();
+        for (size_t i = 0; i < PreviousCorpus->size(); ++i) {
+            GraphGenerator::SourceSpan span = PreviousCorpus->span(i);
+            std::string key(PreviousCorpus->key(i));
+            if (span.file == mainFile || !corpusKeys.insert(key).second) continue;
+            if (auto graph = PreviousCorpus->graph(i)) {
+                corpus.addFunction(std::string(PreviousCorpus->name(i)), std::move(graph), std::move(span), std::move(key));
+            }
+        }
+    }
+    if (!corpus.write(OutputDir + "/cfg_corpus.bin")) {
+        llvm::errs() << "Could not write CFG corpus to " << OutputDir << "\n";
+    }
+
+    // Names carry the file so that equally named functions of different
+    // translation units stay apart.
+    if (m_results.cloneIndex) {
+        const std::string fileName = MainFileName();
+        std::vector<std::string> names;
+        names.reserve(FunctionGraphs.size());
+        for (const auto& [funcName, graph] : FunctionGraphs) {
+            names.push_back(fileName + ":" + funcName);
+        }
+        m_results.cloneIndex->addFunctions(names, graphs);
+    }
+
+    SaveFingerprintCache();
+
+    const GraphGenerator::AllocationStats stats = Session->stats();
+    m_results.arenaAllocations += stats.arenaAllocations;
+    m_results.upstreamAllocations += stats.upstreamAllocations;
+    m_results.arenaBytes += stats.arenaBytes;
 }
 
 CFGConsumer::CFGConsumer(clang::ASTContext* Context,
@@ -106,8 +528,7 @@ std::unique_ptr<clang::ASTConsumer> CFGAction::CreateASTConsumer(
     return std::make_unique<CFGConsumer>(&CI.getASTContext(), OutputDir, m_results);
 }
 
-AnalysisResult CFGAnalyzer::analyze(const std::string& filename) {
-    AnalysisResult result;
+int CFGAnalyzer::runTool(const std::vector<std::string>& sources, AnalysisResult& result) {
     std::vector<std::string> CommandLine = {
         "-std=c++17",
         "-I.",
@@ -119,11 +540,10 @@ AnalysisResult CFGAnalyzer::analyze(const std::string& filename) {
         ".", CommandLine);
     if (!Compilations) {
         result.report = "Failed to create compilation database";
-        return result;
+        return -1;
     }
 
-    std::vector<std::string> Sources{filename};
-    clang::tooling::ClangTool Tool(*Compilations, Sources);
+    clang::tooling::ClangTool Tool(*Compilations, sources);
 
     class CFGActionFactory : public clang::tooling::FrontendActionFactory {
     public:
@@ -138,8 +558,16 @@ AnalysisResult CFGAnalyzer::analyze(const std::string& filename) {
     };
 
     CFGActionFactory factory(m_results);
-    int ToolResult = Tool.run(&factory);
-    
+    return Tool.run(&factory);
+}
+
+AnalysisResult CFGAnalyzer::analyze(const std::string& filename) {
+    AnalysisResult result;
+    m_results = AnalysisResult{};
+    int ToolResult = runTool({filename}, result);
+    if (ToolResult < 0) {
+        return result;
+    }
     if (ToolResult != 0) {
         result.report = "Analysis failed with code: " + std::to_string(ToolResult);
         return result;
@@ -148,6 +576,11 @@ AnalysisResult CFGAnalyzer::analyze(const std::string& filename) {
     // Generate outputs
     {
         QMutexLocker locker(&m_analysisMutex);
+        m_results.deadFunctions = GraphGenerator::findDeadFunctions(
+            m_results.functionDependencies, m_callGraphRoots,
+            m_results.exportedFunctions, m_results.indirectlyCalledFunctions);
+        // Callers (and the JSON of analyzeFile) read the per-function results too.
+        result = m_results;
         result.dotOutput = generateDotOutput(m_results);
         result.report = generateReport(m_results);
         result.success = true;
@@ -156,6 +589,91 @@ AnalysisResult CFGAnalyzer::analyze(const std::string& filename) {
     return result;
 }
 
+AnalysisResult CFGAnalyzer::findClones(const std::vector<std::string>& filenames,
+                                       const GraphGenerator::CloneDetectionOptions& options) {
+    AnalysisResult result;
+    m_results = AnalysisResult{};
+    m_results.cloneIndex = std::make_shared<GraphGenerator::CloneIndex>(options);
+    int ToolResult = runTool(filenames, result);
+    if (ToolResult < 0) {
+        return result;
+    }
+    // ClangTool reports failure if any file failed; the others still count.
+    if (ToolResult != 0) {
+        llvm::errs() << "Some files could not be analyzed; clone groups cover the rest\n";
+    }
+
+    QMutexLocker locker(&m_analysisMutex);
+    const GraphGenerator::CloneIndex& index = *m_results.cloneIndex;
+    const std::vector<GraphGenerator::CloneGroup> groups = index.findGroups();
+
+    std::stringstream report;
+    report << "Clone Detection Report\n";
+    report << "Generated: " << getCurrentDateTime() << "\n";
+    report << "Functions compared: " << index.size() << " in " << filenames.size() << " files\n";
+    report << "Clone groups: " << groups.size() << "\n\n";
+
+    json j;
+    j["timestamp"] = getCurrentDateTime();
+    j["functions"] = index.size();
+    j["groups"] = json::array();
+    for (size_t g = 0; g < groups.size(); ++g) {
+        report << "Group " << g + 1 << " (" << groups[g].functions.size() << " functions):\n";
+        json members = json::array();
+        for (size_t i = 0; i < groups[g].functions.size(); ++i) {
+            const std::string& name = index.name(groups[g].functions[i]);
+            report << "  " << name << " (similarity " << std::fixed << std::setprecision(2)
+                   << groups[g].similarity[i] << ")\n";
+            members.push_back({{"name", name}, {"similarity", groups[g].similarity[i]}});
+        }
+        j["groups"].push_back(std::move(members));
+        report << "\n";
+    }
+
+    result.report = report.str();
+    result.jsonOutput = j.dump(2);
+    result.success = true;
+    return result;
+}
+
+AnalysisResult CFGAnalyzer::compareRuns(const std::string& beforeDir, const std::string& afterDir) {
+    AnalysisResult result;
+    if (!llvm::sys::fs::exists(beforeDir + "/cfg_cache.json") || !llvm::sys::fs::exists(afterDir + "/cfg_cache.json")) {
+        result.report = "Both directories need a cfg_cache.json from a previous analysis";
+        return result;
+    }
+    const std::vector<GraphGenerator::FunctionDiff> diffs = GraphGenerator::diffRuns(beforeDir, afterDir);
+
+    static const char* const statusNames[] = {"unchanged", "added", "removed", "changed"};
+    json j;
+    j["timestamp"] = getCurrentDateTime();
+    j["functions"] = json::array();
+    for (const GraphGenerator::FunctionDiff& diff : diffs) {
+        if (diff.status == GraphGenerator::DiffStatus::Unchanged) continue;
+        json function = {{"name", diff.name}, {"status", statusNames[static_cast<int>(diff.status)]}};
+        if (!diff.dot.empty()) {
+            const std::string dotFile = dotFileName(diff.name, "_diff.dot");
+            std::ofstream out(afterDir + "/" + dotFile);
+            if (out.is_open()) {
+                out << diff.dot;
+                function["dot"] = dotFile;
+            } else {
+                llvm::errs() << "Could not write " << dotFile << " to " << afterDir << "\n";
+            }
+            function["blocks"] = {{"added", diff.graph.addedBlocks.size()},
+                                  {"removed", diff.graph.removedBlocks.size()},
+                                  {"changed", diff.graph.changedBlocks.size()}};
+            function["edges"] = {{"added", diff.graph.addedEdges}, {"removed", diff.graph.removedEdges}};
+        }
+        j["functions"].push_back(std::move(function));
+    }
+
+    result.report = "CFG Diff Report\nGenerated: " + getCurrentDateTime() + "\n" + GraphGenerator::formatDiffReport(diffs);
+    result.jsonOutput = j.dump(2);
+    result.success = true;
+    return result;
+}
+
 std::string CFGAnalyzer::generateDotOutput(const AnalysisResult& result) const {
     std::stringstream dotStream;
     dotStream << "digraph FunctionDependencies {\n"
@@ -194,8 +712,29 @@ AnalysisResult CFGAnalyzer::analyzeFile(const QString& filePath) {
             json function;
             function["name"] = func;
             function["calls"] = calls;
+            auto shapeHash = result.functionShapeHashes.find(func);
+            if (shapeHash != result.functionShapeHashes.end()) {
+                function["shapeHash"] = GraphGenerator::formatStructuralHash(shapeHash->second);
+            }
+            auto cdeps = result.controlDependence.find(func);
+            if (cdeps != result.controlDependence.end()) {
+                function["controlDependence"] = cdeps->second;
+            }
+            auto unreachable = result.unreachableBlocks.find(func);
+            if (unreachable != result.unreachableBlocks.end()) {
+                function["unreachableBlocks"] = unreachable->second;
+            }
+            auto probes = result.instrumentationPlans.find(func);
+            if (probes != result.instrumentationPlans.end()) {
+                function["instrumentation"] = planToJson(probes->second);
+            }
+            auto paths = result.pathSummaries.find(func);
+            if (paths != result.pathSummaries.end()) {
+                function["paths"] = pathsToJson(paths->second);
+            }
             j["functions"].push_back(function);
         }
+        j["deadFunctions"] = result.deadFunctions;
         
         result.jsonOutput = j.dump(2);
     }
@@ -222,7 +761,103 @@ std::string CFGAnalyzer::getCurrentDateTime() {
 std::string CFGAnalyzer::generateReport(const AnalysisResult& result) const {
     std::stringstream report;
     report << "CFG Analysis Report\n";
-    report << "Generated: " << getCurrentDateTime() << "\n\n";
+    report << "Generated: " << getCurrentDateTime() << "\n";
+    report << "Functions reused from cache: " << result.reusedFunctions
+           << " of " << result.functionFingerprints.size() << "\n";
+    report << "Graph allocations: " << result.arenaAllocations << " from the session arena in "
+           << result.upstreamAllocations << " heap blocks (" << result.arenaBytes / 1024 << " KiB)\n\n";
+
+    if (!result.functionMetrics.empty()) {
+        std::vector<std::pair<std::string, GraphGenerator::FunctionMetrics>> ranked(
+            result.functionMetrics.begin(), result.functionMetrics.end());
+        std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+            return a.second.cyclomaticComplexity != b.second.cyclomaticComplexity
+                ? a.second.cyclomaticComplexity > b.second.cyclomaticComplexity
+                : a.first < b.first;
+        });
+        report << "Structural Metrics (by cyclomatic complexity):\n";
+        for (const auto& [funcName, m] : ranked) {
+            report << "  " << funcName << ": complexity " << m.cyclomaticComplexity
+                   << ", " << m.blocks << " blocks, " << m.edges << " edges ("
+                   << m.exceptionEdges << " exception), loop depth " << m.maxLoopDepth
+                   << ", nesting " << m.maxNesting << ", fan-out " << m.fanOut << "\n";
+        }
+        report << "\n";
+    }
+
+    // Functions sharing a shape hash are candidates for de-duplication.
+    std::map<uint64_t, std::vector<std::string>> byShape;
+    for (const auto& [funcName, hash] : result.functionShapeHashes) {
+        byShape[hash].push_back(funcName);
+    }
+    bool hasDuplicates = false;
+    for (auto& [hash, names] : byShape) {
+        if (names.size() < 2) continue;
+        if (!hasDuplicates) {
+            report << "Structurally Identical Functions:\n";
+            hasDuplicates = true;
+        }
+        std::sort(names.begin(), names.end());
+        report << "  " << GraphGenerator::formatStructuralHash(hash) << ":";
+        for (const auto& name : names) {
+            report << " " << name;
+        }
+        report << "\n";
+    }
+    if (hasDuplicates) {
+        report << "\n";
+    }
+
+    if (!result.deadFunctions.empty()) {
+        report << "Dead Functions (reached from no root):\n";
+        for (const auto& name : result.deadFunctions) {
+            report << "  " << name << "\n";
+        }
+        report << "\n";
+    }
+    if (!result.unreachableBlocks.empty()) {
+        std::map<std::string, std::vector<int>> sorted(result.unreachableBlocks.begin(), result.unreachableBlocks.end());
+        report << "Unreachable Blocks:\n";
+        for (const auto& [funcName, blocks] : sorted) {
+            report << "  " << funcName << ":";
+            for (int block : blocks) {
+                report << " " << block;
+            }
+            report << "\n";
+        }
+        report << "\n";
+    }
+    if (!result.instrumentationPlans.empty()) {
+        std::map<std::string, GraphGenerator::InstrumentationPlan> sorted(result.instrumentationPlans.begin(),
+                                                                          result.instrumentationPlans.end());
+        report << "Instrumentation Plan:\n";
+        for (const auto& [funcName, plan] : sorted) {
+            report << "  " << funcName << ": " << plan.counters.size() << " counters for "
+                   << plan.edges << " edges, ";
+            if (plan.paths != 0) {
+                report << plan.paths << " acyclic paths\n";
+            } else {
+                report << "too many paths to number\n";
+            }
+        }
+        report << "\n";
+    }
+    if (!result.pathSummaries.empty()) {
+        std::map<std::string, GraphGenerator::PathSummary> sorted(result.pathSummaries.begin(),
+                                                                  result.pathSummaries.end());
+        report << "Hottest Paths (by estimated block frequency):\n";
+        for (const auto& [funcName, paths] : sorted) {
+            report << "  " << funcName << ": " << paths.count << " acyclic paths";
+            if (!paths.heaviest.empty()) {
+                report << ", hottest";
+                for (size_t i = 0; i < paths.heaviest[0].size(); ++i) {
+                    report << (i ? " -> " : " ") << paths.heaviest[0][i];
+                }
+            }
+            report << "\n";
+        }
+        report << "\n";
+    }
     report << "Function Dependencies:\n";
     
     for (const auto& [caller, callees] : result.functionDependencies) {
@@ -0,0 +1,380 @@
+#include "cfg_corpus.h"
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+namespace GraphGenerator {
+
+namespace {
+
+constexpr char CorpusMagic[4] = {'C', 'F', 'G', 'G'};
+constexpr uint32_t CorpusVersion = 2;
+constexpr char Padding[8] = {};
+
+enum RecordFlags : uint32_t {
+    RecordDenseIds = 1u << 0,
+    RecordDefUse   = 1u << 1,
+};
+
+struct CorpusHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t functionCount;
+    uint32_t hashSlots;
+    uint64_t strings;
+    uint64_t stringBytes;
+    uint64_t fileSize;
+};
+
+struct FunctionRecord {
+    uint64_t data;          // offset of the function's arrays
+    uint64_t dataBytes;
+    uint32_t name;          // offsets and lengths in the string blob
+    uint32_t nameLength;
+    uint32_t key;
+    uint32_t keyLength;
+    uint32_t file;
+    uint32_t fileLength;
+    uint32_t beginLine;
+    uint32_t beginColumn;
+    uint32_t endLine;
+    uint32_t endColumn;
+    uint32_t nodes;
+    uint32_t edges;
+    uint32_t statements;
+    uint32_t strings;
+    uint32_t stringBytes;
+    uint32_t variables;
+    uint32_t definitions;
+    uint32_t uses;
+    uint32_t blockDefinitions;
+    uint32_t blockUses;
+    uint32_t entry;
+    uint32_t exit;
+    uint32_t flags;         // RecordFlags
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CorpusHeader) % 8 == 0 && sizeof(FunctionRecord) % 8 == 0,
+              "corpus sections must stay 8-byte aligned");
+
+uint64_t align8(uint64_t bytes) {
+    return (bytes + 7) & ~uint64_t(7);
+}
+
+uint64_t hashName(std::string_view name) {
+    uint64_t hash = 1469598103934665603ull;
+    for (char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+using ElementOf = typename std::remove_const_t<std::remove_reference_t<T>>::value_type;
+
+} // namespace
+
+// Reads and writes the CSRGraph arrays, which only friends may reach.
+class CorpusCodec {
+public:
+    // The arrays of one function in file order. The writer and the reader
+    // both walk this list, so it is the layout.
+    template <typename Graph, typename Visit>
+    static void sections(Graph& graph, const FunctionRecord& record, Visit&& visit) {
+        visit(graph.m_ids, record.nodes);
+        visit(graph.m_offsets, record.nodes + 1);
+        visit(graph.m_targets, record.edges);
+        visit(graph.m_edgeFlags, record.edges);
+        visit(graph.m_predOffsets, record.nodes + 1);
+        visit(graph.m_predSources, record.edges);
+        visit(graph.m_predEdges, record.edges);
+        visit(graph.m_attributes, record.nodes);
+        visit(graph.m_labels, record.nodes);
+        visit(graph.m_stmtOffsets, record.nodes + 1);
+        visit(graph.m_stmtStrings, record.statements);
+        visit(graph.m_stringOffsets, record.strings + 1);
+        visit(graph.m_stringData, record.stringBytes);
+        if (record.flags & RecordDefUse) {
+            visit(graph.m_varNames, record.variables);
+            visit(graph.m_defOffsets, record.variables + 1);
+            visit(graph.m_defSites, record.definitions);
+            visit(graph.m_useOffsets, record.variables + 1);
+            visit(graph.m_useSites, record.uses);
+            visit(graph.m_blockDefOffsets, record.nodes + 1);
+            visit(graph.m_blockDefVars, record.blockDefinitions);
+            visit(graph.m_blockUseOffsets, record.nodes + 1);
+            visit(graph.m_blockUseVars, record.blockUses);
+        }
+    }
+
+    // A copy of `graph` whose string table is in offsets-and-blob form,
+    // with `offsets` and `data` as backing when it had to be converted.
+    static CSRGraph packStrings(const CSRGraph& graph, std::vector<uint32_t>& offsets, std::vector<char>& data) {
+        CSRGraph packed = graph;
+        if (!graph.m_stringOffsets.empty()) return packed;
+        offsets.reserve(graph.m_strings.size() + 1);
+        for (std::string_view text : graph.m_strings) {
+            offsets.push_back(static_cast<uint32_t>(data.size()));
+            data.insert(data.end(), text.begin(), text.end());
+        }
+        offsets.push_back(static_cast<uint32_t>(data.size()));
+        packed.m_stringOffsets = offsets;
+        packed.m_stringData = data;
+        return packed;
+    }
+
+    static void fillCounts(const CSRGraph& graph, FunctionRecord& record) {
+        record.nodes = static_cast<uint32_t>(graph.nodeCount());
+        record.edges = static_cast<uint32_t>(graph.edgeCount());
+        record.statements = static_cast<uint32_t>(graph.m_stmtStrings.size());
+        record.strings = static_cast<uint32_t>(graph.m_stringOffsets.size() - 1);
+        record.stringBytes = static_cast<uint32_t>(graph.m_stringData.size());
+        record.variables = static_cast<uint32_t>(graph.m_varNames.size());
+        record.definitions = static_cast<uint32_t>(graph.m_defSites.size());
+        record.uses = static_cast<uint32_t>(graph.m_useSites.size());
+        record.blockDefinitions = static_cast<uint32_t>(graph.m_blockDefVars.size());
+        record.blockUses = static_cast<uint32_t>(graph.m_blockUseVars.size());
+        record.entry = graph.m_entry;
+        record.exit = graph.m_exit;
+        record.flags = (graph.m_denseIds ? uint32_t(RecordDenseIds) : 0u) |
+                       (graph.m_defOffsets.empty() ? 0u : uint32_t(RecordDefUse));
+    }
+
+    static void writeData(std::ofstream& out, const CSRGraph& graph, const FunctionRecord& record) {
+        sections(graph, record, [&](const auto& view, uint64_t count) {
+            const uint64_t bytes = count * sizeof(ElementOf<decltype(view)>);
+            out.write(reinterpret_cast<const char*>(view.data()), bytes);
+            out.write(Padding, align8(bytes) - bytes);
+        });
+    }
+
+    // Views of record's arrays at `data`, which must hold dataBytes of them.
+    static CSRGraph view(const char* data, const FunctionRecord& record, std::shared_ptr<const void> owner) {
+        CSRGraph graph;
+        uint64_t pos = 0;
+        sections(graph, record, [&](auto& view, uint64_t count) {
+            using T = ElementOf<decltype(view)>;
+            view = llvm::ArrayRef<T>(reinterpret_cast<const T*>(data + pos), count);
+            pos += align8(count * sizeof(T));
+        });
+        graph.m_entry = record.entry;
+        graph.m_exit = record.exit;
+        graph.m_denseIds = (record.flags & RecordDenseIds) != 0;
+        graph.m_storage = std::move(owner);
+        return graph;
+    }
+
+    static uint64_t dataBytes(const FunctionRecord& record) {
+        CSRGraph empty;
+        uint64_t bytes = 0;
+        sections(empty, record, [&](const auto& view, uint64_t count) {
+            bytes += align8(count * sizeof(ElementOf<decltype(view)>));
+        });
+        return bytes;
+    }
+
+    // The last entry of every offsets array must match the counts before
+    // any row is trusted.
+    static bool consistent(const CSRGraph& graph, const FunctionRecord& record) {
+        bool ok = graph.m_offsets.back() == record.edges && graph.m_predOffsets.back() == record.edges &&
+                  graph.m_stmtOffsets.back() == record.statements &&
+                  graph.m_stringOffsets.back() == record.stringBytes;
+        if (record.flags & RecordDefUse) {
+            ok = ok && graph.m_defOffsets.back() == record.definitions && graph.m_useOffsets.back() == record.uses &&
+                 graph.m_blockDefOffsets.back() == record.blockDefinitions &&
+                 graph.m_blockUseOffsets.back() == record.blockUses;
+        }
+        return ok;
+    }
+};
+
+void CorpusWriter::addFunction(std::string name, std::shared_ptr<const CSRGraph> graph, SourceSpan span,
+                               std::string key) {
+    if (!graph || graph->empty()) return;
+    if (key.empty()) key = name;
+    m_functions.push_back({std::move(name), std::move(key), std::move(graph), std::move(span)});
+}
+
+bool CorpusWriter::write(const std::string& filename) const {
+    const size_t count = m_functions.size();
+
+    // Names, keys and file paths share one blob; a translation unit's
+    // functions all name the same file, so paths are stored once each.
+    std::vector<char> blob;
+    std::unordered_map<std::string, uint32_t> files;
+    auto appendText = [&](std::string_view text) {
+        uint32_t offset = static_cast<uint32_t>(blob.size());
+        blob.insert(blob.end(), text.begin(), text.end());
+        return offset;
+    };
+
+    std::vector<FunctionRecord> records(count);
+    std::vector<CSRGraph> packed;
+    std::vector<std::vector<uint32_t>> stringOffsets(count);
+    std::vector<std::vector<char>> stringData(count);
+    packed.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Function& function = m_functions[i];
+        FunctionRecord& record = records[i];
+        std::memset(&record, 0, sizeof(record));
+        record.name = appendText(function.name);
+        record.nameLength = static_cast<uint32_t>(function.name.size());
+        record.key = function.key == function.name ? record.name : appendText(function.key);
+        record.keyLength = static_cast<uint32_t>(function.key.size());
+        auto [file, inserted] = files.try_emplace(function.span.file, 0);
+        if (inserted) file->second = appendText(function.span.file);
+        record.file = file->second;
+        record.fileLength = static_cast<uint32_t>(function.span.file.size());
+        record.beginLine = function.span.beginLine;
+        record.beginColumn = function.span.beginColumn;
+        record.endLine = function.span.endLine;
+        record.endColumn = function.span.endColumn;
+        packed.push_back(CorpusCodec::packStrings(*function.graph, stringOffsets[i], stringData[i]));
+        CorpusCodec::fillCounts(packed.back(), record);
+        record.dataBytes = CorpusCodec::dataBytes(record);
+    }
+
+    // At most half the slots are used, so probes stay short.
+    uint32_t hashSlots = 1;
+    while (hashSlots < 2 * count) hashSlots <<= 1;
+    std::vector<uint32_t> slots(hashSlots, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const std::string& key = m_functions[i].key;
+        for (uint64_t slot = hashName(key) & (hashSlots - 1);; slot = (slot + 1) & (hashSlots - 1)) {
+            if (slots[slot] == 0) {
+                slots[slot] = static_cast<uint32_t>(i + 1);
+                break;
+            }
+            if (m_functions[slots[slot] - 1].key == key) break;
+        }
+    }
+
+    CorpusHeader header;
+    std::memcpy(header.magic, CorpusMagic, sizeof(CorpusMagic));
+    header.version = CorpusVersion;
+    header.functionCount = static_cast<uint32_t>(count);
+    header.hashSlots = hashSlots;
+    header.strings = sizeof(CorpusHeader) + count * sizeof(FunctionRecord) + align8(hashSlots * sizeof(uint32_t));
+    header.stringBytes = blob.size();
+    uint64_t pos = header.strings + align8(blob.size());
+    for (FunctionRecord& record : records) {
+        record.data = pos;
+        pos += record.dataBytes;
+    }
+    header.fileSize = pos;
+
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        if (!out.is_open()) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(FunctionRecord));
+        out.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(uint32_t));
+        out.write(Padding, align8(slots.size() * sizeof(uint32_t)) - slots.size() * sizeof(uint32_t));
+        out.write(blob.data(), blob.size());
+        out.write(Padding, align8(blob.size()) - blob.size());
+        for (size_t i = 0; i < count; ++i) {
+            CorpusCodec::writeData(out, packed[i], records[i]);
+        }
+        if (!out.good()) return false;
+    }
+    if (llvm::sys::fs::rename(temporary, filename)) {
+        llvm::sys::fs::remove(temporary);
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const CFGCorpus> CFGCorpus::open(const std::string& filename) {
+    auto buffer = llvm::MemoryBuffer::getFile(filename, /*IsText=*/false,
+                                              /*RequiresNullTerminator=*/false);
+    if (!buffer) return nullptr;
+
+    std::shared_ptr<CFGCorpus> corpus(new CFGCorpus);
+    corpus->m_buffer = std::move(*buffer);
+    corpus->m_data = corpus->m_buffer->getBufferStart();
+    corpus->m_size = corpus->m_buffer->getBufferSize();
+    if (reinterpret_cast<uintptr_t>(corpus->m_data) % 8 != 0 || corpus->m_size < sizeof(CorpusHeader)) {
+        return nullptr;
+    }
+
+    const auto* header = reinterpret_cast<const CorpusHeader*>(corpus->m_data);
+    if (std::memcmp(header->magic, CorpusMagic, sizeof(CorpusMagic)) != 0 ||
+        header->version != CorpusVersion || header->fileSize != corpus->m_size ||
+        header->hashSlots == 0 || (header->hashSlots & (header->hashSlots - 1)) != 0 ||
+        header->strings != sizeof(CorpusHeader) + uint64_t(header->functionCount) * sizeof(FunctionRecord) +
+                           align8(uint64_t(header->hashSlots) * sizeof(uint32_t)) ||
+        header->strings + header->stringBytes > corpus->m_size) {
+        return nullptr;
+    }
+    corpus->m_functionCount = header->functionCount;
+    corpus->m_hashSlots = header->hashSlots;
+    corpus->m_strings = header->strings;
+    corpus->m_stringBytes = header->stringBytes;
+    return corpus;
+}
+
+CFGCorpus::~CFGCorpus() = default;
+
+std::string_view CFGCorpus::name(size_t i) const {
+    if (i >= m_functionCount) return {};
+    const auto* record = reinterpret_cast<const FunctionRecord*>(m_data + sizeof(CorpusHeader)) + i;
+    if (uint64_t(record->name) + record->nameLength > m_stringBytes) return {};
+    return std::string_view(m_data + m_strings + record->name, record->nameLength);
+}
+
+std::string_view CFGCorpus::key(size_t i) const {
+    if (i >= m_functionCount) return {};
+    const auto* record = reinterpret_cast<const FunctionRecord*>(m_data + sizeof(CorpusHeader)) + i;
+    if (uint64_t(record->key) + record->keyLength > m_stringBytes) return {};
+    return std::string_view(m_data + m_strings + record->key, record->keyLength);
+}
+
+SourceSpan CFGCorpus::span(size_t i) const {
+    SourceSpan span;
+    if (i >= m_functionCount) return span;
+    const auto* record = reinterpret_cast<const FunctionRecord*>(m_data + sizeof(CorpusHeader)) + i;
+    if (uint64_t(record->file) + record->fileLength <= m_stringBytes) {
+        span.file.assign(m_data + m_strings + record->file, record->fileLength);
+    }
+    span.beginLine = record->beginLine;
+    span.beginColumn = record->beginColumn;
+    span.endLine = record->endLine;
+    span.endColumn = record->endColumn;
+    return span;
+}
+
+size_t CFGCorpus::find(std::string_view key) const {
+    const auto* slots = reinterpret_cast<const uint32_t*>(
+        m_data + sizeof(CorpusHeader) + m_functionCount * sizeof(FunctionRecord));
+    for (uint64_t slot = hashName(key) & (m_hashSlots - 1), probes = 0; probes < m_hashSlots;
+         slot = (slot + 1) & (m_hashSlots - 1), ++probes) {
+        if (slots[slot] == 0 || slots[slot] > m_functionCount) return npos;
+        if (this->key(slots[slot] - 1) == key) return slots[slot] - 1;
+    }
+    return npos;
+}
+
+std::shared_ptr<const CSRGraph> CFGCorpus::graph(size_t i) const {
+    if (i >= m_functionCount) return nullptr;
+    const auto* record = reinterpret_cast<const FunctionRecord*>(m_data + sizeof(CorpusHeader)) + i;
+    if (record->data % 8 != 0 || record->data > m_size || record->dataBytes > m_size - record->data ||
+        record->dataBytes != CorpusCodec::dataBytes(*record) ||
+        (record->nodes > 0 && (record->entry >= record->nodes || record->exit >= record->nodes))) {
+        return nullptr;
+    }
+    CSRGraph graph = CorpusCodec::view(m_data + record->data, *record, shared_from_this());
+    if (!CorpusCodec::consistent(graph, *record)) return nullptr;
+    return std::make_shared<const CSRGraph>(std::move(graph));
+}
+
+std::shared_ptr<const CSRGraph> CFGCorpus::graph(std::string_view key) const {
+    size_t i = find(key);
+    return i == npos ? nullptr : graph(i);
+}
+
+} // namespace GraphGenerator
@@ -0,0 +1,589 @@
+#include "cfg_diff.h"
+#include "cfg_corpus.h"
+#include "cfg_hash.h"
+#include "parallel_for.h"
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace GraphGenerator {
+
+namespace {
+
+using Index = CSRGraph::Index;
+
+uint64_t hashText(std::string_view text) {
+    uint64_t hash = 0xcbf29ce484222325ull;  // FNV-1a
+    for (char c : text) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Structural labels with the block's variable accesses mixed in, since
+// graphs read from DOT carry no statements.
+std::vector<uint64_t> blockSignatures(const CSRGraph& graph) {
+    std::vector<uint64_t> labels = initialStructuralLabels(graph);
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        for (uint32_t v : graph.variablesDefinedIn(n)) {
+            labels[n] = mixHash(labels[n], hashText(graph.variableName(v)) ^ 1);
+        }
+        for (uint32_t v : graph.variablesUsedIn(n)) {
+            labels[n] = mixHash(labels[n], hashText(graph.variableName(v)) ^ 2);
+        }
+    }
+    return labels;
+}
+
+class BlockMatcher {
+public:
+    BlockMatcher(const CSRGraph& before, const CSRGraph& after)
+        : m_before(before), m_after(after),
+          m_beforeMatch(before.nodeCount(), CSRGraph::InvalidIndex),
+          m_afterMatch(after.nodeCount(), CSRGraph::InvalidIndex) {}
+
+    std::vector<Index> run() {
+        std::vector<uint64_t> beforeLabels = blockSignatures(m_before);
+        std::vector<uint64_t> afterLabels = blockSignatures(m_after);
+        m_beforeBase = beforeLabels;
+        m_afterBase = afterLabels;
+
+        // Coarser labels describe less of the neighbourhood, so the most
+        // refined ones are tried first.
+        std::vector<std::pair<std::vector<uint64_t>, std::vector<uint64_t>>> levels;
+        levels.emplace_back(beforeLabels, afterLabels);
+        for (int round = 0; round < 2; ++round) {
+            refineStructuralLabels(m_before, beforeLabels);
+            refineStructuralLabels(m_after, afterLabels);
+            levels.emplace_back(beforeLabels, afterLabels);
+        }
+
+        if (m_before.entry() != CSRGraph::InvalidIndex && m_after.entry() != CSRGraph::InvalidIndex) {
+            match(m_before.entry(), m_after.entry());
+        }
+        if (m_before.exit() != CSRGraph::InvalidIndex && m_after.exit() != CSRGraph::InvalidIndex) {
+            match(m_before.exit(), m_after.exit());
+        }
+        for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+            matchUnique(level->first, level->second);
+        }
+        propagate();
+        matchUnique(m_beforeBase, m_afterBase);
+        propagate();
+
+        // Only once identical blocks are exhausted are lone leftovers
+        // between matched neighbours taken as edits of each other.
+        for (;;) {
+            const size_t matchedCount = m_matched.size();
+            m_allowEdits = true;
+            const std::vector<std::pair<Index, Index>> matched = m_matched;
+            for (const auto& [b, a] : matched) visitPair(b, a);
+            m_allowEdits = false;
+            propagate();
+            if (m_matched.size() == matchedCount) break;
+        }
+        return m_beforeMatch;
+    }
+
+private:
+    void match(Index b, Index a) {
+        if (m_beforeMatch[b] != CSRGraph::InvalidIndex || m_afterMatch[a] != CSRGraph::InvalidIndex) return;
+        m_beforeMatch[b] = a;
+        m_afterMatch[a] = b;
+        m_matched.push_back({b, a});
+        m_pending.push_back({b, a});
+    }
+
+    void matchUnique(const std::vector<uint64_t>& beforeLabels, const std::vector<uint64_t>& afterLabels) {
+        std::unordered_map<uint64_t, std::pair<uint32_t, Index>> beforeCounts;
+        for (Index n = 0; n < m_before.nodeCount(); ++n) {
+            if (m_beforeMatch[n] != CSRGraph::InvalidIndex) continue;
+            auto& entry = beforeCounts[beforeLabels[n]];
+            ++entry.first;
+            entry.second = n;
+        }
+        std::unordered_map<uint64_t, std::pair<uint32_t, Index>> afterCounts;
+        for (Index n = 0; n < m_after.nodeCount(); ++n) {
+            if (m_afterMatch[n] != CSRGraph::InvalidIndex) continue;
+            auto& entry = afterCounts[afterLabels[n]];
+            ++entry.first;
+            entry.second = n;
+        }
+        for (const auto& [label, entry] : beforeCounts) {
+            auto other = afterCounts.find(label);
+            if (entry.first == 1 && other != afterCounts.end() && other->second.first == 1) {
+                match(entry.second, other->second.second);
+            }
+        }
+    }
+
+    // Pairs the unmatched neighbours of two matched blocks, given as
+    // (node, flags of the connecting edge).
+    void matchNeighbours(const std::vector<std::pair<Index, uint8_t>>& beforeSide,
+                         const std::vector<std::pair<Index, uint8_t>>& afterSide) {
+        auto unmatched = [](const std::vector<std::pair<Index, uint8_t>>& side, const std::vector<Index>& matches) {
+            std::vector<std::pair<Index, uint8_t>> open;
+            for (const auto& entry : side) {
+                if (matches[entry.first] == CSRGraph::InvalidIndex) open.push_back(entry);
+            }
+            return open;
+        };
+        std::vector<std::pair<Index, uint8_t>> b = unmatched(beforeSide, m_beforeMatch);
+        std::vector<std::pair<Index, uint8_t>> a = unmatched(afterSide, m_afterMatch);
+        if (b.empty() || a.empty()) return;
+
+        // Same flags and same content, unique on both sides.
+        for (const auto& [bn, bflags] : b) {
+            Index candidate = CSRGraph::InvalidIndex;
+            int count = 0;
+            for (const auto& [an, aflags] : a) {
+                if (aflags == bflags && m_afterBase[an] == m_beforeBase[bn] && m_afterMatch[an] == CSRGraph::InvalidIndex) {
+                    candidate = an;
+                    ++count;
+                }
+            }
+            if (count == 1) match(bn, candidate);
+        }
+        if (!m_allowEdits) return;
+
+        // A single leftover on each side with the same flags was edited.
+        for (uint8_t flags : {uint8_t(EdgeNone), uint8_t(EdgeTrueBranch), uint8_t(EdgeFalseBranch), uint8_t(EdgeException)}) {
+            Index bOnly = CSRGraph::InvalidIndex, aOnly = CSRGraph::InvalidIndex;
+            int bCount = 0, aCount = 0;
+            for (const auto& [bn, bflags] : b) {
+                if (bflags == flags && m_beforeMatch[bn] == CSRGraph::InvalidIndex) { bOnly = bn; ++bCount; }
+            }
+            for (const auto& [an, aflags] : a) {
+                if (aflags == flags && m_afterMatch[an] == CSRGraph::InvalidIndex) { aOnly = an; ++aCount; }
+            }
+            if (bCount == 1 && aCount == 1) match(bOnly, aOnly);
+        }
+    }
+
+    void propagate() {
+        while (!m_pending.empty()) {
+            const auto [b, a] = m_pending.front();
+            m_pending.pop_front();
+            visitPair(b, a);
+        }
+    }
+
+    void visitPair(Index b, Index a) {
+        std::vector<std::pair<Index, uint8_t>> beforeSide, afterSide;
+        for (uint32_t e = m_before.edgeBegin(b); e < m_before.edgeEnd(b); ++e) {
+            beforeSide.push_back({m_before.edgeTarget(e), m_before.edgeFlags(e)});
+        }
+        for (uint32_t e = m_after.edgeBegin(a); e < m_after.edgeEnd(a); ++e) {
+            afterSide.push_back({m_after.edgeTarget(e), m_after.edgeFlags(e)});
+        }
+        matchNeighbours(beforeSide, afterSide);
+
+        beforeSide.clear();
+        afterSide.clear();
+        const auto beforePreds = m_before.predecessors(b);
+        const auto beforeEdges = m_before.predecessorEdges(b);
+        for (size_t i = 0; i < beforePreds.size(); ++i) {
+            beforeSide.push_back({beforePreds[i], m_before.edgeFlags(beforeEdges[i])});
+        }
+        const auto afterPreds = m_after.predecessors(a);
+        const auto afterEdges = m_after.predecessorEdges(a);
+        for (size_t i = 0; i < afterPreds.size(); ++i) {
+            afterSide.push_back({afterPreds[i], m_after.edgeFlags(afterEdges[i])});
+        }
+        matchNeighbours(beforeSide, afterSide);
+    }
+
+public:
+    const std::vector<uint64_t>& beforeBase() const { return m_beforeBase; }
+    const std::vector<uint64_t>& afterBase() const { return m_afterBase; }
+
+private:
+    const CSRGraph& m_before;
+    const CSRGraph& m_after;
+    std::vector<Index> m_beforeMatch;
+    std::vector<Index> m_afterMatch;
+    std::vector<uint64_t> m_beforeBase;
+    std::vector<uint64_t> m_afterBase;
+    std::vector<std::pair<Index, Index>> m_matched;
+    std::deque<std::pair<Index, Index>> m_pending;  // breadth-first from the anchors
+    bool m_allowEdits = false;
+};
+
+// key=value or key="value" pairs of a DOT attribute list, in order; older
+// visualizer output may repeat a key (fillcolor) on one node.
+using DotAttributes = std::vector<std::pair<std::string, std::string>>;
+
+DotAttributes parseDotAttributes(std::string_view text) {
+    DotAttributes attributes;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && (std::isspace(static_cast<unsigned char>(text[i])) || text[i] == ',')) ++i;
+        size_t keyStart = i;
+        while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_')) ++i;
+        std::string key(text.substr(keyStart, i - keyStart));
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+        if (key.empty() || i >= text.size() || text[i] != '=') {
+            ++i;
+            continue;
+        }
+        ++i;
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+        std::string value;
+        if (i < text.size() && text[i] == '"') {
+            for (++i; i < text.size() && text[i] != '"'; ++i) {
+                if (text[i] == '\\' && i + 1 < text.size()) ++i;
+                value += text[i];
+            }
+            ++i;
+        } else {
+            while (i < text.size() && text[i] != ',' && !std::isspace(static_cast<unsigned char>(text[i]))) {
+                value += text[i++];
+            }
+        }
+        attributes.emplace_back(std::move(key), std::move(value));
+    }
+    return attributes;
+}
+
+const std::string* findAttribute(const DotAttributes& attributes, std::string_view key) {
+    for (auto it = attributes.rbegin(); it != attributes.rend(); ++it) {
+        if (it->first == key) return &it->second;
+    }
+    return nullptr;
+}
+
+bool parseBlockId(std::string_view& text, int& id) {
+    size_t i = 0;
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+    size_t start = i;
+    while (i < text.size() && std::isdigit(static_cast<unsigned char>(text[i]))) ++i;
+    if (i == start) return false;
+    id = std::stoi(std::string(text.substr(start, i - start)));
+    text.remove_prefix(i);
+    return true;
+}
+
+void splitVariables(const std::string& list, const std::function<void(std::string_view)>& fn) {
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        if (end > start) fn(std::string_view(list).substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+} // namespace
+
+GraphDiff diffGraphs(const CSRGraph& before, const CSRGraph& after) {
+    GraphDiff diff;
+    BlockMatcher matcher(before, after);
+    diff.matchOf = matcher.run();
+
+    std::vector<bool> afterMatched(after.nodeCount(), false);
+    for (Index b = 0; b < before.nodeCount(); ++b) {
+        const Index a = diff.matchOf[b];
+        if (a == CSRGraph::InvalidIndex) {
+            diff.removedBlocks.push_back(b);
+            continue;
+        }
+        afterMatched[a] = true;
+        if (matcher.beforeBase()[b] != matcher.afterBase()[a]) {
+            diff.changedBlocks.push_back(a);
+        }
+    }
+    std::sort(diff.changedBlocks.begin(), diff.changedBlocks.end());
+    for (Index a = 0; a < after.nodeCount(); ++a) {
+        if (!afterMatched[a]) diff.addedBlocks.push_back(a);
+    }
+
+    // An edge survives if both ends are matched and joined in the other
+    // version too.
+    std::vector<bool> afterEdgeKept(after.edgeCount(), false);
+    for (Index b = 0; b < before.nodeCount(); ++b) {
+        for (uint32_t e = before.edgeBegin(b); e < before.edgeEnd(b); ++e) {
+            const Index a = diff.matchOf[b];
+            const Index target = diff.matchOf[before.edgeTarget(e)];
+            const uint32_t kept = a != CSRGraph::InvalidIndex && target != CSRGraph::InvalidIndex
+                ? after.findEdge(a, target) : CSRGraph::InvalidIndex;
+            if (kept != CSRGraph::InvalidIndex) {
+                afterEdgeKept[kept] = true;
+            } else {
+                diff.removedEdges.push_back({before.blockId(b), before.blockId(before.edgeTarget(e))});
+            }
+        }
+    }
+    for (Index a = 0; a < after.nodeCount(); ++a) {
+        for (uint32_t e = after.edgeBegin(a); e < after.edgeEnd(a); ++e) {
+            if (!afterEdgeKept[e]) diff.addedEdges.push_back({after.blockId(a), after.blockId(after.edgeTarget(e))});
+        }
+    }
+    return diff;
+}
+
+std::string diffToDot(const CSRGraph& before, const CSRGraph& after, const GraphDiff& diff) {
+    int nextId = 0;
+    for (Index a = 0; a < after.nodeCount(); ++a) nextId = std::max(nextId, after.blockId(a) + 1);
+
+    // Where each before block appears in the diff graph.
+    std::vector<int> shownId(before.nodeCount());
+    for (Index b = 0; b < before.nodeCount(); ++b) {
+        shownId[b] = diff.matchOf[b] != CSRGraph::InvalidIndex ? after.blockId(diff.matchOf[b]) : nextId + before.blockId(b);
+    }
+    std::vector<uint8_t> state(after.nodeCount(), 0);  // 0 same, 1 added, 2 changed
+    for (Index a : diff.addedBlocks) state[a] = 1;
+    for (Index a : diff.changedBlocks) state[a] = 2;
+
+    std::stringstream dot;
+    dot << "digraph CFGDiff {\n";
+    dot << "  node [shape=box, fontname=\"Courier\", fontsize=10];\n";
+    dot << "  edge [fontsize=8];\n";
+    for (Index a = 0; a < after.nodeCount(); ++a) {
+        static const char* const fills[] = {"white", "palegreen", "orange"};
+        static const char* const tags[] = {"same", "added", "changed"};
+        dot << "  " << after.blockId(a) << " [label=\"" << after.label(a) << "\", style=filled, fillcolor="
+            << fills[state[a]] << ", diff=\"" << tags[state[a]] << "\"];\n";
+    }
+    for (Index b : diff.removedBlocks) {
+        dot << "  " << shownId[b] << " [label=\"" << before.label(b)
+            << " (removed)\", style=filled, fillcolor=lightcoral, diff=\"removed\"];\n";
+    }
+
+    std::set<std::pair<int, int>> added(diff.addedEdges.begin(), diff.addedEdges.end());
+    for (Index a = 0; a < after.nodeCount(); ++a) {
+        for (uint32_t e = after.edgeBegin(a); e < after.edgeEnd(a); ++e) {
+            const int from = after.blockId(a);
+            const int to = after.blockId(after.edgeTarget(e));
+            dot << "  " << from << " -> " << to;
+            if (added.count({from, to})) {
+                dot << " [color=green, penwidth=2, diff=\"added\"]";
+            } else if (after.edgeFlags(e) & EdgeException) {
+                dot << " [color=gray, style=dashed, label=\"exception\"]";
+            }
+            dot << ";\n";
+        }
+    }
+    for (const auto& [from, to] : diff.removedEdges) {
+        dot << "  " << shownId[before.indexOf(from)] << " -> " << shownId[before.indexOf(to)]
+            << " [color=red, style=dashed, diff=\"removed\"];\n";
+    }
+    dot << "}\n";
+    return dot.str();
+}
+
+std::shared_ptr<const CSRGraph> parseCfgDot(std::string_view content) {
+    CSRGraphBuilder builder;
+    bool hasEntry = false, hasExit = false;
+    bool sawGraph = false;
+    int lowestId = 0, highestId = -1;
+    while (!content.empty()) {
+        const size_t lineEnd = std::min(content.find('\n'), content.size());
+        std::string_view text = content.substr(0, lineEnd);
+        content.remove_prefix(std::min(lineEnd + 1, content.size()));
+        if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+        const size_t open = text.find('[');
+        const size_t close = text.rfind(']');
+        const DotAttributes attributes = open != std::string_view::npos && close != std::string_view::npos && close > open
+            ? parseDotAttributes(text.substr(open + 1, close - open - 1)) : DotAttributes{};
+        std::string_view head = text.substr(0, open);
+        while (!head.empty() && std::isspace(static_cast<unsigned char>(head.front()))) head.remove_prefix(1);
+
+        if (head.rfind("digraph", 0) == 0) {
+            sawGraph = true;
+            continue;
+        }
+        if (head.rfind("graph", 0) == 0) {
+            if (const std::string* entry = findAttribute(attributes, "entry")) {
+                builder.setEntry(std::stoi(*entry));
+                hasEntry = true;
+            }
+            if (const std::string* exit = findAttribute(attributes, "exit")) {
+                builder.setExit(std::stoi(*exit));
+                hasExit = true;
+            }
+            continue;
+        }
+
+        int from = 0;
+        if (!parseBlockId(head, from)) continue;
+        while (!head.empty() && std::isspace(static_cast<unsigned char>(head.front()))) head.remove_prefix(1);
+        if (head.rfind("->", 0) == 0) {
+            head.remove_prefix(2);
+            int to = 0;
+            if (!parseBlockId(head, to)) continue;
+            const std::string* color = findAttribute(attributes, "color");
+            const std::string* label = findAttribute(attributes, "label");
+            const bool isException = color && *color == "red" && label && *label == "exception";
+            builder.addEdge(from, to, isException ? EdgeException : EdgeNone);
+            continue;
+        }
+
+        const std::string* label = findAttribute(attributes, "label");
+        builder.addNode(from, label ? std::string_view(*label) : std::string_view());
+        lowestId = highestId < 0 ? from : std::min(lowestId, from);
+        highestId = std::max(highestId, from);
+        // Block kinds are tagged; older files only had them as fill colours.
+        for (const auto& [key, value] : attributes) {
+            if ((key == "try" && value == "true") || (key == "fillcolor" && value == "lightblue")) {
+                builder.addAttributes(from, NodeTryBlock);
+            }
+            if ((key == "throws" && value == "true") || (key == "fillcolor" && value == "lightcoral")) {
+                builder.addAttributes(from, NodeThrowsException);
+            }
+        }
+        if (const std::string* defs = findAttribute(attributes, "defs")) {
+            splitVariables(*defs, [&](std::string_view name) {
+                builder.addVariableAccess(from, 0, name, nullptr, AccessKind::Write);
+            });
+        }
+        if (const std::string* uses = findAttribute(attributes, "uses")) {
+            splitVariables(*uses, [&](std::string_view name) {
+                builder.addVariableAccess(from, 0, name, nullptr, AccessKind::Read);
+            });
+        }
+    }
+    if (!sawGraph) return nullptr;
+
+    // Older files lack the graph line; clang numbers the entry last and
+    // the exit 0.
+    if (!hasEntry && highestId >= 0) builder.setEntry(highestId);
+    if (!hasExit && highestId >= 0) builder.setExit(lowestId);
+    return std::make_shared<const CSRGraph>(builder.freeze());
+}
+
+std::shared_ptr<const CSRGraph> loadCfgDot(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return nullptr;
+    std::stringstream content;
+    content << file.rdbuf();
+    return parseCfgDot(content.str());
+}
+
+std::vector<FunctionDiff> diffRuns(const std::string& beforeDir, const std::string& afterDir, unsigned threads) {
+    struct Entry {
+        std::string key;  // the analyzer's cache and corpus key: the USR, else the name
+        std::string name;
+        json manifest;
+    };
+    auto loadManifest = [](const std::string& dir) {
+        std::vector<Entry> entries;
+        std::ifstream file(dir + "/cfg_cache.json");
+        if (!file.is_open()) return entries;
+        json cache = json::parse(file, nullptr, /*allow_exceptions=*/false);
+        if (!cache.is_object() || !cache["functions"].is_object()) return entries;
+        for (const auto& [key, entry] : cache["functions"].items()) {
+            entries.push_back({key, entry.value("name", key), entry});
+        }
+        return entries;
+    };
+    const std::vector<Entry> before = loadManifest(beforeDir);
+    const std::vector<Entry> after = loadManifest(afterDir);
+
+    // Both sides of a pair are read the same way: from the binary corpora
+    // when both have the function, otherwise from their DOT files.
+    const std::shared_ptr<const CFGCorpus> beforeCorpus = CFGCorpus::open(beforeDir + "/cfg_corpus.bin");
+    const std::shared_ptr<const CFGCorpus> afterCorpus = CFGCorpus::open(afterDir + "/cfg_corpus.bin");
+
+    // USR first, then name for whatever is left.
+    std::unordered_map<std::string, size_t> afterByUsr, afterByName;
+    for (size_t i = 0; i < after.size(); ++i) {
+        if (after[i].manifest.contains("usr")) afterByUsr[after[i].manifest["usr"].get<std::string>()] = i;
+        afterByName[after[i].name] = i;
+    }
+    std::vector<std::pair<size_t, size_t>> pairs;  // before, after (or npos)
+    std::vector<bool> afterPaired(after.size(), false);
+    for (size_t i = 0; i < before.size(); ++i) {
+        size_t other = std::string::npos;
+        if (before[i].manifest.contains("usr")) {
+            auto it = afterByUsr.find(before[i].manifest["usr"].get<std::string>());
+            if (it != afterByUsr.end() && !afterPaired[it->second]) other = it->second;
+        }
+        if (other == std::string::npos) {
+            auto it = afterByName.find(before[i].name);
+            if (it != afterByName.end() && !afterPaired[it->second]) other = it->second;
+        }
+        if (other != std::string::npos) afterPaired[other] = true;
+        pairs.push_back({i, other});
+    }
+
+    std::vector<FunctionDiff> diffs(pairs.size());
+    parallelFor(pairs.size(), [&](size_t p) {
+        const Entry& old = before[pairs[p].first];
+        FunctionDiff& diff = diffs[p];
+        diff.name = old.name;
+        if (pairs[p].second == std::string::npos) {
+            diff.status = DiffStatus::Removed;
+            return;
+        }
+        const Entry& current = after[pairs[p].second];
+        diff.name = current.name;
+        if (old.manifest.value("shapeHash", uint64_t(0)) != 0 &&
+            old.manifest.value("shapeHash", uint64_t(0)) == current.manifest.value("shapeHash", uint64_t(1)) &&
+            old.manifest.value("fingerprint", uint64_t(0)) == current.manifest.value("fingerprint", uint64_t(1))) {
+            return;
+        }
+        std::shared_ptr<const CSRGraph> oldGraph = beforeCorpus ? beforeCorpus->graph(old.key) : nullptr;
+        std::shared_ptr<const CSRGraph> newGraph = afterCorpus ? afterCorpus->graph(current.key) : nullptr;
+        if (!oldGraph || !newGraph) {
+            oldGraph = loadCfgDot(beforeDir + "/" + old.manifest.value("dot", old.name + "_cfg.dot"));
+            newGraph = loadCfgDot(afterDir + "/" + current.manifest.value("dot", current.name + "_cfg.dot"));
+        }
+        if (!oldGraph || !newGraph) {
+            diff.status = DiffStatus::Changed;
+            return;
+        }
+        diff.graph = diffGraphs(*oldGraph, *newGraph);
+        if (!diff.graph.empty()) {
+            diff.status = DiffStatus::Changed;
+            diff.dot = diffToDot(*oldGraph, *newGraph, diff.graph);
+        }
+    }, threads);
+
+    for (size_t i = 0; i < after.size(); ++i) {
+        if (afterPaired[i]) continue;
+        FunctionDiff added;
+        added.name = after[i].name;
+        added.status = DiffStatus::Added;
+        diffs.push_back(std::move(added));
+    }
+    std::sort(diffs.begin(), diffs.end(), [](const FunctionDiff& a, const FunctionDiff& b) { return a.name < b.name; });
+    return diffs;
+}
+
+std::string formatDiffReport(const std::vector<FunctionDiff>& diffs) {
+    size_t counts[4] = {0, 0, 0, 0};
+    for (const FunctionDiff& diff : diffs) ++counts[static_cast<int>(diff.status)];
+
+    std::stringstream report;
+    report << "CFG Diff: " << counts[int(DiffStatus::Changed)] << " changed, "
+           << counts[int(DiffStatus::Added)] << " added, " << counts[int(DiffStatus::Removed)]
+           << " removed, " << counts[int(DiffStatus::Unchanged)] << " unchanged\n";
+    for (const FunctionDiff& diff : diffs) {
+        switch (diff.status) {
+        case DiffStatus::Unchanged:
+            break;
+        case DiffStatus::Added:
+            report << "  + " << diff.name << "\n";
+            break;
+        case DiffStatus::Removed:
+            report << "  - " << diff.name << "\n";
+            break;
+        case DiffStatus::Changed:
+            report << "  ~ " << diff.name << ": blocks +" << diff.graph.addedBlocks.size()
+                   << " -" << diff.graph.removedBlocks.size() << " ~" << diff.graph.changedBlocks.size()
+                   << ", edges +" << diff.graph.addedEdges.size() << " -" << diff.graph.removedEdges.size() << "\n";
+            break;
+        }
+    }
+    return report.str();
+}
+
+} // namespace GraphGenerator
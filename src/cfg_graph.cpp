@@ -1,38 +1,159 @@
 #include "graph_generator.h"
+#include "json_writer.h"
+#include "loop_forest.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <llvm/Support/raw_ostream.h>
 
 namespace GraphGenerator {
 
+CFGGraph::CFGGraph(std::shared_ptr<const CSRGraph> snapshot)
+    : materialized(!snapshot), frozen(std::move(snapshot)) {}
+
+void CFGGraph::materialize() const {
+    if (materialized) {
+        return;
+    }
+    materialized = true;
+
+    const CSRGraph& csr = *frozen;
+    for (CSRGraph::Index n = 0; n < csr.nodeCount(); ++n) {
+        const int nodeID = csr.blockId(n);
+        CFGNode& node = nodes.emplace_hint(nodes.end(), nodeID, CFGNode(nodeID, std::string(csr.label(n))))->second;
+        for (std::string_view stmt : csr.statements(n)) {
+            node.statements.emplace_back(stmt);
+        }
+        if (csr.hasAttribute(n, NodeTryBlock)) tryBlocks.insert(nodeID);
+        if (csr.hasAttribute(n, NodeThrowsException)) throwingBlocks.insert(nodeID);
+
+        for (uint32_t e = csr.edgeBegin(n); e < csr.edgeEnd(n); ++e) {
+            const int successorID = csr.blockId(csr.edgeTarget(e));
+            node.successors.insert(node.successors.end(), successorID);
+            const uint8_t flags = csr.edgeFlags(e);
+            if (flags & EdgeException) exceptionEdges.insert({nodeID, successorID});
+            if (flags & EdgeTrueBranch) trueEdges.insert({nodeID, successorID});
+            if (flags & EdgeFalseBranch) falseEdges.insert({nodeID, successorID});
+        }
+    }
+    if (csr.entry() != CSRGraph::InvalidIndex) entryNode = csr.blockId(csr.entry());
+    if (csr.exit() != CSRGraph::InvalidIndex) exitNode = csr.blockId(csr.exit());
+}
+
 void CFGGraph::addStatement(int nodeID, const std::string& stmt) {
     addStatementToNode(nodeID, stmt);
 }
 
 void CFGGraph::addExceptionEdge(int sourceID, int targetID) {
+    invalidate();
     exceptionEdges.insert({sourceID, targetID});
 }
 
 bool CFGGraph::isExceptionEdge(int sourceID, int targetID) const {
+    if (!materialized) return frozen->isExceptionEdge(sourceID, targetID);
     return exceptionEdges.count({sourceID, targetID}) > 0;
 }
 
 void CFGGraph::markNodeAsTryBlock(int nodeID) {
+    invalidate();
     tryBlocks.insert(nodeID);
 }
 
 void CFGGraph::markNodeAsThrowingException(int nodeID) {
+    invalidate();
     throwingBlocks.insert(nodeID);
 }
 
 bool CFGGraph::isNodeTryBlock(int nodeID) const {
+    if (!materialized) return frozen->isNodeTryBlock(nodeID);
     return tryBlocks.count(nodeID) > 0;
 }
 
 bool CFGGraph::isNodeThrowingException(int nodeID) const {
+    if (!materialized) return frozen->isNodeThrowingException(nodeID);
     return throwingBlocks.count(nodeID) > 0;
 }
 
+void CFGGraph::markBranchEdge(int sourceID, int targetID, bool isTrueBranch) {
+    invalidate();
+    (isTrueBranch ? trueEdges : falseEdges).insert({sourceID, targetID});
+}
+
+void CFGGraph::setEntryNode(int nodeID) {
+    invalidate();
+    entryNode = nodeID;
+}
+
+void CFGGraph::setExitNode(int nodeID) {
+    invalidate();
+    exitNode = nodeID;
+}
+
+std::shared_ptr<const CSRGraph> CFGGraph::freeze() const {
+    if (frozen) {
+        return frozen;
+    }
+
+    size_t edgeCount = 0;
+    size_t stmtCount = 0;
+    for (const auto& [id, node] : nodes) {
+        edgeCount += node.successors.size();
+        stmtCount += node.statements.size();
+    }
+
+    CSRGraphBuilder builder;
+    builder.reserve(nodes.size(), edgeCount, stmtCount);
+    for (const auto& [id, node] : nodes) {
+        builder.addNode(id, node.label);
+        for (const std::string& stmt : node.statements) {
+            builder.addStatement(id, stmt);
+        }
+        uint32_t attributes = NodeNone;
+        if (isNodeTryBlock(id)) attributes |= NodeTryBlock;
+        if (isNodeThrowingException(id)) attributes |= NodeThrowsException;
+        builder.addAttributes(id, attributes);
+    }
+    for (const auto& [id, node] : nodes) {
+        for (int successorID : node.successors) {
+            uint8_t flags = EdgeNone;
+            if (isExceptionEdge(id, successorID)) flags |= EdgeException;
+            if (trueEdges.count({id, successorID})) flags |= EdgeTrueBranch;
+            if (falseEdges.count({id, successorID})) flags |= EdgeFalseBranch;
+            builder.addEdge(id, successorID, flags);
+        }
+    }
+    if (entryNode >= 0) builder.setEntry(entryNode);
+    if (exitNode >= 0) builder.setExit(exitNode);
+
+    frozen = std::make_shared<const CSRGraph>(builder.freeze());
+    return frozen;
+}
+
+std::vector<int> CFGGraph::predecessors(int nodeID) const {
+    const auto csr = freeze();
+    std::vector<int> result;
+    CSRGraph::Index n = csr->indexOf(nodeID);
+    if (n == CSRGraph::InvalidIndex) {
+        return result;
+    }
+    result.reserve(csr->inDegree(n));
+    for (CSRGraph::Index pred : csr->predecessors(n)) {
+        result.push_back(csr->blockId(pred));
+    }
+    return result;
+}
+
+size_t CFGGraph::inDegree(int nodeID) const {
+    const auto csr = freeze();
+    CSRGraph::Index n = csr->indexOf(nodeID);
+    return n == CSRGraph::InvalidIndex ? 0 : csr->inDegree(n);
+}
+
 std::string CFGGraph::getNodeLabel(int nodeID) const {
+    if (!materialized) {
+        CSRGraph::Index n = frozen->indexOf(nodeID);
+        return n != CSRGraph::InvalidIndex ? std::string(frozen->label(n)) : "Unknown Block";
+    }
     auto it = nodes.find(nodeID);
     if (it != nodes.end()) {
         return it->second.label.empty() ? 
@@ -43,6 +164,7 @@ std::string CFGGraph::getNodeLabel(int nodeID) const {
 }
 
 void CFGGraph::addNode(int id, const std::string& label) {
+    invalidate();
     if (nodes.find(id) == nodes.end()) {
         nodes[id] = CFGNode(id, label);
     } else {
@@ -51,10 +173,12 @@ void CFGGraph::addNode(int id, const std::string& label) {
 }
 
 size_t CFGGraph::getNodeCount() const { 
+    if (!materialized) return frozen->nodeCount();
     return nodes.size(); 
 }
 
 size_t CFGGraph::getEdgeCount() const {
+    if (!materialized) return frozen->edgeCount();
     size_t count = 0;
     for (const auto& [id, node] : nodes) {
         count += node.successors.size();
@@ -68,16 +192,17 @@ void CFGGraph::writeToDotFile(const std::string& filename) const {
         throw std::runtime_error("Could not open dot file for writing");
     }
 
+    const auto csr = freeze();
     dotFile << "digraph CFG {\n";
     
     // Write nodes with special formatting for try and throw blocks
-    for (const auto& [nodeID, node] : nodes) {
-        dotFile << "    " << nodeID << " [label=\"" << getNodeLabel(nodeID) << "\"";
+    for (CSRGraph::Index n = 0; n < csr->nodeCount(); ++n) {
+        dotFile << "    " << csr->blockId(n) << " [label=\"" << csr->label(n) << "\"";
         
-        if (isNodeTryBlock(nodeID)) {
+        if (csr->hasAttribute(n, NodeTryBlock)) {
             dotFile << " shape=box color=lightblue";
         }
-        else if (isNodeThrowingException(nodeID)) {
+        else if (csr->hasAttribute(n, NodeThrowsException)) {
             dotFile << " color=red";
         }
         
@@ -85,11 +210,11 @@ void CFGGraph::writeToDotFile(const std::string& filename) const {
     }
 
     // Write edges with special formatting for exception edges
-    for (const auto& [nodeID, node] : nodes) {
-        for (int successorID : node.successors) {
-            dotFile << "    " << nodeID << " -> " << successorID;
+    for (CSRGraph::Index n = 0; n < csr->nodeCount(); ++n) {
+        for (uint32_t e = csr->edgeBegin(n); e < csr->edgeEnd(n); ++e) {
+            dotFile << "    " << csr->blockId(n) << " -> " << csr->blockId(csr->edgeTarget(e));
             
-            if (isExceptionEdge(nodeID, successorID)) {
+            if (csr->edgeFlags(e) & EdgeException) {
                 dotFile << " [color=red]";
             }
             
@@ -101,45 +226,97 @@ void CFGGraph::writeToDotFile(const std::string& filename) const {
     dotFile.close();
 }
 
-void CFGGraph::writeToJsonFile(const std::string& filename, 
-                             const json& astJson, 
-                             const json& functionCallJson) {
-    json graphJson;
-    
-    // Add nodes with all properties
-    for (const auto& [nodeID, node] : nodes) {
-        graphJson["nodes"][std::to_string(nodeID)] = {
-            {"id", nodeID},
-            {"label", getNodeLabel(nodeID)},
-            {"functionName", node.functionName},
-            {"statements", node.statements},
-            {"isTryBlock", isNodeTryBlock(nodeID)},
-            {"isThrowingException", isNodeThrowingException(nodeID)}
-        };
-    }
-
-    // Add edges with properties
-    for (const auto& [nodeID, node] : nodes) {
-        for (int successorID : node.successors) {
-            graphJson["edges"].push_back({
-                {"source", nodeID},
-                {"target", successorID},
-                {"isExceptionEdge", isExceptionEdge(nodeID, successorID)}
-            });
+void CFGGraph::writeToJsonFile(const std::string& filename,
+                             const json& astJson,
+                             const json& functionCallJson,
+                             bool pretty) {
+    const auto csr = freeze();
+    const LoopForest loops = LoopForest::build(*csr);
+
+    std::error_code error;
+    llvm::raw_fd_ostream out(filename, error);
+    if (error) {
+        throw std::runtime_error("Could not open JSON file for writing");
+    }
+    out.SetBufferSize(1 << 16);
+
+    // Streamed in the layout the JSON DOM used to give: keys in ascending
+    // order (node IDs compare as strings), and no "edges" or "nodes" key
+    // when there are none.
+    JsonWriter writer(out, pretty ? 4 : 0);
+    writer.beginObject();
+    writer.key("ast");
+    writer.embed(astJson);
+
+    if (csr->edgeCount() > 0) {
+        writer.key("edges");
+        writer.beginArray();
+        for (CSRGraph::Index n = 0; n < csr->nodeCount(); ++n) {
+            for (uint32_t e = csr->edgeBegin(n); e < csr->edgeEnd(n); ++e) {
+                writer.beginObject();
+                writer.key("isBackEdge");
+                writer.value(loops.isBackEdge(e));
+                writer.key("isExceptionEdge");
+                writer.value((csr->edgeFlags(e) & EdgeException) != 0);
+                writer.key("source");
+                writer.value(csr->blockId(n));
+                writer.key("target");
+                writer.value(csr->blockId(csr->edgeTarget(e)));
+                writer.endObject();
+            }
         }
+        writer.endArray();
     }
 
-    // Combine with additional JSON data
-    graphJson["ast"] = astJson;
-    graphJson["functionCalls"] = functionCallJson;
+    writer.key("functionCalls");
+    writer.embed(functionCallJson);
 
-    std::ofstream jsonFile(filename);
-    if (!jsonFile.is_open()) {
-        throw std::runtime_error("Could not open JSON file for writing");
+    if (csr->nodeCount() > 0) {
+        std::vector<std::pair<std::string, CSRGraph::Index>> order;
+        order.reserve(csr->nodeCount());
+        for (CSRGraph::Index n = 0; n < csr->nodeCount(); ++n) {
+            order.emplace_back(std::to_string(csr->blockId(n)), n);
+        }
+        std::sort(order.begin(), order.end());
+
+        writer.key("nodes");
+        writer.beginObject();
+        for (const auto& [key, n] : order) {
+            const int nodeID = csr->blockId(n);
+            auto it = nodes.find(nodeID);
+            writer.key(key);
+            writer.beginObject();
+            writer.key("functionName");
+            writer.value(it != nodes.end() ? std::string_view(it->second.functionName) : std::string_view());
+            writer.key("id");
+            writer.value(nodeID);
+            writer.key("isLoopHeader");
+            writer.value(loops.isLoopHeader(n));
+            writer.key("isThrowingException");
+            writer.value(csr->hasAttribute(n, NodeThrowsException));
+            writer.key("isTryBlock");
+            writer.value(csr->hasAttribute(n, NodeTryBlock));
+            writer.key("label");
+            writer.value(csr->label(n));
+            writer.key("loopDepth");
+            writer.value(loops.loopDepth(n));
+            writer.key("statements");
+            writer.beginArray();
+            for (std::string_view stmt : csr->statements(n)) {
+                writer.value(stmt);
+            }
+            writer.endArray();
+            writer.endObject();
+        }
+        writer.endObject();
     }
+    writer.endObject();
 
-    jsonFile << graphJson.dump(4);
-    jsonFile.close();
+    out.close();
+    if (out.has_error()) {
+        out.clear_error();
+        throw std::runtime_error("Could not write JSON file");
+    }
 }
 
 } // namespace GraphGenerator
\ No newline at end of file
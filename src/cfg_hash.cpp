@@ -0,0 +1,117 @@
+#include "cfg_hash.h"
+#include <algorithm>
+#include <vector>
+#include <clang/AST/Stmt.h>
+
+namespace GraphGenerator {
+
+// The hash ends up in cache files, so it must be the same in every
+// process: llvm::hash_combine is seeded per execution in some builds.
+uint64_t mixHash(uint64_t seed, uint64_t value) {
+    uint64_t x = seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+namespace {
+
+uint64_t mix(uint64_t seed, uint64_t value) {
+    return mixHash(seed, value);
+}
+
+uint64_t mixSorted(uint64_t seed, std::vector<uint64_t>& values) {
+    std::sort(values.begin(), values.end());
+    seed = mix(seed, values.size());
+    for (uint64_t value : values) seed = mix(seed, value);
+    return seed;
+}
+
+enum : uint64_t {
+    TagNode = 1,
+    TagEntry,
+    TagExit,
+    TagStatement,
+    TagStatementCount,
+    TagTerminator,
+    TagSuccessors,
+    TagPredecessors,
+    TagGraph,
+};
+
+} // namespace
+
+std::vector<uint64_t> initialStructuralLabels(const CSRGraph& graph) {
+    using Index = CSRGraph::Index;
+    const size_t nodeCount = graph.nodeCount();
+    constexpr uint32_t ExceptionAttributes = NodeTryBlock | NodeThrowsException;
+
+    std::vector<uint64_t> labels(nodeCount);
+    for (Index n = 0; n < nodeCount; ++n) {
+        uint64_t label = mix(TagNode, graph.attributes(n) & ExceptionAttributes);
+        if (n == graph.entry()) label = mix(label, TagEntry);
+        if (n == graph.exit()) label = mix(label, TagExit);
+        const llvm::ArrayRef<const clang::Stmt*> handles = graph.statementHandles(n);
+        if (!handles.empty()) {
+            for (const clang::Stmt* stmt : handles) {
+                label = mix(label, mix(TagStatement, stmt ? static_cast<uint64_t>(stmt->getStmtClass()) : 0));
+            }
+        } else {
+            label = mix(label, mix(TagStatementCount, graph.statements(n).size()));
+        }
+        if (const clang::Stmt* terminator = graph.terminator(n)) {
+            label = mix(label, mix(TagTerminator, static_cast<uint64_t>(terminator->getStmtClass())));
+        }
+        labels[n] = label;
+    }
+    return labels;
+}
+
+void refineStructuralLabels(const CSRGraph& graph, std::vector<uint64_t>& labels) {
+    using Index = CSRGraph::Index;
+    const size_t nodeCount = graph.nodeCount();
+    std::vector<uint64_t> next(nodeCount);
+    std::vector<uint64_t> neighbours;
+    for (Index n = 0; n < nodeCount; ++n) {
+        neighbours.clear();
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            neighbours.push_back(mix(labels[graph.edgeTarget(e)], graph.edgeFlags(e)));
+        }
+        uint64_t label = mixSorted(mix(labels[n], TagSuccessors), neighbours);
+
+        neighbours.clear();
+        const llvm::ArrayRef<Index> preds = graph.predecessors(n);
+        const llvm::ArrayRef<uint32_t> predEdges = graph.predecessorEdges(n);
+        for (size_t i = 0; i < preds.size(); ++i) {
+            neighbours.push_back(mix(labels[preds[i]], graph.edgeFlags(predEdges[i])));
+        }
+        next[n] = mixSorted(mix(label, TagPredecessors), neighbours);
+    }
+    labels.swap(next);
+}
+
+uint64_t computeStructuralHash(const CSRGraph& graph, unsigned rounds) {
+    const size_t nodeCount = graph.nodeCount();
+    std::vector<uint64_t> labels = initialStructuralLabels(graph);
+    for (unsigned round = 0; round < rounds; ++round) {
+        refineStructuralLabels(graph, labels);
+    }
+
+    uint64_t hash = mix(mix(TagGraph, nodeCount), graph.edgeCount());
+    if (graph.entry() != CSRGraph::InvalidIndex) hash = mix(hash, labels[graph.entry()]);
+    return mixSorted(hash, labels);
+}
+
+std::string formatStructuralHash(uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4) {
+        text[i] = digits[hash & 0xf];
+    }
+    return text;
+}
+
+} // namespace GraphGenerator
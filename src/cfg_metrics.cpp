@@ -0,0 +1,174 @@
+#include "cfg_metrics.h"
+#include "graph_traversal.h"
+#include "parallel_for.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace GraphGenerator {
+
+namespace {
+
+constexpr char MetricsMagic[4] = {'C', 'F', 'G', 'M'};
+constexpr uint32_t MetricsVersion = 1;
+constexpr size_t MetricsFields = 7;
+
+void packMetrics(const FunctionMetrics& metrics, uint32_t (&fields)[MetricsFields]) {
+    fields[0] = metrics.blocks;
+    fields[1] = metrics.edges;
+    fields[2] = metrics.exceptionEdges;
+    fields[3] = static_cast<uint32_t>(metrics.cyclomaticComplexity);
+    fields[4] = metrics.maxLoopDepth;
+    fields[5] = metrics.maxNesting;
+    fields[6] = metrics.fanOut;
+}
+
+FunctionMetrics unpackMetrics(const uint32_t (&fields)[MetricsFields]) {
+    FunctionMetrics metrics;
+    metrics.blocks = fields[0];
+    metrics.edges = fields[1];
+    metrics.exceptionEdges = fields[2];
+    metrics.cyclomaticComplexity = static_cast<int32_t>(fields[3]);
+    metrics.maxLoopDepth = fields[4];
+    metrics.maxNesting = fields[5];
+    metrics.fanOut = fields[6];
+    return metrics;
+}
+
+} // namespace
+
+FunctionMetrics computeMetrics(const CSRGraph& graph, const FunctionDominators& trees,
+                               const LoopForest& loops) {
+    using Index = CSRGraph::Index;
+    FunctionMetrics metrics;
+    metrics.blocks = static_cast<uint32_t>(graph.nodeCount());
+    metrics.edges = static_cast<uint32_t>(graph.edgeCount());
+    metrics.cyclomaticComplexity = static_cast<int32_t>(metrics.edges) - static_cast<int32_t>(metrics.blocks) + 2;
+    if (graph.empty()) return metrics;
+
+    for (uint32_t e = 0; e < graph.edgeCount(); ++e) {
+        if (graph.edgeFlags(e) & EdgeException) ++metrics.exceptionEdges;
+    }
+
+    for (uint32_t l = 0; l < loops.loopCount(); ++l) {
+        metrics.maxLoopDepth = std::max(metrics.maxLoopDepth, loops.loop(l).depth);
+    }
+
+    // A branch closes at its join point; blocks dominated by the join are
+    // no longer inside it.
+    const DominatorTree& dom = trees.dominators;
+    const DominatorTree& postDom = trees.postDominators;
+    std::vector<uint32_t> closing(graph.nodeCount(), 0);
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        if (graph.outDegree(n) < 2 || postDom.nodeCount() == 0) continue;
+        const Index join = postDom.idom(n);
+        if (join != CSRGraph::InvalidIndex && dom.strictlyDominates(n, join)) {
+            ++closing[join];
+        }
+    }
+
+    // Dominators come before the nodes they dominate in reverse post-order,
+    // so each node's idom is final when the node is reached.
+    std::vector<uint32_t> openBelow(graph.nodeCount(), 0);  // branches open for n's dominator children
+    for (Index n : reversePostOrder(graph, graph.entry())) {
+        const Index parent = dom.nodeCount() ? dom.idom(n) : CSRGraph::InvalidIndex;
+        const uint32_t nesting = (parent == CSRGraph::InvalidIndex ? 0 : openBelow[parent]) - closing[n];
+        metrics.maxNesting = std::max(metrics.maxNesting, nesting);
+        openBelow[n] = nesting + (graph.outDegree(n) > 1 ? 1 : 0);
+    }
+    return metrics;
+}
+
+std::vector<FunctionMetrics> computeMetricsBatch(
+    llvm::ArrayRef<std::shared_ptr<const CSRGraph>> graphs,
+    llvm::ArrayRef<FunctionDominators> trees,
+    llvm::ArrayRef<LoopForest> loops, unsigned threads) {
+    std::vector<FunctionMetrics> results(graphs.size());
+    parallelFor(graphs.size(), [&](size_t i) {
+        if (graphs[i]) results[i] = computeMetrics(*graphs[i], trees[i], loops[i]);
+    }, threads);
+    return results;
+}
+
+bool writeMetricsCSV(const std::string& filename, const MetricsTable& rows) {
+    std::ofstream out(filename);
+    if (!out.is_open()) return false;
+
+    out << "function,blocks,edges,exception_edges,cyclomatic_complexity,max_loop_depth,max_nesting,fan_out\n";
+    for (const auto& [name, m] : rows) {
+        // Qualified names can contain commas (template arguments).
+        std::string quoted = "\"";
+        for (char c : name) {
+            quoted += c;
+            if (c == '"') quoted += '"';
+        }
+        quoted += '"';
+        out << quoted << ',' << m.blocks << ',' << m.edges << ',' << m.exceptionEdges << ','
+            << m.cyclomaticComplexity << ',' << m.maxLoopDepth << ',' << m.maxNesting << ','
+            << m.fanOut << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool writeMetricsTable(const std::string& filename, const MetricsTable& rows) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) return false;
+
+    const uint32_t count = static_cast<uint32_t>(rows.size());
+    std::vector<uint32_t> words;
+    words.reserve(2 + count * MetricsFields + count + 1);
+    words.push_back(MetricsVersion);
+    words.push_back(count);
+    for (const auto& row : rows) {
+        uint32_t fields[MetricsFields];
+        packMetrics(row.second, fields);
+        words.insert(words.end(), std::begin(fields), std::end(fields));
+    }
+    uint32_t offset = 0;
+    for (const auto& row : rows) {
+        words.push_back(offset);
+        offset += static_cast<uint32_t>(row.first.size());
+    }
+    words.push_back(offset);
+
+    out.write(MetricsMagic, sizeof(MetricsMagic));
+    out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+    for (const auto& row : rows) {
+        out.write(row.first.data(), row.first.size());
+    }
+    return static_cast<bool>(out);
+}
+
+bool readMetricsTable(const std::string& filename, MetricsTable& rows) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    char magic[sizeof(MetricsMagic)];
+    uint32_t header[2];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MetricsMagic, sizeof(magic)) != 0 ||
+        !in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != MetricsVersion) {
+        return false;
+    }
+
+    const uint32_t count = header[1];
+    std::vector<uint32_t> fields(size_t(count) * MetricsFields);
+    std::vector<uint32_t> offsets(size_t(count) + 1);
+    if (!in.read(reinterpret_cast<char*>(fields.data()), fields.size() * sizeof(uint32_t)) ||
+        !in.read(reinterpret_cast<char*>(offsets.data()), offsets.size() * sizeof(uint32_t))) {
+        return false;
+    }
+    std::string names(offsets.back(), '\0');
+    if (!in.read(names.data(), names.size())) return false;
+
+    rows.clear();
+    rows.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1] || offsets[i + 1] > names.size()) return false;
+        uint32_t record[MetricsFields];
+        std::copy_n(fields.begin() + size_t(i) * MetricsFields, MetricsFields, record);
+        rows.emplace_back(names.substr(offsets[i], offsets[i + 1] - offsets[i]), unpackMetrics(record));
+    }
+    return true;
+}
+
+} // namespace GraphGenerator
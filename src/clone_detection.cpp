@@ -0,0 +1,180 @@
+#include "clone_detection.h"
+#include "cfg_hash.h"
+#include "parallel_for.h"
+#include <algorithm>
+#include <numeric>
+#include <clang/AST/Stmt.h>
+
+namespace GraphGenerator {
+
+namespace {
+
+enum : uint64_t {
+    ShingleLabel = 1,
+    ShingleEdge = 16,
+    ShingleStatements,
+};
+
+// Disjoint sets with path halving, for joining verified pairs.
+struct DisjointSets {
+    std::vector<uint32_t> parent;
+    explicit DisjointSets(size_t n) : parent(n) { std::iota(parent.begin(), parent.end(), 0); }
+    uint32_t find(uint32_t x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    }
+    void join(uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) parent[std::max(a, b)] = std::min(a, b);
+    }
+};
+
+} // namespace
+
+std::vector<uint64_t> cfgShingles(const CSRGraph& graph) {
+    using Index = CSRGraph::Index;
+    constexpr unsigned LabelRounds = 2;
+    std::vector<uint64_t> shingles;
+    shingles.reserve(graph.nodeCount() * (LabelRounds + 2) + graph.edgeCount());
+
+    std::vector<uint64_t> labels = initialStructuralLabels(graph);
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            const uint64_t edge = mixHash(mixHash(ShingleEdge, labels[n]), labels[graph.edgeTarget(e)]);
+            shingles.push_back(mixHash(edge, graph.edgeFlags(e)));
+        }
+    }
+    for (unsigned round = 0; round <= LabelRounds; ++round) {
+        if (round > 0) refineStructuralLabels(graph, labels);
+        for (uint64_t label : labels) {
+            shingles.push_back(mixHash(ShingleLabel + round, label));
+        }
+    }
+
+    // Statement kinds in order, which the labels only see per block.
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        const llvm::ArrayRef<const clang::Stmt*> handles = graph.statementHandles(n);
+        for (size_t i = 0; i + 3 <= handles.size(); ++i) {
+            uint64_t gram = ShingleStatements;
+            for (size_t j = i; j < i + 3; ++j) {
+                gram = mixHash(gram, handles[j] ? static_cast<uint64_t>(handles[j]->getStmtClass()) : 0);
+            }
+            shingles.push_back(gram);
+        }
+    }
+
+    std::sort(shingles.begin(), shingles.end());
+    shingles.erase(std::unique(shingles.begin(), shingles.end()), shingles.end());
+    return shingles;
+}
+
+CloneIndex::CloneIndex(const CloneDetectionOptions& options) : m_options(options) {
+    m_options.signatureSize = std::max(1u, m_options.signatureSize);
+    m_options.rowsPerBand = std::clamp(m_options.rowsPerBand, 1u, m_options.signatureSize);
+    // Slot i hashes a shingle as the high half of an odd multiplier times
+    // the shingle (multiply-shift), which is cheap enough to apply
+    // signatureSize times per shingle.
+    m_multipliers.reserve(m_options.signatureSize);
+    for (uint32_t i = 0; i < m_options.signatureSize; ++i) {
+        m_multipliers.push_back(mixHash(0x636c6f6e65ull, i) | 1);
+    }
+}
+
+void CloneIndex::addFunctions(const std::vector<std::string>& names,
+                              const std::vector<std::shared_ptr<const CSRGraph>>& graphs) {
+    const uint32_t width = m_options.signatureSize;
+    std::vector<uint32_t> signatures(graphs.size() * width, 0);
+    std::vector<uint8_t> accepted(graphs.size(), 0);
+
+    parallelFor(graphs.size(), [&](size_t i) {
+        const CSRGraph* graph = graphs[i].get();
+        if (!graph || graph->nodeCount() < m_options.minBlocks) return;
+        const std::vector<uint64_t> shingles = cfgShingles(*graph);
+        uint32_t* signature = signatures.data() + i * width;
+        std::fill(signature, signature + width, ~0u);
+        for (uint64_t shingle : shingles) {
+            for (uint32_t slot = 0; slot < width; ++slot) {
+                signature[slot] = std::min(signature[slot], static_cast<uint32_t>((shingle * m_multipliers[slot]) >> 32));
+            }
+        }
+        accepted[i] = 1;
+    }, m_options.threads);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < graphs.size(); ++i) {
+        if (!accepted[i]) continue;
+        m_names.push_back(names[i]);
+        m_signatures.insert(m_signatures.end(), signatures.begin() + i * width, signatures.begin() + (i + 1) * width);
+    }
+}
+
+double CloneIndex::similarity(uint32_t a, uint32_t b) const {
+    const uint32_t* first = signature(a);
+    const uint32_t* second = signature(b);
+    uint32_t equal = 0;
+    for (uint32_t slot = 0; slot < m_options.signatureSize; ++slot) {
+        equal += first[slot] == second[slot];
+    }
+    return double(equal) / m_options.signatureSize;
+}
+
+std::vector<CloneGroup> CloneIndex::findGroups() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint32_t functions = static_cast<uint32_t>(m_names.size());
+    const uint32_t rows = m_options.rowsPerBand;
+    const uint32_t bands = m_options.signatureSize / rows;
+
+    // Each band is bucketed on its own thread; verified pairs are kept
+    // per band and joined afterwards.
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> pairs(bands);
+    parallelFor(bands, [&](size_t band) {
+        std::vector<std::pair<uint64_t, uint32_t>> keys(functions);
+        for (uint32_t f = 0; f < functions; ++f) {
+            uint64_t key = band;
+            const uint32_t* values = signature(f) + band * rows;
+            for (uint32_t r = 0; r < rows; ++r) key = mixHash(key, values[r]);
+            keys[f] = {key, f};
+        }
+        std::sort(keys.begin(), keys.end());
+        for (size_t begin = 0; begin < keys.size();) {
+            size_t end = begin + 1;
+            while (end < keys.size() && keys[end].first == keys[begin].first) ++end;
+            for (size_t i = begin + 1; i < end; ++i) {
+                const uint32_t f = keys[i].second;
+                if (similarity(keys[begin].second, f) >= m_options.minSimilarity) {
+                    pairs[band].push_back({keys[begin].second, f});
+                } else if (i > begin + 1 && similarity(keys[i - 1].second, f) >= m_options.minSimilarity) {
+                    pairs[band].push_back({keys[i - 1].second, f});
+                }
+            }
+            begin = end;
+        }
+    }, m_options.threads);
+
+    DisjointSets sets(functions);
+    for (const auto& bandPairs : pairs) {
+        for (const auto& [a, b] : bandPairs) sets.join(a, b);
+    }
+
+    // Roots are the smallest member, so groups come out in index order.
+    std::vector<uint32_t> groupOf(functions, ~0u);
+    std::vector<CloneGroup> groups;
+    for (uint32_t f = 0; f < functions; ++f) {
+        const uint32_t root = sets.find(f);
+        if (root == f) continue;
+        if (groupOf[root] == ~0u) {
+            groupOf[root] = static_cast<uint32_t>(groups.size());
+            groups.push_back({{root}, {1.0}});
+        }
+        CloneGroup& group = groups[groupOf[root]];
+        group.functions.push_back(f);
+        group.similarity.push_back(similarity(root, f));
+    }
+    std::stable_sort(groups.begin(), groups.end(), [](const CloneGroup& a, const CloneGroup& b) {
+        return a.functions.size() > b.functions.size();
+    });
+    return groups;
+}
+
+} // namespace GraphGenerator
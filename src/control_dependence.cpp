@@ -0,0 +1,156 @@
+#include "control_dependence.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace GraphGenerator {
+
+namespace {
+
+constexpr char TableMagic[4] = {'C', 'F', 'G', 'C'};
+constexpr uint32_t TableVersion = 1;
+
+} // namespace
+
+ControlDependence ControlDependence::build(const CSRGraph& graph, const DominatorTree& postDominators) {
+    ControlDependence cd;
+    const size_t nodeCount = graph.nodeCount();
+
+    // (dependent, controller, edge), collected per controller so that one
+    // marker per dependent is enough to drop duplicates.
+    struct Dependence {
+        Index dependent;
+        Index controller;
+        uint32_t edge;
+    };
+    std::vector<Dependence> found;
+    std::vector<Index> lastController(nodeCount, CSRGraph::InvalidIndex);
+    for (Index a = 0; a < nodeCount; ++a) {
+        if (graph.outDegree(a) < 2) continue;  // only branches decide anything
+        const Index stop = postDominators.idom(a);
+        for (uint32_t e = graph.edgeBegin(a); e < graph.edgeEnd(a); ++e) {
+            for (Index runner = graph.edgeTarget(e); runner != stop && runner != CSRGraph::InvalidIndex;
+                 runner = postDominators.idom(runner)) {
+                if (lastController[runner] == a) continue;
+                lastController[runner] = a;
+                found.push_back({runner, a, e});
+                if (!postDominators.isReachable(runner)) break;
+            }
+        }
+    }
+
+    // Counting sort into both CSR directions; controllers come out
+    // ascending because they were visited in index order.
+    cd.m_controllerOffsets.assign(nodeCount + 1, 0);
+    cd.m_dependentOffsets.assign(nodeCount + 1, 0);
+    for (const Dependence& d : found) {
+        ++cd.m_controllerOffsets[d.dependent + 1];
+        ++cd.m_dependentOffsets[d.controller + 1];
+    }
+    for (size_t n = 0; n < nodeCount; ++n) {
+        cd.m_controllerOffsets[n + 1] += cd.m_controllerOffsets[n];
+        cd.m_dependentOffsets[n + 1] += cd.m_dependentOffsets[n];
+    }
+    cd.m_controllers.resize(found.size());
+    cd.m_controllingEdges.resize(found.size());
+    cd.m_dependents.resize(found.size());
+    std::vector<uint32_t> controllerCursor(cd.m_controllerOffsets.begin(), cd.m_controllerOffsets.end() - 1);
+    std::vector<uint32_t> dependentCursor(cd.m_dependentOffsets.begin(), cd.m_dependentOffsets.end() - 1);
+    for (const Dependence& d : found) {
+        const uint32_t slot = controllerCursor[d.dependent]++;
+        cd.m_controllers[slot] = d.controller;
+        cd.m_controllingEdges[slot] = d.edge;
+        cd.m_dependents[dependentCursor[d.controller]++] = d.dependent;
+    }
+    for (size_t n = 0; n < nodeCount; ++n) {
+        std::sort(cd.m_dependents.begin() + cd.m_dependentOffsets[n], cd.m_dependents.begin() + cd.m_dependentOffsets[n + 1]);
+    }
+    return cd;
+}
+
+std::vector<std::pair<int, int>> controlDependencePairs(const CSRGraph& graph, const ControlDependence& dependence) {
+    std::vector<std::pair<int, int>> pairs;
+    pairs.reserve(dependence.dependenceCount());
+    for (CSRGraph::Index n = 0; n < dependence.nodeCount(); ++n) {
+        for (CSRGraph::Index controller : dependence.controllers(n)) {
+            pairs.emplace_back(graph.blockId(n), graph.blockId(controller));
+        }
+    }
+    return pairs;
+}
+
+bool writeControlDependenceTable(const std::string& filename, const ControlDependenceTable& rows) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) return false;
+
+    const uint32_t count = static_cast<uint32_t>(rows.size());
+    std::vector<uint32_t> words;
+    words.push_back(TableVersion);
+    words.push_back(count);
+    uint32_t offset = 0;
+    for (const auto& row : rows) {
+        words.push_back(offset);
+        offset += static_cast<uint32_t>(row.second.size());
+    }
+    words.push_back(offset);
+    for (const auto& row : rows) {
+        for (const auto& [block, controller] : row.second) {
+            words.push_back(static_cast<uint32_t>(block));
+            words.push_back(static_cast<uint32_t>(controller));
+        }
+    }
+    offset = 0;
+    for (const auto& row : rows) {
+        words.push_back(offset);
+        offset += static_cast<uint32_t>(row.first.size());
+    }
+    words.push_back(offset);
+
+    out.write(TableMagic, sizeof(TableMagic));
+    out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+    for (const auto& row : rows) {
+        out.write(row.first.data(), row.first.size());
+    }
+    return static_cast<bool>(out);
+}
+
+bool readControlDependenceTable(const std::string& filename, ControlDependenceTable& rows) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    char magic[sizeof(TableMagic)];
+    uint32_t header[2];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, TableMagic, sizeof(magic)) != 0 ||
+        !in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != TableVersion) {
+        return false;
+    }
+
+    const uint32_t count = header[1];
+    std::vector<uint32_t> pairOffsets(size_t(count) + 1);
+    if (!in.read(reinterpret_cast<char*>(pairOffsets.data()), pairOffsets.size() * sizeof(uint32_t))) {
+        return false;
+    }
+    std::vector<int32_t> pairs(size_t(pairOffsets.back()) * 2);
+    std::vector<uint32_t> nameOffsets(size_t(count) + 1);
+    if (!in.read(reinterpret_cast<char*>(pairs.data()), pairs.size() * sizeof(int32_t)) ||
+        !in.read(reinterpret_cast<char*>(nameOffsets.data()), nameOffsets.size() * sizeof(uint32_t))) {
+        return false;
+    }
+    std::string names(nameOffsets.back(), '\0');
+    if (!in.read(names.data(), names.size())) return false;
+
+    rows.clear();
+    rows.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (pairOffsets[i] > pairOffsets[i + 1] || nameOffsets[i] > nameOffsets[i + 1]) return false;
+        std::vector<std::pair<int, int>> dependences;
+        dependences.reserve(pairOffsets[i + 1] - pairOffsets[i]);
+        for (uint32_t p = pairOffsets[i]; p < pairOffsets[i + 1]; ++p) {
+            dependences.emplace_back(pairs[2 * p], pairs[2 * p + 1]);
+        }
+        rows.emplace_back(names.substr(nameOffsets[i], nameOffsets[i + 1] - nameOffsets[i]), std::move(dependences));
+    }
+    return true;
+}
+
+} // namespace GraphGenerator
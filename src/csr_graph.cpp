@@ -0,0 +1,488 @@
+#include "csr_graph.h"
+#include <algorithm>
+#include <numeric>
+
+namespace GraphGenerator {
+
+namespace {
+
+// Backing store for a CSRGraph produced by CSRGraphBuilder. The arrays
+// live in the session arena and the strings in its pool; the session is
+// declared first so it is released after the arrays.
+struct CSRStorage {
+    explicit CSRStorage(std::shared_ptr<AnalysisSession> owner)
+        : session(std::move(owner)),
+          ids(session->resource()),
+          offsets(session->resource()),
+          targets(session->resource()),
+          edgeFlags(session->resource()),
+          predOffsets(session->resource()),
+          predSources(session->resource()),
+          predEdges(session->resource()),
+          attributes(session->resource()),
+          labels(session->resource()),
+          stmtOffsets(session->resource()),
+          stmtStrings(session->resource()),
+          stmtHandles(session->resource()),
+          terminators(session->resource()),
+          strings(session->resource()),
+          varNames(session->resource()),
+          varDecls(session->resource()),
+          varsByDecl(session->resource()),
+          defOffsets(session->resource()),
+          defSites(session->resource()),
+          useOffsets(session->resource()),
+          useSites(session->resource()),
+          blockDefOffsets(session->resource()),
+          blockDefVars(session->resource()),
+          blockUseOffsets(session->resource()),
+          blockUseVars(session->resource()) {}
+
+    std::shared_ptr<AnalysisSession> session;
+    std::pmr::vector<int> ids;
+    std::pmr::vector<uint32_t> offsets;
+    std::pmr::vector<CSRGraph::Index> targets;
+    std::pmr::vector<uint8_t> edgeFlags;
+    std::pmr::vector<uint32_t> predOffsets;
+    std::pmr::vector<CSRGraph::Index> predSources;
+    std::pmr::vector<uint32_t> predEdges;
+    std::pmr::vector<uint32_t> attributes;
+    std::pmr::vector<uint32_t> labels;
+    std::pmr::vector<uint32_t> stmtOffsets;
+    std::pmr::vector<uint32_t> stmtStrings;
+    std::pmr::vector<const clang::Stmt*> stmtHandles;
+    std::pmr::vector<const clang::Stmt*> terminators;
+    std::pmr::vector<std::string_view> strings;
+    std::pmr::vector<uint32_t> varNames;
+    std::pmr::vector<const clang::VarDecl*> varDecls;
+    std::pmr::vector<uint32_t> varsByDecl;
+    std::pmr::vector<uint32_t> defOffsets;
+    std::pmr::vector<CSRGraph::VariableSite> defSites;
+    std::pmr::vector<uint32_t> useOffsets;
+    std::pmr::vector<CSRGraph::VariableSite> useSites;
+    std::pmr::vector<uint32_t> blockDefOffsets;
+    std::pmr::vector<uint32_t> blockDefVars;
+    std::pmr::vector<uint32_t> blockUseOffsets;
+    std::pmr::vector<uint32_t> blockUseVars;
+};
+
+// Groups (key, value) pairs into CSR rows over keys [0, keyCount): each row
+// is sorted and free of duplicates.
+template <typename Value>
+void buildSortedRows(size_t keyCount, const std::vector<std::pair<uint32_t, Value>>& pairs,
+                     std::pmr::vector<uint32_t>& offsets, std::pmr::vector<Value>& values) {
+    std::vector<uint32_t> rowStart(keyCount + 1, 0);
+    for (const auto& pair : pairs) {
+        ++rowStart[pair.first + 1];
+    }
+    std::partial_sum(rowStart.begin(), rowStart.end(), rowStart.begin());
+    std::vector<Value> bucketed(pairs.size());
+    {
+        std::vector<uint32_t> cursor(rowStart.begin(), rowStart.end() - 1);
+        for (const auto& pair : pairs) {
+            bucketed[cursor[pair.first]++] = pair.second;
+        }
+    }
+    offsets.resize(keyCount + 1);
+    values.reserve(pairs.size());
+    for (size_t key = 0; key < keyCount; ++key) {
+        offsets[key] = static_cast<uint32_t>(values.size());
+        auto first = bucketed.begin() + rowStart[key];
+        auto last = bucketed.begin() + rowStart[key + 1];
+        std::sort(first, last);
+        values.insert(values.end(), first, std::unique(first, last));
+    }
+    offsets[keyCount] = static_cast<uint32_t>(values.size());
+}
+
+} // namespace
+
+CSRGraph::Index CSRGraph::indexOf(int blockId) const {
+    if (m_denseIds) {
+        return blockId >= 0 && static_cast<size_t>(blockId) < m_ids.size()
+            ? static_cast<Index>(blockId) : InvalidIndex;
+    }
+    auto it = std::lower_bound(m_ids.begin(), m_ids.end(), blockId);
+    if (it == m_ids.end() || *it != blockId) return InvalidIndex;
+    return static_cast<Index>(it - m_ids.begin());
+}
+
+uint32_t CSRGraph::findEdge(Index from, Index to) const {
+    llvm::ArrayRef<Index> row = successors(from);
+    auto it = std::lower_bound(row.begin(), row.end(), to);
+    if (it == row.end() || *it != to) return InvalidIndex;
+    return edgeBegin(from) + static_cast<uint32_t>(it - row.begin());
+}
+
+llvm::ArrayRef<const clang::Stmt*> CSRGraph::statementHandles(Index n) const {
+    if (m_stmtHandles.empty()) return {};
+    return m_stmtHandles.slice(m_stmtOffsets[n], m_stmtOffsets[n + 1] - m_stmtOffsets[n]);
+}
+
+uint32_t CSRGraph::findVariable(const clang::VarDecl* decl) const {
+    if (!decl) return InvalidIndex;
+    auto it = std::lower_bound(m_varsByDecl.begin(), m_varsByDecl.end(), decl,
+                               [this](uint32_t v, const clang::VarDecl* key) { return m_varDecls[v] < key; });
+    if (it == m_varsByDecl.end() || m_varDecls[*it] != decl) return InvalidIndex;
+    return *it;
+}
+
+std::vector<uint32_t> CSRGraph::findVariables(std::string_view name) const {
+    std::vector<uint32_t> matches;
+    for (uint32_t v = 0; v < m_varNames.size(); ++v) {
+        if (variableName(v) == name) matches.push_back(v);
+    }
+    return matches;
+}
+
+llvm::ArrayRef<uint32_t> CSRGraph::variablesDefinedIn(Index n) const {
+    if (m_blockDefOffsets.empty()) return {};
+    return m_blockDefVars.slice(m_blockDefOffsets[n], m_blockDefOffsets[n + 1] - m_blockDefOffsets[n]);
+}
+
+llvm::ArrayRef<uint32_t> CSRGraph::variablesUsedIn(Index n) const {
+    if (m_blockUseOffsets.empty()) return {};
+    return m_blockUseVars.slice(m_blockUseOffsets[n], m_blockUseOffsets[n + 1] - m_blockUseOffsets[n]);
+}
+
+bool CSRGraph::isExceptionEdge(int sourceID, int targetID) const {
+    Index from = indexOf(sourceID);
+    Index to = indexOf(targetID);
+    if (from == InvalidIndex || to == InvalidIndex) return false;
+    uint32_t edge = findEdge(from, to);
+    return edge != InvalidIndex && (m_edgeFlags[edge] & EdgeException);
+}
+
+bool CSRGraph::isNodeTryBlock(int nodeID) const {
+    Index n = indexOf(nodeID);
+    return n != InvalidIndex && hasAttribute(n, NodeTryBlock);
+}
+
+bool CSRGraph::isNodeThrowingException(int nodeID) const {
+    Index n = indexOf(nodeID);
+    return n != InvalidIndex && hasAttribute(n, NodeThrowsException);
+}
+
+CSRGraphBuilder::CSRGraphBuilder(std::shared_ptr<AnalysisSession> session)
+    : m_session(session ? std::move(session) : std::make_shared<AnalysisSession>()) {}
+
+void CSRGraphBuilder::reserve(size_t nodes, size_t edges, size_t statements) {
+    m_ids.reserve(nodes);
+    m_labels.reserve(nodes);
+    m_attributes.reserve(nodes);
+    m_slots.reserve(nodes);
+    m_edges.reserve(edges);
+    m_statements.reserve(statements);
+    m_strings.reserve(nodes + statements);
+}
+
+uint32_t CSRGraphBuilder::slotFor(int id) {
+    auto [it, inserted] = m_slots.try_emplace(id, static_cast<uint32_t>(m_ids.size()));
+    if (inserted) {
+        m_ids.push_back(id);
+        m_labels.push_back(CSRGraph::InvalidIndex);
+        m_attributes.push_back(NodeNone);
+        if (m_hasTerminators) {
+            m_terminators.push_back(nullptr);
+        }
+    }
+    return it->second;
+}
+
+uint32_t CSRGraphBuilder::appendString(std::string_view text) {
+    std::string_view interned = m_session->intern(text);
+    auto [it, inserted] = m_stringIds.try_emplace(interned.data(), static_cast<uint32_t>(m_strings.size()));
+    if (inserted) {
+        m_strings.push_back(interned);
+    }
+    return it->second;
+}
+
+void CSRGraphBuilder::addNode(int id, std::string_view label) {
+    uint32_t slot = slotFor(id);
+    if (!label.empty()) {
+        m_labels[slot] = appendString(label);
+    }
+}
+
+void CSRGraphBuilder::addEdge(int fromID, int toID, uint8_t flags) {
+    uint32_t from = slotFor(fromID);
+    uint32_t to = slotFor(toID);
+    m_edges.push_back({from, to, flags});
+}
+
+void CSRGraphBuilder::addStatement(int nodeID, std::string_view text, const clang::Stmt* handle) {
+    uint32_t slot = slotFor(nodeID);
+    m_statements.push_back({slot, appendString(text), handle});
+    m_hasHandles |= handle != nullptr;
+}
+
+void CSRGraphBuilder::setTerminator(int nodeID, const clang::Stmt* terminator) {
+    if (!m_hasTerminators) {
+        m_terminators.assign(m_ids.size(), nullptr);
+        m_hasTerminators = true;
+    }
+    uint32_t slot = slotFor(nodeID);
+    m_terminators[slot] = terminator;
+}
+
+void CSRGraphBuilder::addAttributes(int nodeID, uint32_t attributes) {
+    m_attributes[slotFor(nodeID)] |= attributes;
+}
+
+void CSRGraphBuilder::setEntry(int nodeID) {
+    slotFor(nodeID);
+    m_entryID = nodeID;
+    m_hasEntry = true;
+}
+
+void CSRGraphBuilder::setExit(int nodeID) {
+    slotFor(nodeID);
+    m_exitID = nodeID;
+    m_hasExit = true;
+}
+
+void CSRGraphBuilder::addVariableAccess(int nodeID, uint32_t element, std::string_view name,
+                                        const clang::VarDecl* decl, AccessKind kind) {
+    const uint32_t slot = slotFor(nodeID);
+    const uint32_t nameID = appendString(name);
+    const void* key = decl ? static_cast<const void*>(decl) : m_strings[nameID].data();
+    auto [it, inserted] = m_varIds.try_emplace(key, static_cast<uint32_t>(m_varNames.size()));
+    if (inserted) {
+        m_varNames.push_back(nameID);
+        m_varDecls.push_back(decl);
+    }
+    m_accesses.push_back({slot, element, it->second, kind});
+}
+
+CSRGraph CSRGraphBuilder::freeze() {
+    using Index = CSRGraph::Index;
+    auto storage = std::make_shared<CSRStorage>(m_session);
+    const size_t nodeCount = m_ids.size();
+
+    // Order nodes by block ID. Graphs converted from clang::CFG arrive in
+    // ID order already, so the sort is skipped for them.
+    std::vector<uint32_t> order(nodeCount);
+    std::iota(order.begin(), order.end(), 0u);
+    if (!std::is_sorted(m_ids.begin(), m_ids.end())) {
+        std::sort(order.begin(), order.end(),
+                  [this](uint32_t a, uint32_t b) { return m_ids[a] < m_ids[b]; });
+    }
+    std::vector<Index> slotToIndex(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        slotToIndex[order[i]] = static_cast<Index>(i);
+    }
+
+    bool denseIds = true;
+    storage->ids.resize(nodeCount);
+    storage->attributes.resize(nodeCount);
+    storage->labels.resize(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        uint32_t slot = order[i];
+        storage->ids[i] = m_ids[slot];
+        storage->attributes[i] = m_attributes[slot];
+        denseIds &= m_ids[slot] == static_cast<int>(i);
+        storage->labels[i] = m_labels[slot] != CSRGraph::InvalidIndex
+            ? m_labels[slot]
+            : appendString("Block " + std::to_string(m_ids[slot]));
+    }
+
+    // Bucket edges by source, then sort each row by target and merge
+    // duplicates so rows match the iteration order of a std::set.
+    std::vector<uint32_t> rowStart(nodeCount + 1, 0);
+    for (const PendingEdge& edge : m_edges) {
+        ++rowStart[slotToIndex[edge.from] + 1];
+    }
+    std::partial_sum(rowStart.begin(), rowStart.end(), rowStart.begin());
+    std::vector<std::pair<Index, uint8_t>> bucketed(m_edges.size());
+    {
+        std::vector<uint32_t> cursor(rowStart.begin(), rowStart.end() - 1);
+        for (const PendingEdge& edge : m_edges) {
+            bucketed[cursor[slotToIndex[edge.from]]++] = {slotToIndex[edge.to], edge.flags};
+        }
+    }
+    storage->offsets.resize(nodeCount + 1);
+    storage->targets.reserve(m_edges.size());
+    storage->edgeFlags.reserve(m_edges.size());
+    for (size_t n = 0; n < nodeCount; ++n) {
+        storage->offsets[n] = static_cast<uint32_t>(storage->targets.size());
+        auto first = bucketed.begin() + rowStart[n];
+        auto last = bucketed.begin() + rowStart[n + 1];
+        std::sort(first, last, [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (auto it = first; it != last; ++it) {
+            if (storage->targets.size() > storage->offsets[n] && storage->targets.back() == it->first) {
+                storage->edgeFlags.back() |= it->second;
+            } else {
+                storage->targets.push_back(it->first);
+                storage->edgeFlags.push_back(it->second);
+            }
+        }
+    }
+    storage->offsets[nodeCount] = static_cast<uint32_t>(storage->targets.size());
+
+    // Reverse index by counting sort over the targets. Sources are visited
+    // in index order, so every predecessor row comes out sorted.
+    const size_t edgeCount = storage->targets.size();
+    storage->predOffsets.assign(nodeCount + 1, 0);
+    for (Index target : storage->targets) {
+        ++storage->predOffsets[target + 1];
+    }
+    std::partial_sum(storage->predOffsets.begin(), storage->predOffsets.end(), storage->predOffsets.begin());
+    storage->predSources.resize(edgeCount);
+    storage->predEdges.resize(edgeCount);
+    {
+        std::vector<uint32_t> cursor(storage->predOffsets.begin(), storage->predOffsets.end() - 1);
+        for (size_t n = 0; n < nodeCount; ++n) {
+            for (uint32_t e = storage->offsets[n]; e < storage->offsets[n + 1]; ++e) {
+                uint32_t pos = cursor[storage->targets[e]]++;
+                storage->predSources[pos] = static_cast<Index>(n);
+                storage->predEdges[pos] = e;
+            }
+        }
+    }
+
+    // Stable bucket sort of statements by node keeps per-block order.
+    storage->stmtOffsets.assign(nodeCount + 1, 0);
+    for (const PendingStatement& stmt : m_statements) {
+        ++storage->stmtOffsets[slotToIndex[stmt.node] + 1];
+    }
+    std::partial_sum(storage->stmtOffsets.begin(), storage->stmtOffsets.end(), storage->stmtOffsets.begin());
+    storage->stmtStrings.resize(m_statements.size());
+    if (m_hasHandles) {
+        storage->stmtHandles.resize(m_statements.size(), nullptr);
+    }
+    {
+        std::vector<uint32_t> cursor(storage->stmtOffsets.begin(), storage->stmtOffsets.end() - 1);
+        for (const PendingStatement& stmt : m_statements) {
+            uint32_t pos = cursor[slotToIndex[stmt.node]]++;
+            storage->stmtStrings[pos] = stmt.text;
+            if (m_hasHandles) {
+                storage->stmtHandles[pos] = stmt.handle;
+            }
+        }
+    }
+
+    if (m_hasTerminators) {
+        storage->terminators.resize(nodeCount);
+        for (size_t i = 0; i < nodeCount; ++i) {
+            storage->terminators[i] = m_terminators[order[i]];
+        }
+    }
+
+    // Without an explicit entry/exit, follow clang's numbering: the entry
+    // is the highest-numbered block without predecessors and the exit the
+    // lowest-numbered block without successors.
+    Index entry = CSRGraph::InvalidIndex;
+    Index exit = CSRGraph::InvalidIndex;
+    if (nodeCount > 0) {
+        if (m_hasEntry) {
+            entry = slotToIndex[m_slots[m_entryID]];
+        } else {
+            entry = static_cast<Index>(nodeCount - 1);
+            for (size_t i = nodeCount; i-- > 0;) {
+                if (storage->predOffsets[i] == storage->predOffsets[i + 1]) {
+                    entry = static_cast<Index>(i);
+                    break;
+                }
+            }
+        }
+        if (m_hasExit) {
+            exit = slotToIndex[m_slots[m_exitID]];
+        } else {
+            exit = 0;
+            for (size_t i = 0; i < nodeCount; ++i) {
+                if (storage->offsets[i] == storage->offsets[i + 1]) {
+                    exit = static_cast<Index>(i);
+                    break;
+                }
+            }
+        }
+        storage->attributes[entry] |= NodeEntry;
+        storage->attributes[exit] |= NodeExit;
+    }
+
+    // Def-use rows by variable and by block.
+    if (!m_accesses.empty()) {
+        using Site = CSRGraph::VariableSite;
+        const size_t varCount = m_varNames.size();
+        std::vector<std::pair<uint32_t, Site>> defs;
+        std::vector<std::pair<uint32_t, Site>> uses;
+        std::vector<std::pair<uint32_t, uint32_t>> blockDefs;
+        std::vector<std::pair<uint32_t, uint32_t>> blockUses;
+        for (const PendingAccess& access : m_accesses) {
+            const Site site{slotToIndex[access.node], access.element};
+            if (access.kind != AccessKind::Read) {
+                defs.push_back({access.variable, site});
+                blockDefs.push_back({site.block, access.variable});
+            }
+            if (access.kind != AccessKind::Write) {
+                uses.push_back({access.variable, site});
+                blockUses.push_back({site.block, access.variable});
+            }
+        }
+        buildSortedRows(varCount, defs, storage->defOffsets, storage->defSites);
+        buildSortedRows(varCount, uses, storage->useOffsets, storage->useSites);
+        buildSortedRows(nodeCount, blockDefs, storage->blockDefOffsets, storage->blockDefVars);
+        buildSortedRows(nodeCount, blockUses, storage->blockUseOffsets, storage->blockUseVars);
+
+        storage->varNames.assign(m_varNames.begin(), m_varNames.end());
+        if (std::any_of(m_varDecls.begin(), m_varDecls.end(), [](const clang::VarDecl* d) { return d; })) {
+            storage->varDecls.assign(m_varDecls.begin(), m_varDecls.end());
+            storage->varsByDecl.resize(varCount);
+            std::iota(storage->varsByDecl.begin(), storage->varsByDecl.end(), 0u);
+            std::sort(storage->varsByDecl.begin(), storage->varsByDecl.end(),
+                      [this](uint32_t a, uint32_t b) { return m_varDecls[a] < m_varDecls[b]; });
+        }
+    }
+
+    storage->strings.assign(m_strings.begin(), m_strings.end());
+
+    CSRGraph graph;
+    graph.m_ids = storage->ids;
+    graph.m_offsets = storage->offsets;
+    graph.m_targets = storage->targets;
+    graph.m_edgeFlags = storage->edgeFlags;
+    graph.m_predOffsets = storage->predOffsets;
+    graph.m_predSources = storage->predSources;
+    graph.m_predEdges = storage->predEdges;
+    graph.m_attributes = storage->attributes;
+    graph.m_labels = storage->labels;
+    graph.m_stmtOffsets = storage->stmtOffsets;
+    graph.m_stmtStrings = storage->stmtStrings;
+    graph.m_stmtHandles = storage->stmtHandles;
+    graph.m_terminators = storage->terminators;
+    graph.m_strings = storage->strings;
+    graph.m_varNames = storage->varNames;
+    graph.m_varDecls = storage->varDecls;
+    graph.m_varsByDecl = storage->varsByDecl;
+    graph.m_defOffsets = storage->defOffsets;
+    graph.m_defSites = storage->defSites;
+    graph.m_useOffsets = storage->useOffsets;
+    graph.m_useSites = storage->useSites;
+    graph.m_blockDefOffsets = storage->blockDefOffsets;
+    graph.m_blockDefVars = storage->blockDefVars;
+    graph.m_blockUseOffsets = storage->blockUseOffsets;
+    graph.m_blockUseVars = storage->blockUseVars;
+    graph.m_entry = entry;
+    graph.m_exit = exit;
+    graph.m_denseIds = denseIds;
+    graph.m_storage = std::move(storage);
+
+    m_ids.clear();
+    m_labels.clear();
+    m_attributes.clear();
+    m_terminators.clear();
+    m_slots.clear();
+    m_edges.clear();
+    m_statements.clear();
+    m_strings.clear();
+    m_stringIds.clear();
+    m_accesses.clear();
+    m_varNames.clear();
+    m_varDecls.clear();
+    m_varIds.clear();
+    m_hasHandles = m_hasTerminators = m_hasEntry = m_hasExit = false;
+    return graph;
+}
+
+} // namespace GraphGenerator
@@ -0,0 +1,264 @@
+#include "dataflow.h"
+#include "graph_traversal.h"
+#include <algorithm>
+
+namespace GraphGenerator {
+
+size_t BitMatrix::count(size_t r) const {
+    size_t total = 0;
+    const uint64_t* words = row(r);
+    for (size_t w = 0; w < m_words; ++w) {
+        total += __builtin_popcountll(words[w]);
+    }
+    return total;
+}
+
+// Pending nodes keyed by their reverse post-order position. The scan resumes
+// after the last node taken and wraps around, so one sweep visits every
+// pending node in RPO before any is visited twice.
+class RPOWorklist {
+public:
+    explicit RPOWorklist(size_t size)
+        : m_bits((size + 63) / 64, ~uint64_t(0)), m_size(size), m_pending(size) {
+        if (size % 64) m_bits.back() = (uint64_t(1) << (size % 64)) - 1;
+    }
+
+    bool empty() const { return m_pending == 0; }
+
+    void push(uint32_t position) {
+        uint64_t& word = m_bits[position / 64];
+        const uint64_t bit = uint64_t(1) << (position % 64);
+        if (!(word & bit)) {
+            word |= bit;
+            ++m_pending;
+        }
+    }
+
+    uint32_t pop() {
+        size_t w = m_cursor / 64;
+        uint64_t word = m_bits[w] & (~uint64_t(0) << (m_cursor % 64));
+        while (!word) {
+            w = w + 1 == m_bits.size() ? 0 : w + 1;
+            word = m_bits[w];
+        }
+        const uint32_t position = static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+        m_bits[w] &= ~(uint64_t(1) << (position % 64));
+        --m_pending;
+        m_cursor = position + 1 == m_size ? 0 : position + 1;
+        return position;
+    }
+
+private:
+    std::vector<uint64_t> m_bits;
+    size_t m_size;
+    size_t m_pending;
+    size_t m_cursor = 0;
+};
+
+class DataflowEngine {
+public:
+    // Reverse post-order from the start node, followed by the nodes it does
+    // not reach in index order so that every node gets a fixed point.
+    template <typename GraphT>
+    static std::vector<CSRGraph::Index> evaluationOrder(const GraphT& graph, CSRGraph::Index start) {
+        std::vector<CSRGraph::Index> order = reversePostOrder(graph, start);
+        if (order.size() < graph.nodeCount()) {
+            std::vector<bool> seen(graph.nodeCount(), false);
+            for (CSRGraph::Index n : order) seen[n] = true;
+            for (CSRGraph::Index n = 0; n < graph.nodeCount(); ++n) {
+                if (!seen[n]) order.push_back(n);
+            }
+        }
+        return order;
+    }
+
+    static uint32_t classCount(const GenKillProblem& problem) {
+        uint32_t count = 0;
+        for (uint32_t c : problem.factClass) count = std::max(count, c + 1);
+        return count;
+    }
+
+    template <typename GraphT>
+    static DataflowResult solveDense(const GraphT& graph, const GenKillProblem& problem) {
+        const size_t nodes = graph.nodeCount();
+        const CSRGraph::Index start = graph.entry();
+        const bool intersect = problem.meet == DataflowMeet::Intersection;
+
+        BitMatrix gen(nodes, problem.domainSize);
+        BitMatrix kill(nodes, problem.domainSize);
+        BitMatrix boundary(1, problem.domainSize);
+        for (const auto& [n, bit] : problem.gen) gen.set(n, bit);
+        for (const auto& [n, bit] : problem.kill) kill.set(n, bit);
+        for (uint32_t bit : problem.boundary) boundary.set(0, bit);
+        if (!problem.killClasses.empty()) {
+            const uint32_t count = classCount(problem);
+            BitMatrix classes(count, problem.domainSize);
+            for (uint32_t fact = 0; fact < problem.factClass.size(); ++fact) {
+                classes.set(problem.factClass[fact], fact);
+            }
+            for (const auto& [n, c] : problem.killClasses) {
+                if (c >= count) continue;  // a class without facts
+                const uint64_t* classRow = classes.row(c);
+                uint64_t* killRow = kill.row(n);
+                for (size_t w = 0; w < kill.words(); ++w) killRow[w] |= classRow[w];
+            }
+        }
+
+        DataflowResult result;
+        result.in.m_dense = BitMatrix(nodes, problem.domainSize);
+        result.out.m_dense = BitMatrix(nodes, problem.domainSize);
+        BitMatrix& in = result.in.m_dense;
+        BitMatrix& out = result.out.m_dense;
+        const size_t words = in.words();
+
+        // Intersection problems start from the full domain so that the meet
+        // can only remove facts.
+        if (intersect && words) {
+            const uint64_t lastMask = problem.domainSize % 64 ? (uint64_t(1) << (problem.domainSize % 64)) - 1
+                                                              : ~uint64_t(0);
+            for (size_t n = 0; n < nodes; ++n) {
+                uint64_t* row = out.row(n);
+                std::fill(row, row + words, ~uint64_t(0));
+                row[words - 1] = lastMask;
+            }
+        }
+
+        const std::vector<CSRGraph::Index> order = evaluationOrder(graph, start);
+        std::vector<uint32_t> position(nodes);
+        for (uint32_t i = 0; i < order.size(); ++i) position[order[i]] = i;
+
+        RPOWorklist worklist(order.size());
+        while (!worklist.empty()) {
+            const CSRGraph::Index n = order[worklist.pop()];
+            ++result.evaluations;
+
+            uint64_t* inRow = in.row(n);
+            const auto preds = graph.predecessors(n);
+            if (n == start || preds.empty()) {
+                std::copy(boundary.row(0), boundary.row(0) + words, inRow);
+            } else {
+                std::copy(out.row(preds[0]), out.row(preds[0]) + words, inRow);
+                for (size_t p = 1; p < preds.size(); ++p) {
+                    const uint64_t* predRow = out.row(preds[p]);
+                    if (intersect) {
+                        for (size_t w = 0; w < words; ++w) inRow[w] &= predRow[w];
+                    } else {
+                        for (size_t w = 0; w < words; ++w) inRow[w] |= predRow[w];
+                    }
+                }
+            }
+
+            const uint64_t* genRow = gen.row(n);
+            const uint64_t* killRow = kill.row(n);
+            uint64_t* outRow = out.row(n);
+            uint64_t changed = 0;
+            for (size_t w = 0; w < words; ++w) {
+                const uint64_t value = genRow[w] | (inRow[w] & ~killRow[w]);
+                changed |= value ^ outRow[w];
+                outRow[w] = value;
+            }
+
+            if (changed) {
+                for (CSRGraph::Index succ : graph.successors(n)) {
+                    worklist.push(position[succ]);
+                }
+            }
+        }
+        return result;
+    }
+
+    template <typename GraphT>
+    static DataflowResult solveSparse(const GraphT& graph, const GenKillProblem& problem) {
+        using Set = llvm::SparseBitVector<>;
+        const size_t nodes = graph.nodeCount();
+        const CSRGraph::Index start = graph.entry();
+        const bool intersect = problem.meet == DataflowMeet::Intersection;
+
+        std::vector<Set> gen(nodes);
+        std::vector<Set> kill(nodes);
+        Set boundary;
+        for (const auto& [n, bit] : problem.gen) gen[n].set(bit);
+        for (const auto& [n, bit] : problem.kill) kill[n].set(bit);
+        for (uint32_t bit : problem.boundary) boundary.set(bit);
+        if (!problem.killClasses.empty()) {
+            std::vector<Set> classes(classCount(problem));
+            for (uint32_t fact = 0; fact < problem.factClass.size(); ++fact) {
+                classes[problem.factClass[fact]].set(fact);
+            }
+            for (const auto& [n, c] : problem.killClasses) {
+                if (c < classes.size()) kill[n] |= classes[c];
+            }
+        }
+
+        DataflowResult result;
+        result.in.m_isSparse = true;
+        result.out.m_isSparse = true;
+        result.in.m_sparse.resize(nodes);
+        result.out.m_sparse.resize(nodes);
+        std::vector<Set>& in = result.in.m_sparse;
+        std::vector<Set>& out = result.out.m_sparse;
+
+        if (intersect) {
+            Set full;
+            for (uint32_t bit = 0; bit < problem.domainSize; ++bit) full.set(bit);
+            std::fill(out.begin(), out.end(), full);
+        }
+
+        const std::vector<CSRGraph::Index> order = evaluationOrder(graph, start);
+        std::vector<uint32_t> position(nodes);
+        for (uint32_t i = 0; i < order.size(); ++i) position[order[i]] = i;
+
+        RPOWorklist worklist(order.size());
+        Set value;
+        while (!worklist.empty()) {
+            const CSRGraph::Index n = order[worklist.pop()];
+            ++result.evaluations;
+
+            const auto preds = graph.predecessors(n);
+            if (n == start || preds.empty()) {
+                in[n] = boundary;
+            } else {
+                in[n] = out[preds[0]];
+                for (size_t p = 1; p < preds.size(); ++p) {
+                    if (intersect) {
+                        in[n] &= out[preds[p]];
+                    } else {
+                        in[n] |= out[preds[p]];
+                    }
+                }
+            }
+
+            value.intersectWithComplement(in[n], kill[n]);
+            value |= gen[n];
+            if (value != out[n]) {
+                out[n] = value;
+                for (CSRGraph::Index succ : graph.successors(n)) {
+                    worklist.push(position[succ]);
+                }
+            }
+        }
+        return result;
+    }
+
+    template <typename GraphT>
+    static DataflowResult solve(const GraphT& graph, const GenKillProblem& problem) {
+        const size_t matrixBits = graph.nodeCount() * ((size_t(problem.domainSize) + 63) / 64 * 64);
+        return matrixBits <= DenseDataflowBitLimit ? solveDense(graph, problem) : solveSparse(graph, problem);
+    }
+};
+
+DataflowResult solveDataflow(const CSRGraph& graph, const GenKillProblem& problem) {
+    if (graph.empty()) return DataflowResult{};
+
+    if (problem.direction == DataflowDirection::Forward) {
+        return DataflowEngine::solve(graph, problem);
+    }
+
+    // On the reversed view "in" collects the facts flowing back from the
+    // successors, which is the program-order out set.
+    DataflowResult result = DataflowEngine::solve(ReversedGraph(graph), problem);
+    std::swap(result.in, result.out);
+    return result;
+}
+
+} // namespace GraphGenerator
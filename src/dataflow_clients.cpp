@@ -0,0 +1,171 @@
+#include "dataflow_clients.h"
+#include <clang/AST/Decl.h>
+#include <clang/AST/Expr.h>
+#include <clang/AST/Stmt.h>
+
+namespace GraphGenerator {
+
+void VarAccessWalker::walk(CSRGraph::Index block, const clang::Stmt* element) {
+    m_block = block;
+    m_element = element;
+    visit(element, AccessKind::Read);
+}
+
+void VarAccessWalker::visitChild(const clang::Stmt* S, AccessKind context) {
+    if (S && !m_elements.count(S)) visit(S, context);
+}
+
+void VarAccessWalker::visit(const clang::Stmt* S, AccessKind context) {
+    if (const auto* ref = llvm::dyn_cast<clang::DeclRefExpr>(S)) {
+        const auto* var = llvm::dyn_cast<clang::VarDecl>(ref->getDecl());
+        if (var && var->hasLocalStorage()) m_fn(m_block, var, context, m_element);
+        return;
+    }
+    if (const auto* paren = llvm::dyn_cast<clang::ParenExpr>(S)) {
+        visitChild(paren->getSubExpr(), context);
+        return;
+    }
+    if (const auto* binary = llvm::dyn_cast<clang::BinaryOperator>(S)) {
+        if (binary->isAssignmentOp()) {
+            // The right operand is sequenced before the store.
+            visitChild(binary->getRHS(), AccessKind::Read);
+            visitChild(binary->getLHS(), binary->isCompoundAssignmentOp() ? AccessKind::ReadWrite
+                                                                          : AccessKind::Write);
+            return;
+        }
+    } else if (const auto* unary = llvm::dyn_cast<clang::UnaryOperator>(S)) {
+        if (unary->isIncrementDecrementOp() || unary->getOpcode() == clang::UO_AddrOf) {
+            visitChild(unary->getSubExpr(), AccessKind::ReadWrite);
+            return;
+        }
+    } else if (const auto* decl = llvm::dyn_cast<clang::DeclStmt>(S)) {
+        for (const clang::Decl* D : decl->decls()) {
+            const auto* var = llvm::dyn_cast<clang::VarDecl>(D);
+            if (!var) continue;
+            visitChild(var->getInit(), AccessKind::Read);
+            if (var->hasLocalStorage()) m_fn(m_block, var, AccessKind::Write, m_element);
+        }
+        return;
+    }
+
+    for (const clang::Stmt* child : S->children()) {
+        visitChild(child, AccessKind::Read);
+    }
+}
+
+namespace {
+
+// Dense numbering of the variables seen by a walk, in order of first access.
+struct VariableNumbering {
+    std::vector<const clang::VarDecl*> variables;
+    llvm::DenseMap<const clang::VarDecl*, uint32_t> index;
+
+    uint32_t number(const clang::VarDecl* var) {
+        auto [it, inserted] = index.try_emplace(var, static_cast<uint32_t>(variables.size()));
+        if (inserted) variables.push_back(var);
+        return it->second;
+    }
+};
+
+} // namespace
+
+void forEachVarAccess(const CSRGraph& graph, VarAccessCallback fn) {
+    llvm::DenseSet<const clang::Stmt*> elements;
+    for (CSRGraph::Index n = 0; n < graph.nodeCount(); ++n) {
+        for (const clang::Stmt* stmt : graph.statementHandles(n)) {
+            elements.insert(stmt);
+        }
+    }
+
+    VarAccessWalker walker(elements, fn);
+    for (CSRGraph::Index n = 0; n < graph.nodeCount(); ++n) {
+        for (const clang::Stmt* stmt : graph.statementHandles(n)) {
+            walker.walk(n, stmt);
+        }
+    }
+}
+
+bool LivenessResult::isLiveIn(CSRGraph::Index n, const clang::VarDecl* var) const {
+    auto it = variableIndex.find(var);
+    return it != variableIndex.end() && sets.in.test(n, it->second);
+}
+
+bool LivenessResult::isLiveOut(CSRGraph::Index n, const clang::VarDecl* var) const {
+    auto it = variableIndex.find(var);
+    return it != variableIndex.end() && sets.out.test(n, it->second);
+}
+
+LivenessResult computeLiveness(const CSRGraph& graph) {
+    VariableNumbering numbering;
+    GenKillProblem problem;
+    problem.direction = DataflowDirection::Backward;
+
+    // Per variable, the block (plus one) that last read or wrote it, so a
+    // block generates a variable only when it is read before any write.
+    std::vector<CSRGraph::Index> readIn;
+    std::vector<CSRGraph::Index> writtenIn;
+    forEachVarAccess(graph, [&](CSRGraph::Index block, const clang::VarDecl* var, AccessKind kind,
+                                const clang::Stmt*) {
+        const uint32_t v = numbering.number(var);
+        if (v == readIn.size()) {
+            readIn.push_back(0);
+            writtenIn.push_back(0);
+        }
+        if (kind != AccessKind::Write && writtenIn[v] != block + 1 && readIn[v] != block + 1) {
+            problem.gen.push_back({block, v});
+            readIn[v] = block + 1;
+        }
+        if (kind != AccessKind::Read && writtenIn[v] != block + 1) {
+            problem.kill.push_back({block, v});
+            writtenIn[v] = block + 1;
+        }
+    });
+    problem.domainSize = static_cast<uint32_t>(numbering.variables.size());
+
+    LivenessResult result;
+    result.sets = solveDataflow(graph, problem);
+    result.variables = std::move(numbering.variables);
+    result.variableIndex = std::move(numbering.index);
+    return result;
+}
+
+ReachingDefinitionsResult computeReachingDefinitions(const CSRGraph& graph) {
+    ReachingDefinitionsResult result;
+    VariableNumbering numbering;
+    std::vector<uint32_t> definitionVar;
+    forEachVarAccess(graph, [&](CSRGraph::Index block, const clang::VarDecl* var, AccessKind kind,
+                                const clang::Stmt* element) {
+        if (kind == AccessKind::Read) return;
+        result.definitions.push_back({var, element, block});
+        definitionVar.push_back(numbering.number(var));
+    });
+
+    const uint32_t defCount = static_cast<uint32_t>(result.definitions.size());
+
+    // A block that defines a variable kills all of its definitions: one
+    // class per variable, and one kill pair per block and variable.
+    GenKillProblem problem;
+    problem.domainSize = defCount;
+    std::vector<CSRGraph::Index> seenIn(numbering.variables.size(), 0);
+    for (uint32_t end = defCount; end > 0;) {
+        // Definitions arrive grouped by block; scanning each group backwards
+        // meets the last definition of every variable first.
+        const CSRGraph::Index block = result.definitions[end - 1].block;
+        uint32_t begin = end;
+        while (begin > 0 && result.definitions[begin - 1].block == block) --begin;
+        for (uint32_t d = end; d-- > begin;) {
+            const uint32_t v = definitionVar[d];
+            if (seenIn[v] == block + 1) continue;
+            seenIn[v] = block + 1;
+            problem.gen.push_back({block, d});
+            problem.killClasses.push_back({block, v});
+        }
+        end = begin;
+    }
+    problem.factClass = std::move(definitionVar);
+
+    result.sets = solveDataflow(graph, problem);
+    return result;
+}
+
+} // namespace GraphGenerator
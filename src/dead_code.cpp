@@ -0,0 +1,87 @@
+#include "dead_code.h"
+#include <algorithm>
+
+namespace GraphGenerator {
+
+std::vector<CSRGraph::Index> unreachableBlocks(const CSRGraph& graph) {
+    using Index = CSRGraph::Index;
+    std::vector<Index> unreachable;
+    if (graph.entry() == CSRGraph::InvalidIndex) return unreachable;
+
+    std::vector<bool> seen(graph.nodeCount(), false);
+    std::vector<Index> stack{graph.entry()};
+    seen[graph.entry()] = true;
+    while (!stack.empty()) {
+        const Index n = stack.back();
+        stack.pop_back();
+        for (Index succ : graph.successors(n)) {
+            if (!seen[succ]) {
+                seen[succ] = true;
+                stack.push_back(succ);
+            }
+        }
+    }
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        if (!seen[n]) unreachable.push_back(n);
+    }
+    return unreachable;
+}
+
+bool matchesRootPattern(std::string_view name, std::string_view pattern) {
+    // Greedy wildcard match: on a mismatch, let the last '*' absorb one
+    // more character and retry from there.
+    size_t n = 0, p = 0;
+    size_t starPattern = std::string_view::npos, starName = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            starPattern = p++;
+            starName = n;
+        } else if (p < pattern.size() && pattern[p] == name[n]) {
+            ++p;
+            ++n;
+        } else if (starPattern != std::string_view::npos) {
+            p = starPattern + 1;
+            n = ++starName;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+std::vector<std::string> findDeadFunctions(
+    const std::unordered_map<std::string, std::set<std::string>>& calls,
+    const CallGraphRoots& roots,
+    const std::unordered_set<std::string>& exported,
+    const std::unordered_set<std::string>& indirect) {
+    auto isRoot = [&](const std::string& name) {
+        if (indirect.count(name) || (roots.exported && exported.count(name))) return true;
+        return std::any_of(roots.patterns.begin(), roots.patterns.end(),
+                           [&](const std::string& pattern) { return matchesRootPattern(name, pattern); });
+    };
+
+    std::unordered_set<std::string_view> live;
+    live.reserve(calls.size());
+    std::vector<std::string_view> stack;
+    for (const auto& [name, callees] : calls) {
+        if (isRoot(name) && live.insert(name).second) stack.push_back(name);
+    }
+    while (!stack.empty()) {
+        auto caller = calls.find(std::string(stack.back()));
+        stack.pop_back();
+        if (caller == calls.end()) continue;  // declared only
+        for (const std::string& callee : caller->second) {
+            if (live.insert(callee).second) stack.push_back(callee);
+        }
+    }
+
+    std::vector<std::string> dead;
+    for (const auto& [name, callees] : calls) {
+        if (!live.count(name)) dead.push_back(name);
+    }
+    std::sort(dead.begin(), dead.end());
+    return dead;
+}
+
+} // namespace GraphGenerator
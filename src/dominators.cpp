@@ -0,0 +1,198 @@
+#include "dominators.h"
+#include "parallel_for.h"
+
+namespace GraphGenerator {
+
+// Semi-NCA (Georgiadis, Tarjan): semidominators as in Lengauer-Tarjan with
+// simple path compression, then each idom is found as the nearest common
+// ancestor of the DFS parent and the semidominator. All working arrays are
+// indexed by DFS preorder number; number 0 is the root.
+template <typename GraphT>
+DominatorTree DominatorTree::compute(const GraphT& graph) {
+    using Number = uint32_t;
+    constexpr Number None = ~Number(0);
+
+    DominatorTree tree;
+    const size_t nodeCount = graph.nodeCount();
+    tree.m_idom.assign(nodeCount, CSRGraph::InvalidIndex);
+    tree.m_root = graph.entry();
+    if (nodeCount == 0 || tree.m_root == CSRGraph::InvalidIndex) {
+        tree.buildTreeIndex();
+        return tree;
+    }
+
+    // Preorder DFS from the root.
+    std::vector<Number> number(nodeCount, None);
+    std::vector<Index> vertex;
+    std::vector<Number> parent;
+    vertex.reserve(nodeCount);
+    parent.reserve(nodeCount);
+    {
+        std::vector<std::pair<Index, uint32_t>> stack;
+        number[tree.m_root] = 0;
+        vertex.push_back(tree.m_root);
+        parent.push_back(None);
+        stack.push_back({tree.m_root, 0});
+        while (!stack.empty()) {
+            auto& [node, next] = stack.back();
+            auto succs = graph.successors(node);
+            if (next == succs.size()) {
+                stack.pop_back();
+                continue;
+            }
+            Index succ = succs[next++];
+            if (number[succ] == None) {
+                number[succ] = static_cast<Number>(vertex.size());
+                parent.push_back(number[node]);
+                vertex.push_back(succ);
+                stack.push_back({succ, 0});
+            }
+        }
+    }
+
+    const Number count = static_cast<Number>(vertex.size());
+    std::vector<Number> semi(count);
+    std::vector<Number> label(count);
+    std::vector<Number> ancestor(count, None);
+    for (Number i = 0; i < count; ++i) {
+        semi[i] = label[i] = i;
+    }
+
+    std::vector<Number> path;
+    auto eval = [&](Number v) {
+        if (ancestor[v] == None) return v;
+        // Compress the forest path above v, top-down, without recursion.
+        path.clear();
+        for (Number x = v; ancestor[ancestor[x]] != None; x = ancestor[x]) {
+            path.push_back(x);
+        }
+        while (!path.empty()) {
+            Number x = path.back();
+            path.pop_back();
+            Number a = ancestor[x];
+            if (semi[label[a]] < semi[label[x]]) {
+                label[x] = label[a];
+            }
+            ancestor[x] = ancestor[a];
+        }
+        return label[v];
+    };
+
+    for (Number w = count - 1; w > 0; --w) {
+        for (Index pred : graph.predecessors(vertex[w])) {
+            Number u = number[pred];
+            if (u == None) continue;  // unreachable predecessor
+            Number candidate = semi[eval(u)];
+            if (candidate < semi[w]) {
+                semi[w] = candidate;
+            }
+        }
+        ancestor[w] = parent[w];
+    }
+
+    // Preorder guarantees idom[parent] is final before its children.
+    std::vector<Number> idom(count);
+    idom[0] = 0;
+    for (Number w = 1; w < count; ++w) {
+        Number d = parent[w];
+        while (d > semi[w]) {
+            d = idom[d];
+        }
+        idom[w] = d;
+    }
+    for (Number w = 1; w < count; ++w) {
+        tree.m_idom[vertex[w]] = vertex[idom[w]];
+    }
+
+    tree.buildTreeIndex();
+    return tree;
+}
+
+void DominatorTree::buildTreeIndex() {
+    const size_t nodeCount = m_idom.size();
+    m_childOffsets.assign(nodeCount + 1, 0);
+    for (Index parent : m_idom) {
+        if (parent != CSRGraph::InvalidIndex) {
+            ++m_childOffsets[parent + 1];
+        }
+    }
+    for (size_t n = 0; n < nodeCount; ++n) {
+        m_childOffsets[n + 1] += m_childOffsets[n];
+    }
+    m_children.resize(m_childOffsets[nodeCount]);
+    {
+        std::vector<uint32_t> cursor(m_childOffsets.begin(), m_childOffsets.end() - 1);
+        for (size_t n = 0; n < nodeCount; ++n) {
+            if (m_idom[n] != CSRGraph::InvalidIndex) {
+                m_children[cursor[m_idom[n]]++] = static_cast<Index>(n);
+            }
+        }
+    }
+
+    // Entry/exit times of a DFS over the tree: a dominates b exactly when
+    // b's interval nests inside a's.
+    m_tin.assign(nodeCount, 0);
+    m_tout.assign(nodeCount, 0);
+    m_depth.assign(nodeCount, 0);
+    if (m_root == CSRGraph::InvalidIndex) return;
+
+    uint32_t clock = 0;
+    std::vector<std::pair<Index, uint32_t>> stack;
+    m_tin[m_root] = clock++;
+    stack.push_back({m_root, 0});
+    while (!stack.empty()) {
+        auto& [node, next] = stack.back();
+        llvm::ArrayRef<Index> kids = children(node);
+        if (next < kids.size()) {
+            Index child = kids[next++];
+            m_tin[child] = clock++;
+            m_depth[child] = m_depth[node] + 1;
+            stack.push_back({child, 0});
+        } else {
+            m_tout[node] = clock++;
+            stack.pop_back();
+        }
+    }
+}
+
+DominatorTree DominatorTree::build(const CSRGraph& graph) {
+    return compute(graph);
+}
+
+DominatorTree DominatorTree::build(const ReversedGraph& graph) {
+    return compute(graph);
+}
+
+DominatorTree::Index DominatorTree::nearestCommonDominator(Index a, Index b) const {
+    if (!isReachable(a) || !isReachable(b)) return CSRGraph::InvalidIndex;
+    while (m_depth[a] > m_depth[b]) a = m_idom[a];
+    while (m_depth[b] > m_depth[a]) b = m_idom[b];
+    while (a != b) {
+        a = m_idom[a];
+        b = m_idom[b];
+    }
+    return a;
+}
+
+std::vector<FunctionDominators> computeDominatorsBatch(
+    llvm::ArrayRef<std::shared_ptr<const CSRGraph>> graphs, unsigned threads) {
+    std::vector<FunctionDominators> results(graphs.size());
+    parallelFor(graphs.size(), [&](size_t i) {
+        if (!graphs[i]) return;
+        results[i].dominators = DominatorTree::build(*graphs[i]);
+        results[i].postDominators = DominatorTree::build(ReversedGraph(*graphs[i]));
+    }, threads);
+    return results;
+}
+
+std::vector<std::pair<int, int>> idomBlockPairs(const CSRGraph& graph, const DominatorTree& tree) {
+    std::vector<std::pair<int, int>> pairs;
+    for (CSRGraph::Index n = 0; n < tree.nodeCount(); ++n) {
+        if (tree.idom(n) != CSRGraph::InvalidIndex) {
+            pairs.push_back({graph.blockId(n), graph.blockId(tree.idom(n))});
+        }
+    }
+    return pairs;
+}
+
+} // namespace GraphGenerator
@@ -1,5 +1,6 @@
 #include "graph_generator.h"
 #include "parser.h"
+#include "dataflow_clients.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -8,65 +9,113 @@
 #include <clang/AST/Stmt.h>
 #include <nlohmann/json.hpp>
 #include <clang/AST/ASTContext.h>
+#include <clang/AST/ODRHash.h>
+#include <clang/AST/StmtCXX.h>
+#include <llvm/ADT/FoldingSet.h>
+#include <llvm/ADT/DenseSet.h>
 
 using json = nlohmann::json;
 
 namespace GraphGenerator {
 
-    std::string getStmtString(const clang::Stmt* S) {
+    static std::string printStmt(const clang::Stmt* S, const clang::PrintingPolicy& policy) {
         if (!S) return "NULL";
         std::string stmtStr;
         llvm::raw_string_ostream stream(stmtStr);
-        S->printPretty(stream, nullptr, clang::PrintingPolicy(clang::LangOptions()));
+        S->printPretty(stream, nullptr, policy);
         stream.flush();
         return stmtStr;
     }
 
-    void extractStatementsFromBlock(const clang::CFGBlock* block, CFGGraph* graph) {
-        for (const auto& element : *block) {
-            if (element.getKind() == clang::CFGElement::Statement) {
-                const clang::Stmt* stmt = element.castAs<clang::CFGStmt>().getStmt();
-                std::string stmtStr = getStmtString(stmt);
-                graph->addStatement(block->getBlockID(), stmtStr);
-            }
-        }
+    std::string getStmtString(const clang::Stmt* S) {
+        return printStmt(S, clang::PrintingPolicy(clang::LangOptions()));
     }
 
-    void handleTryAndCatch(const clang::CFGBlock* block, CFGGraph* graph, std::map<const clang::Stmt*, clang::CFGBlock*>& stmtToBlock) {
-        for (const auto& element : *block) {
-            if (element.getKind() != clang::CFGElement::Statement) continue;
+    uint64_t computeBodyFingerprint(const clang::FunctionDecl* FD) {
+        if (!FD || !FD->hasBody()) return 0;
 
-            const clang::Stmt* stmt = element.castAs<clang::CFGStmt>().getStmt();
-            int blockID = block->getBlockID();
+        // ODRHash is what clang uses to compare definitions across modules:
+        // it walks types and statements structurally and never looks at
+        // source locations or pointer values.
+        clang::ODRHash hasher;
+        hasher.AddQualType(FD->getType());
 
-            if (llvm::isa<clang::CXXTryStmt>(stmt)) {
-                graph->markNodeAsTryBlock(blockID);
+        llvm::FoldingSetNodeID bodyID;
+        FD->getBody()->ProcessODRHash(bodyID, hasher);
 
-                const auto* tryStmt = llvm::dyn_cast<clang::CXXTryStmt>(stmt);
-                for (unsigned i = 0; i < tryStmt->getNumHandlers(); ++i) {
-                    const clang::CXXCatchStmt* catchStmt = tryStmt->getHandler(i);
-                    if (stmtToBlock.count(catchStmt)) {
-                        graph->addExceptionEdge(blockID, stmtToBlock[catchStmt]->getBlockID());
-                    }
-                }
-            }
-            if (llvm::isa<clang::CXXThrowExpr>(stmt)) {
-                graph->markNodeAsThrowingException(blockID);
-            }
-        }
+        return (static_cast<uint64_t>(bodyID.ComputeHash()) << 32) | hasher.CalculateHash();
     }
 
-    void handleSuccessors(const clang::CFGBlock* block, CFGGraph* graph) {
-        int blockID = block->getBlockID();
+    FlatCFG flattenCFG(const clang::CFG& cfg) {
+        FlatCFG flat;
+        const unsigned numBlocks = cfg.getNumBlockIDs();
+        flat.numBlocks = numBlocks;
+        flat.entryID = cfg.getEntry().getBlockID();
+        flat.exitID = cfg.getExit().getBlockID();
 
-        for (auto succ = block->succ_begin(); succ != block->succ_end(); ++succ) {
-            if (*succ) {
-                graph->addEdge(blockID, (*succ)->getBlockID());
+        // clang::CFG iterates blocks in creation order, not ID order, so
+        // index them first. Element and successor counts are O(1) per block,
+        // which gives exact upper bounds for the contiguous arrays.
+        std::vector<const clang::CFGBlock*> blocksByID(numBlocks, nullptr);
+        size_t maxStmts = 0;
+        size_t maxSuccs = 0;
+        for (const clang::CFGBlock* block : cfg) {
+            if (!block) continue;
+            blocksByID[block->getBlockID()] = block;
+            maxStmts += block->size();
+            maxSuccs += block->succ_size();
+        }
+
+        flat.succOffsets.reserve(numBlocks + 1);
+        flat.stmtOffsets.reserve(numBlocks + 1);
+        flat.terminators.reserve(numBlocks);
+        flat.succTargets.reserve(maxSuccs);
+        flat.succFlags.reserve(maxSuccs);
+        flat.stmts.reserve(maxStmts);
+
+        for (const clang::CFGBlock* block : blocksByID) {
+            flat.succOffsets.push_back(static_cast<uint32_t>(flat.succTargets.size()));
+            flat.stmtOffsets.push_back(static_cast<uint32_t>(flat.stmts.size()));
+            flat.terminators.push_back(block ? block->getTerminatorStmt() : nullptr);
+            if (!block) continue;
+
+            for (const auto& element : *block) {
+                if (element.getKind() == clang::CFGElement::Statement) {
+                    flat.stmts.push_back(element.castAs<clang::CFGStmt>().getStmt());
+                }
+            }
+            // A two-way conditional terminator lists the true successor
+            // first and the false one second. Switches can also have two
+            // successors but are not branches in that sense. The handlers
+            // reached from a try dispatch block are exception edges.
+            const clang::Stmt* terminator = block->getTerminatorStmt();
+            const bool isTwoWay = block->getTerminatorCondition() && block->succ_size() == 2 &&
+                                  !llvm::isa_and_nonnull<clang::SwitchStmt>(terminator);
+            const bool isTryDispatch = llvm::isa_and_nonnull<clang::CXXTryStmt>(terminator);
+            unsigned position = 0;
+            for (const auto& succ : block->succs()) {
+                // Unreachable successors are recorded by clang as null entries.
+                if (const clang::CFGBlock* target = succ.getReachableBlock()) {
+                    uint8_t flags = EdgeNone;
+                    if (isTwoWay) flags |= position == 0 ? EdgeTrueBranch : EdgeFalseBranch;
+                    if (isTryDispatch) flags |= EdgeException;
+                    flat.succTargets.push_back(target->getBlockID());
+                    flat.succFlags.push_back(flags);
+                }
+                ++position;
             }
         }
+        flat.succOffsets.push_back(static_cast<uint32_t>(flat.succTargets.size()));
+        flat.stmtOffsets.push_back(static_cast<uint32_t>(flat.stmts.size()));
+
+        return flat;
     }
 
     std::unique_ptr<CFGGraph> generateCFG(const clang::FunctionDecl* FD) {
+        return generateCFG(FD, nullptr);
+    }
+
+    std::unique_ptr<CFGGraph> generateCFG(const clang::FunctionDecl* FD, std::shared_ptr<AnalysisSession> session) {
         if (!FD || !FD->hasBody()) return nullptr;
         
         // Handle template functions
@@ -85,7 +134,6 @@ namespace GraphGenerator {
             }
         }
 
-        auto graph = std::make_unique<CFGGraph>();
         std::unique_ptr<clang::CFG> cfg = clang::CFG::buildCFG(
             actualFD, 
             actualFD->getBody(), 
@@ -98,30 +146,60 @@ namespace GraphGenerator {
             return nullptr;
         }
 
-        std::map<const clang::Stmt*, clang::CFGBlock*> stmtToBlock;
-        for (auto* block : *cfg) {
-            if (!block) continue;
-            
-            for (const auto& element : *block) {
-                if (element.getKind() == clang::CFGElement::Statement) {
-                    if (const auto* stmt = element.castAs<clang::CFGStmt>().getStmt()) {
-                        stmtToBlock[stmt] = block;
-                    }
+        const FlatCFG flat = flattenCFG(*cfg);
+        const clang::PrintingPolicy policy{clang::LangOptions()};
+
+        // FlatCFG gives exact sizes, so staging never reallocates and the
+        // frozen arrays are allocated once each from the session arena.
+        CSRGraphBuilder builder(std::move(session));
+        builder.reserve(flat.numBlocks, flat.succTargets.size(), flat.stmts.size());
+
+        // The def-use index is filled in the same pass. Subexpressions
+        // that clang also lists as elements are walked with those only.
+        llvm::DenseSet<const clang::Stmt*> elements;
+        elements.reserve(flat.stmts.size());
+        elements.insert(flat.stmts.begin(), flat.stmts.end());
+        uint32_t element = 0;
+        auto recordAccess = [&](CSRGraph::Index block, const clang::VarDecl* var, AccessKind kind, const clang::Stmt*) {
+            const llvm::StringRef name = var->getName();
+            builder.addVariableAccess(static_cast<int>(block), element, std::string_view(name.data(), name.size()), var, kind);
+        };
+        VarAccessWalker walker(elements, recordAccess);
+
+        std::string text;  // reused for every statement to keep its capacity
+        for (uint32_t id = 0; id < flat.numBlocks; ++id) {
+            builder.addNode(id);
+
+            element = 0;
+            for (const clang::Stmt* stmt : flat.blockStmts(id)) {
+                text.clear();
+                llvm::raw_string_ostream stream(text);
+                stmt->printPretty(stream, nullptr, policy);
+                stream.flush();
+                builder.addStatement(id, text, stmt);
+                walker.walk(id, stmt);
+                ++element;
+                if (llvm::isa<clang::CXXThrowExpr>(stmt)) {
+                    builder.addAttributes(id, NodeThrowsException);
                 }
             }
-        }
 
-
-        for (const auto* block : *cfg) {
-            if (!block) continue;
-            
-            graph->addNode(block->getBlockID());
-            extractStatementsFromBlock(block, graph.get());
-            handleTryAndCatch(block, graph.get(), stmtToBlock);
-            handleSuccessors(block, graph.get());
+            // clang ends the block that dispatches into the handlers with the
+            // CXXTryStmt as terminator; its successors are the catch blocks.
+            if (const clang::Stmt* terminator = flat.terminators[id]) {
+                builder.setTerminator(id, terminator);
+                if (llvm::isa<clang::CXXTryStmt>(terminator)) {
+                    builder.addAttributes(id, NodeTryBlock);
+                }
+            }
+            for (uint32_t e = flat.succOffsets[id]; e < flat.succOffsets[id + 1]; ++e) {
+                builder.addEdge(id, flat.succTargets[e], flat.succFlags[e]);
+            }
         }
+        builder.setEntry(flat.entryID);
+        builder.setExit(flat.exitID);
 
-        return graph;
+        return std::make_unique<CFGGraph>(std::make_shared<const CSRGraph>(builder.freeze()));
     }
 
     std::unique_ptr<CFGGraph> generateCustomCFG(const clang::FunctionDecl* FD) {
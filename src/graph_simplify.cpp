@@ -0,0 +1,254 @@
+#include "graph_simplify.h"
+#include <algorithm>
+#include <numeric>
+#include <string>
+
+namespace GraphGenerator {
+
+namespace {
+
+using Index = CSRGraph::Index;
+
+// Adjacency between groups of nodes, deduplicated, with the flags of
+// merged edges OR-ed together.
+struct GroupEdges {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<uint8_t> flags;
+    std::vector<uint32_t> predCount;
+
+    llvm::ArrayRef<uint32_t> successors(uint32_t g) const {
+        return llvm::ArrayRef<uint32_t>(targets).slice(offsets[g], offsets[g + 1] - offsets[g]);
+    }
+};
+
+// Edges leaving each group, given the group of every node (InvalidIndex
+// for nodes that are not kept) and the node whose edges a group inherits.
+GroupEdges groupEdges(const CSRGraph& graph, const std::vector<Index>& target,
+                      const std::vector<uint32_t>& groupOf, const std::vector<Index>& tails) {
+    std::vector<std::pair<std::pair<uint32_t, uint32_t>, uint8_t>> edges;
+    for (uint32_t g = 0; g < tails.size(); ++g) {
+        const Index tail = tails[g];
+        for (uint32_t e = graph.edgeBegin(tail); e < graph.edgeEnd(tail); ++e) {
+            edges.push_back({{g, groupOf[target[graph.edgeTarget(e)]]}, graph.edgeFlags(e)});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    GroupEdges result;
+    result.offsets.assign(tails.size() + 1, 0);
+    result.predCount.assign(tails.size(), 0);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (i > 0 && edges[i].first == edges[i - 1].first) {
+            result.flags.back() |= edges[i].second;
+            continue;
+        }
+        result.targets.push_back(edges[i].first.second);
+        result.flags.push_back(edges[i].second);
+        ++result.offsets[edges[i].first.first + 1];
+        ++result.predCount[edges[i].first.second];
+    }
+    std::partial_sum(result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+    return result;
+}
+
+} // namespace
+
+SimplifiedGraph SimplifiedGraph::build(std::shared_ptr<const CSRGraph> original, const SimplifyOptions& options) {
+    SimplifiedGraph simplified;
+    simplified.m_original = std::move(original);
+    const CSRGraph& graph = *simplified.m_original;
+    const size_t nodeCount = graph.nodeCount();
+
+    // 1. Where each node's control actually goes: pass-through blocks
+    //    forward to the first block that is not one. A cycle made only of
+    //    pass-through blocks keeps the block where it was detected.
+    auto isPassThrough = [&](Index n) {
+        return options.collapseEmpty && n != graph.entry() && n != graph.exit() &&
+               graph.statements(n).empty() && !graph.terminator(n) && graph.attributes(n) == NodeNone &&
+               graph.outDegree(n) == 1 && graph.successors(n)[0] != n &&
+               !(graph.edgeFlags(graph.edgeBegin(n)) & EdgeException);
+    };
+    std::vector<Index> target(nodeCount);
+    std::vector<uint8_t> state(nodeCount, 0);  // 0 open, 1 on the current walk, 2 resolved
+    std::vector<Index> walk;
+    for (Index n = 0; n < nodeCount; ++n) {
+        Index current = n;
+        Index resolved;
+        walk.clear();
+        while (true) {
+            if (state[current] == 2) {
+                resolved = target[current];
+                break;
+            }
+            if (state[current] == 1 || !isPassThrough(current)) {
+                resolved = current;
+                break;
+            }
+            state[current] = 1;
+            walk.push_back(current);
+            current = graph.successors(current)[0];
+        }
+        for (Index w : walk) {
+            target[w] = resolved;
+            state[w] = 2;
+        }
+        target[resolved] = resolved;
+        state[resolved] = 2;
+    }
+
+    // 2. Chains over the kept nodes, each node as its own group first.
+    std::vector<uint32_t> groupOf(nodeCount, CSRGraph::InvalidIndex);
+    std::vector<Index> kept;
+    for (Index n = 0; n < nodeCount; ++n) {
+        if (target[n] == n) {
+            groupOf[n] = static_cast<uint32_t>(kept.size());
+            kept.push_back(n);
+        }
+    }
+    const GroupEdges nodeEdges = groupEdges(graph, target, groupOf, kept);
+
+    std::vector<Index> next(nodeCount, CSRGraph::InvalidIndex);
+    std::vector<bool> hasPrevious(nodeCount, false);
+    if (options.mergeChains) {
+        for (uint32_t g = 0; g < kept.size(); ++g) {
+            const llvm::ArrayRef<uint32_t> succs = nodeEdges.successors(g);
+            if (succs.size() != 1 || succs[0] == g || (nodeEdges.flags[nodeEdges.offsets[g]] & EdgeException)) continue;
+            const Index u = kept[g];
+            const Index v = kept[succs[0]];
+            // Entry and exit stay nodes of their own.
+            if (u == graph.entry() || v == graph.exit() || v == graph.entry() || u == graph.exit() ||
+                nodeEdges.predCount[succs[0]] != 1) {
+                continue;
+            }
+            next[u] = v;
+            hasPrevious[v] = true;
+        }
+    }
+
+    std::vector<std::vector<Index>> chains;  // kept nodes per group, in order
+    std::vector<bool> placed(nodeCount, false);
+    auto addChain = [&](Index head) {
+        std::vector<Index> chain;
+        for (Index n = head; n != CSRGraph::InvalidIndex && !placed[n]; n = next[n]) {
+            placed[n] = true;
+            chain.push_back(n);
+        }
+        chains.push_back(std::move(chain));
+    };
+    for (Index n : kept) {
+        if (!hasPrevious[n]) addChain(n);
+    }
+    for (Index n : kept) {
+        if (!placed[n]) addChain(n);  // chains closed into a cycle
+    }
+
+    auto assignGroups = [&]() {
+        std::vector<Index> tails;
+        for (uint32_t g = 0; g < chains.size(); ++g) {
+            for (Index n : chains[g]) groupOf[n] = g;
+            tails.push_back(chains[g].back());
+        }
+        return tails;
+    };
+    std::vector<Index> tails = assignGroups();
+    GroupEdges edges = groupEdges(graph, target, groupOf, tails);
+
+    // 3. Switch cases that are entered only from the switch and leave
+    //    only to a common block become one group.
+    if (options.foldSwitches) {
+        std::vector<uint32_t> foldInto(chains.size(), CSRGraph::InvalidIndex);
+        for (uint32_t s = 0; s < chains.size(); ++s) {
+            const llvm::ArrayRef<uint32_t> succs = edges.successors(s);
+            if (succs.size() < 3) continue;
+            std::vector<std::pair<uint32_t, uint32_t>> cases;  // join, case
+            for (uint32_t c : succs) {
+                const llvm::ArrayRef<uint32_t> out = edges.successors(c);
+                if (c != s && edges.predCount[c] == 1 && out.size() == 1 && out[0] != c &&
+                    foldInto[c] == CSRGraph::InvalidIndex) {
+                    cases.push_back({out[0], c});
+                }
+            }
+            std::sort(cases.begin(), cases.end());
+            for (size_t i = 0; i < cases.size();) {
+                size_t j = i;
+                while (j < cases.size() && cases[j].first == cases[i].first) ++j;
+                for (size_t k = i + 1; k < j; ++k) foldInto[cases[k].second] = cases[i].second;
+                i = j;
+            }
+        }
+        std::vector<std::vector<Index>> folded;
+        std::vector<uint32_t> renumber(chains.size(), CSRGraph::InvalidIndex);
+        for (uint32_t g = 0; g < chains.size(); ++g) {
+            if (foldInto[g] != CSRGraph::InvalidIndex) continue;
+            renumber[g] = static_cast<uint32_t>(folded.size());
+            folded.push_back(std::move(chains[g]));
+        }
+        for (uint32_t g = 0; g < chains.size(); ++g) {
+            if (foldInto[g] == CSRGraph::InvalidIndex) continue;
+            std::vector<Index>& into = folded[renumber[foldInto[g]]];
+            into.insert(into.end(), chains[g].begin(), chains[g].end());
+        }
+        chains = std::move(folded);
+        tails = assignGroups();
+        edges = groupEdges(graph, target, groupOf, tails);
+    }
+
+    // 4. Pack the reduced graph. Collapsed blocks join the group of the
+    //    block they forwarded to, right in front of it.
+    std::vector<std::vector<Index>> collapsedInto(nodeCount);
+    for (Index n = 0; n < nodeCount; ++n) {
+        if (target[n] != n) collapsedInto[target[n]].push_back(n);
+    }
+
+    CSRGraphBuilder builder;
+    builder.reserve(chains.size(), edges.targets.size(), 0);
+    std::vector<int> groupIds(chains.size());
+    std::vector<std::vector<Index>> groupMembers(chains.size());
+    for (uint32_t g = 0; g < chains.size(); ++g) {
+        uint32_t attributes = NodeNone;
+        for (Index n : chains[g]) {
+            std::vector<Index>& members = groupMembers[g];
+            members.insert(members.end(), collapsedInto[n].begin(), collapsedInto[n].end());
+            members.push_back(n);
+            attributes |= graph.attributes(n);
+        }
+        groupIds[g] = graph.blockId(chains[g].front());
+        if (groupMembers[g].size() == 1) {
+            builder.addNode(groupIds[g], graph.label(chains[g].front()));
+        } else {
+            builder.addNode(groupIds[g], "Block " + std::to_string(groupIds[g]) + " (+" +
+                                         std::to_string(groupMembers[g].size() - 1) + " merged)");
+        }
+        builder.addAttributes(groupIds[g], attributes);
+    }
+    for (uint32_t g = 0; g < chains.size(); ++g) {
+        for (uint32_t e = edges.offsets[g]; e < edges.offsets[g + 1]; ++e) {
+            builder.addEdge(groupIds[g], groupIds[edges.targets[e]], edges.flags[e]);
+        }
+    }
+    if (graph.entry() != CSRGraph::InvalidIndex) builder.setEntry(groupIds[groupOf[target[graph.entry()]]]);
+    if (graph.exit() != CSRGraph::InvalidIndex) builder.setExit(groupIds[groupOf[target[graph.exit()]]]);
+    simplified.m_reduced = builder.freeze();
+
+    // freeze() orders nodes by block ID; lay out the members to match.
+    const CSRGraph& reduced = simplified.m_reduced;
+    std::vector<uint32_t> groupAt(reduced.nodeCount());
+    for (uint32_t g = 0; g < chains.size(); ++g) {
+        groupAt[reduced.indexOf(groupIds[g])] = g;
+    }
+    simplified.m_memberOffsets.reserve(reduced.nodeCount() + 1);
+    simplified.m_members.reserve(nodeCount);
+    simplified.m_reducedOf.assign(nodeCount, CSRGraph::InvalidIndex);
+    for (Index r = 0; r < reduced.nodeCount(); ++r) {
+        simplified.m_memberOffsets.push_back(static_cast<uint32_t>(simplified.m_members.size()));
+        for (Index n : groupMembers[groupAt[r]]) {
+            simplified.m_members.push_back(n);
+            simplified.m_reducedOf[n] = r;
+        }
+    }
+    simplified.m_memberOffsets.push_back(static_cast<uint32_t>(simplified.m_members.size()));
+    return simplified;
+}
+
+} // namespace GraphGenerator
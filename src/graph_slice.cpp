@@ -0,0 +1,150 @@
+#include "graph_slice.h"
+#include <algorithm>
+#include <deque>
+
+namespace GraphGenerator {
+
+namespace {
+
+using Index = CSRGraph::Index;
+
+enum Direction : uint8_t {
+    Forward  = 1 << 0,
+    Backward = 1 << 1,
+    Both     = Forward | Backward,
+};
+
+// Fills in the edges and boundary of a slice whose nodes are set.
+void finishSlice(const CSRGraph& graph, GraphSlice& slice) {
+    std::sort(slice.nodes.begin(), slice.nodes.end());
+    slice.edges.clear();
+    slice.boundary.clear();
+    for (Index n : slice.nodes) {
+        bool onBoundary = false;
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            if (slice.contains(graph.edgeTarget(e))) {
+                slice.edges.push_back(e);
+            } else {
+                onBoundary = true;
+            }
+        }
+        for (Index pred : graph.predecessors(n)) {
+            if (!slice.contains(pred)) onBoundary = true;
+        }
+        if (onBoundary) slice.boundary.push_back(n);
+    }
+}
+
+// Breadth-first growth from the focus through nodes for which inRegion
+// holds, up to maxNodes of them.
+template <typename RegionFn>
+GraphSlice growSlice(const CSRGraph& graph, Index focus, uint8_t directions, unsigned maxHops,
+                     size_t maxNodes, RegionFn inRegion) {
+    GraphSlice slice;
+    slice.focus = focus;
+    if (focus >= graph.nodeCount() || maxNodes == 0) return slice;
+
+    std::vector<unsigned> hops(graph.nodeCount(), ~0u);
+    std::deque<Index> queue{focus};
+    hops[focus] = 0;
+    slice.nodes.push_back(focus);
+    auto visit = [&](Index from, Index next) {
+        if (hops[next] != ~0u || !inRegion(next)) return;
+        if (slice.nodes.size() == maxNodes) {
+            slice.truncated = true;
+            return;
+        }
+        hops[next] = hops[from] + 1;
+        slice.nodes.push_back(next);
+        queue.push_back(next);
+    };
+    while (!queue.empty()) {
+        const Index n = queue.front();
+        queue.pop_front();
+        if (hops[n] == maxHops) continue;
+        if (directions & Forward) {
+            for (Index succ : graph.successors(n)) visit(n, succ);
+        }
+        if (directions & Backward) {
+            for (Index pred : graph.predecessors(n)) visit(n, pred);
+        }
+    }
+    finishSlice(graph, slice);
+    return slice;
+}
+
+std::vector<bool> reachableFrom(const CSRGraph& graph, Index start, bool forward) {
+    std::vector<bool> seen(graph.nodeCount(), false);
+    if (start >= graph.nodeCount()) return seen;
+    std::vector<Index> stack{start};
+    seen[start] = true;
+    while (!stack.empty()) {
+        const Index n = stack.back();
+        stack.pop_back();
+        for (Index next : forward ? graph.successors(n) : graph.predecessors(n)) {
+            if (!seen[next]) {
+                seen[next] = true;
+                stack.push_back(next);
+            }
+        }
+    }
+    return seen;
+}
+
+} // namespace
+
+bool GraphSlice::contains(Index n) const {
+    return std::binary_search(nodes.begin(), nodes.end(), n);
+}
+
+bool GraphSlice::isBoundary(Index n) const {
+    return std::binary_search(boundary.begin(), boundary.end(), n);
+}
+
+GraphSlice neighborhoodSlice(const CSRGraph& graph, Index focus, unsigned hops, size_t maxNodes) {
+    return growSlice(graph, focus, Both, hops, maxNodes, [](Index) { return true; });
+}
+
+GraphSlice loopSlice(const CSRGraph& graph, const LoopForest& loops, Index focus, size_t maxNodes) {
+    const uint32_t loop = focus < graph.nodeCount() ? loops.innermostLoop(focus) : LoopForest::NoLoop;
+    if (loop == LoopForest::NoLoop) {
+        return growSlice(graph, focus, Both, 0, maxNodes, [](Index) { return true; });
+    }
+    return growSlice(graph, focus, Both, ~0u, maxNodes,
+                     [&](Index n) { return loops.contains(loop, n); });
+}
+
+GraphSlice dominatorRegionSlice(const CSRGraph& graph, const DominatorTree& dominators, Index focus,
+                                size_t maxNodes) {
+    // Everything a node dominates is reachable from it through dominated
+    // nodes, so a forward search covers the region.
+    return growSlice(graph, focus, Forward, ~0u, maxNodes,
+                     [&](Index n) { return dominators.dominates(focus, n); });
+}
+
+GraphSlice exitPathSlice(const CSRGraph& graph, Index focus, size_t maxNodes) {
+    const std::vector<bool> reachesExit = reachableFrom(graph, graph.exit(), false);
+    return growSlice(graph, focus, Forward, ~0u, maxNodes, [&](Index n) { return reachesExit[n]; });
+}
+
+GraphSlice entryPathSlice(const CSRGraph& graph, Index focus, size_t maxNodes) {
+    const std::vector<bool> fromEntry = reachableFrom(graph, graph.entry(), true);
+    return growSlice(graph, focus, Backward, ~0u, maxNodes, [&](Index n) { return fromEntry[n]; });
+}
+
+GraphSlice expandSlice(const CSRGraph& graph, const GraphSlice& slice, Index node) {
+    GraphSlice expanded = slice;
+    if (node >= graph.nodeCount()) return expanded;
+    for (Index succ : graph.successors(node)) {
+        if (!slice.contains(succ)) expanded.nodes.push_back(succ);
+    }
+    for (Index pred : graph.predecessors(node)) {
+        if (!slice.contains(pred)) expanded.nodes.push_back(pred);
+    }
+    std::sort(expanded.nodes.begin(), expanded.nodes.end());
+    expanded.nodes.erase(std::unique(expanded.nodes.begin(), expanded.nodes.end()), expanded.nodes.end());
+    finishSlice(graph, expanded);
+    return expanded;
+}
+
+} // namespace GraphGenerator
@@ -1,10 +1,10 @@
 #include "graphical_cfg_node.h"
-#include "node.h" 
 #include <QGraphicsSceneMouseEvent>
 #include <QStyleOptionGraphicsItem>
 
-GraphicalCFGNode::GraphicalCFGNode(const std::shared_ptr<CFGNode>& cfgNode, QGraphicsItem* parent)
-    : QGraphicsItem(parent), m_cfgNode(cfgNode), m_color(Qt::blue) {
+GraphicalCFGNode::GraphicalCFGNode(std::shared_ptr<const CFGNodeGraph> graph, CFGNodeGraph::NodeId node,
+                                   QGraphicsItem* parent)
+    : QGraphicsItem(parent), m_graph(std::move(graph)), m_node(node), m_color(Qt::blue) {
     setFlag(QGraphicsItem::ItemIsMovable);
     setFlag(QGraphicsItem::ItemIsSelectable);
 }
@@ -20,17 +20,17 @@ void GraphicalCFGNode::paint(QPainter* painter, const QStyleOptionGraphicsItem*
     QRectF rect = boundingRect();
     
     // Set color based on node type
-    switch (m_cfgNode->getType()) {
-        case CFGNode::ENTRY:
+    switch (m_graph->getType(m_node)) {
+        case CFGNodeGraph::ENTRY:
             m_color = Qt::green;
             break;
-        case CFGNode::EXIT:
+        case CFGNodeGraph::EXIT:
             m_color = Qt::red;
             break;
-        case CFGNode::CONDITIONAL:
+        case CFGNodeGraph::CONDITIONAL:
             m_color = Qt::yellow;
             break;
-        case CFGNode::FUNCTION_CALL:
+        case CFGNodeGraph::FUNCTION_CALL:
             m_color = Qt::cyan;
             break;
         default:
@@ -49,7 +49,7 @@ void GraphicalCFGNode::paint(QPainter* painter, const QStyleOptionGraphicsItem*
 
     // Draw node content
     painter->drawText(rect, Qt::AlignCenter | Qt::TextWordWrap, 
-        QString::fromStdString(m_cfgNode->getContent()));
+        QString::fromStdString(m_graph->getContent(m_node)));
 }
 
 void GraphicalCFGNode::setColor(const QColor& color) {
@@ -58,7 +58,7 @@ void GraphicalCFGNode::setColor(const QColor& color) {
 }
 
 QString GraphicalCFGNode::getNodeLabel() const {
-    return QString::fromStdString(m_cfgNode->getContent());
+    return QString::fromStdString(m_graph->getContent(m_node));
 }
 
 void GraphicalCFGNode::mousePressEvent(QGraphicsSceneMouseEvent* event) {
@@ -7,6 +7,7 @@
 #include <QGraphicsTextItem>
 #include <QJsonDocument>
 #include <QGraphicsLineItem>
+#include <QGraphicsRectItem>
 #include <QWheelEvent>
 #include <QMouseEvent>
 #include <QJsonObject>
@@ -14,9 +15,19 @@
 #include <QJsonValue>
 #include <QQueue>
 #include <QPair>
+#include <QHash>
+#include <QVector>
 #include <QTimer>
+#include <QMenu>
+#include <QGraphicsSimpleTextItem>
 #include <cmath>
 #include <exception>
+#include "cfg_diff.h"
+#include "dead_code.h"
+#include "visualizer.h"
+
+// Item data key marking the "+n" expand marker of a slice boundary block.
+static const int SliceExpandMarker = 3;
 
 CustomGraphView::CustomGraphView(QWidget* parent) 
     : QGraphicsView(parent),
@@ -197,57 +208,75 @@ void CustomGraphView::calculateLevels() {
     
     if (m_nodes.isEmpty()) return;
     
-    // Find root nodes (nodes with no incoming edges)
-    QSet<QString> rootNodes;
-    QSet<QString> allNodes(m_nodes.keys().begin(), m_nodes.keys().end());
-    QSet<QString> nodesWithIncomingEdges;
+    // Index the nodes once and build successor lists plus in-degrees in a
+    // single pass over the edges, so layering is O(V + E).
+    const QStringList ids = m_nodes.keys();
+    const int nodeCount = ids.size();
+    QHash<QString, int> indexOf;
+    indexOf.reserve(nodeCount);
+    for (int i = 0; i < nodeCount; ++i) {
+        indexOf.insert(ids[i], i);
+    }
     
+    QVector<int> offsets(nodeCount + 1, 0);
+    QVector<int> inDegree(nodeCount, 0);
+    QVector<QPair<int, int>> edges;
+    edges.reserve(m_edges.size());
     foreach (const auto& edge, m_edges) {
-        nodesWithIncomingEdges.insert(edge.second);
+        if (m_backEdges.contains(edge)) continue;
+        auto from = indexOf.constFind(edge.first);
+        auto to = indexOf.constFind(edge.second);
+        if (from == indexOf.constEnd() || to == indexOf.constEnd()) continue;
+        edges.append(qMakePair(*from, *to));
+        ++offsets[*from + 1];
+        ++inDegree[*to];
     }
-    
-    // Root nodes are those with no incoming edges
-    foreach (const QString& nodeId, allNodes) {
-        if (!nodesWithIncomingEdges.contains(nodeId)) {
-            rootNodes.insert(nodeId);
-        }
+    for (int i = 0; i < nodeCount; ++i) {
+        offsets[i + 1] += offsets[i];
     }
-    
-    if (rootNodes.isEmpty()) {
-        rootNodes.insert(*allNodes.begin());
+    QVector<int> successors(edges.size());
+    {
+        QVector<int> cursor = offsets;
+        for (const auto& edge : edges) {
+            successors[cursor[edge.first]++] = edge.second;
+        }
     }
     
-    QQueue<QPair<QString, int>> queue;  // (nodeId, level)
-    
-    foreach (const QString& root, rootNodes) {
-        queue.enqueue(qMakePair(root, 0));
+    // Longest-path layering in topological order: a node is placed once all
+    // its predecessors are. Roots (no incoming edges) start at level 0. When
+    // only cycles remain, the first unplaced node is released early, which
+    // cuts the cycle at the edge that closes it.
+    QVector<int> level(nodeCount, 0);
+    QVector<bool> placed(nodeCount, false);
+    QQueue<int> ready;
+    for (int i = 0; i < nodeCount; ++i) {
+        if (inDegree[i] == 0) {
+            ready.enqueue(i);
+        }
     }
     
-    while (!queue.isEmpty()) {
-        auto current = queue.dequeue();
-        QString currentNode = current.first;
-        int currentLevel = current.second;
-        
-        // Update level if we found a longer path
-        if (!m_nodeLevels.contains(currentNode) || 
-            m_nodeLevels[currentNode] < currentLevel) {
-            m_nodeLevels[currentNode] = currentLevel;
+    int placedCount = 0;
+    int nextUnplaced = 0;
+    while (placedCount < nodeCount) {
+        if (ready.isEmpty()) {
+            while (placed[nextUnplaced]) ++nextUnplaced;
+            ready.enqueue(nextUnplaced);
         }
+        int current = ready.dequeue();
+        if (placed[current]) continue;
+        placed[current] = true;
+        ++placedCount;
+        m_nodeLevels[ids[current]] = level[current];
         
-        // Process all outgoing edges
-        foreach (const auto& edge, m_edges) {
-            if (edge.first == currentNode) {
-                queue.enqueue(qMakePair(edge.second, currentLevel + 1));
+        for (int e = offsets[current]; e < offsets[current + 1]; ++e) {
+            int next = successors[e];
+            if (placed[next]) continue;
+            level[next] = qMax(level[next], level[current] + 1);
+            if (--inDegree[next] == 0) {
+                ready.enqueue(next);
             }
         }
     }
-    
-    // Handle any unvisited nodes (disconnected components)
-    foreach (const QString& nodeId, allNodes) {
-        if (!m_nodeLevels.contains(nodeId)) {
-            m_nodeLevels[nodeId] = 0;  // Assign to level 0
-        }
-    }
 }
 
 void CustomGraphView::applyHierarchicalLayout() {
@@ -406,6 +435,38 @@ void CustomGraphView::parsePlainFormat(const QString& plainOutput) {
     m_scene->setSceneRect(m_scene->itemsBoundingRect());
 }
 
+bool CustomGraphView::showGraph(std::shared_ptr<const GraphGenerator::CSRGraph> graph) {
+    if (!graph || !scene()) return false;
+    if (graph->nodeCount() <= static_cast<size_t>(CollapseThreshold)) {
+        GraphGenerator::CFGGraph cfg(graph);
+        return parseDotFormat(QString::fromStdString(Visualizer::generateDotRepresentation(&cfg)));
+    }
+    clear();
+    return openCollapsed(std::move(graph));
+}
+
+bool CustomGraphView::openCollapsed(std::shared_ptr<const GraphGenerator::CSRGraph> graph) {
+    m_sliceGraph = graph;
+    m_sliceLoops = std::make_unique<GraphGenerator::LoopForest>(GraphGenerator::LoopForest::build(*graph));
+    m_sliceUnreachable = GraphGenerator::unreachableBlocks(*graph);
+    m_sliceControlDependence = GraphGenerator::ControlDependence::build(
+        *graph, GraphGenerator::DominatorTree::build(GraphGenerator::ReversedGraph(*graph)));
+    m_sliceRegions = std::make_unique<GraphGenerator::ProgramStructureTree>(
+        GraphGenerator::ProgramStructureTree::build(*graph, RegionFanout));
+    // Without the AST only the structural branch heuristics apply.
+    m_sliceFrequencies = GraphGenerator::estimateBlockFrequencies(
+        *graph, *m_sliceLoops, GraphGenerator::estimateBranchProbabilities(*graph, *m_sliceLoops));
+    m_maxFrequency = *std::max_element(m_sliceFrequencies.begin(), m_sliceFrequencies.end());
+    if (showRegions()) {
+        qDebug() << "Showing" << graph->nodeCount() << "block graph as"
+                 << m_nodes.size() << "blocks and regions";
+        return true;
+    }
+    const GraphGenerator::CSRGraph::Index start = graph->entry() != GraphGenerator::CSRGraph::InvalidIndex ? graph->entry() : 0;
+    qDebug() << "Showing" << graph->nodeCount() << "block graph in slices";
+    return showSlice(SliceKind::Neighborhood, graph->blockId(start));
+}
+
 bool CustomGraphView::parseDotFormat(const QString& dotContent) {
     if (!scene()) {
         qWarning() << "No scene available for parsing";
@@ -414,6 +475,16 @@ bool CustomGraphView::parseDotFormat(const QString& dotContent) {
     
     // Clear the existing graph before parsing
     clear();
+
+    // Large CFGs are read into a CSRGraph instead and shown collapsed to
+    // their top-level regions, or a slice at a time around the entry.
+    if (dotContent.count('\n') > CollapseThreshold) {
+        const QByteArray utf8 = dotContent.toUtf8();
+        auto graph = GraphGenerator::parseCfgDot(std::string_view(utf8.constData(), utf8.size()));
+        if (graph && graph->nodeCount() > static_cast<size_t>(CollapseThreshold)) {
+            return openCollapsed(std::move(graph));
+        }
+    }
     
     // Use QRegularExpression instead of QRegExp (more powerful and less deprecated)
     // Node pattern: match both numbered nodes and named nodes
@@ -583,6 +654,8 @@ QMap<QString, QString> CustomGraphView::parseAttributes(const QString& attrStr)
 void CustomGraphView::createNodeFromDot(int id, const QString& label, const QMap<QString, QString>& attributes) {
     QGraphicsEllipseItem* node = new QGraphicsEllipseItem(-20, -20, 40, 40);
     node->setData(MainWindow::NodeItemType, 1);
+    node->setData(0, QString::number(id));  // looked up by findNodeById
+    m_nodes[QString::number(id)] = node;
     
     // Apply attributes
     if (attributes.contains("fillcolor")) {
@@ -592,25 +665,97 @@ void CustomGraphView::createNodeFromDot(int id, const QString& label, const QMap
     // Add label
     QGraphicsTextItem* text = new QGraphicsTextItem(label, node);
     text->setPos(-15, -15);
+
+    if (attributes.value("unreachable") == "true") {
+        m_unreachableNodes.insert(QString::number(id));
+        node->setOpacity(0.35);
+        node->setVisible(!m_hideUnreachable);
+    }
+
+    // Estimated executions per call, written by the generator
+    bool hasFrequency = false;
+    const double frequency = attributes.value("freq").toDouble(&hasFrequency);
+    if (hasFrequency) {
+        m_blockFrequencies[QString::number(id)] = frequency;
+        m_maxFrequency = std::max(m_maxFrequency, frequency);
+        if (m_heatMap) {
+            node->setBrush(QBrush(QColor(QString::fromStdString(GraphGenerator::heatColor(frequency, m_maxFrequency)))));
+        }
+    }
+
+    // Def-use sets written by the generator
+    const QString nodeId = QString::number(id);
+    const QStringList defs = attributes.value("defs").split(',', Qt::SkipEmptyParts);
+    const QStringList uses = attributes.value("uses").split(',', Qt::SkipEmptyParts);
+    for (const QString& variable : defs) {
+        m_variableDefs[variable].insert(nodeId);
+    }
+    for (const QString& variable : uses) {
+        m_variableUses[variable].insert(nodeId);
+    }
+    QStringList tooltip;
+    if (!defs.isEmpty() || !uses.isEmpty()) {
+        QStringList variables = defs + uses;
+        variables.removeDuplicates();
+        m_nodeVariables[nodeId] = variables;
+        tooltip << QString("defs: %1\nuses: %2").arg(defs.join(", "), uses.join(", "));
+    }
+
+    // Control dependence written by the generator, e.g. "5:T,9"
+    const QStringList controllers = attributes.value("cdeps").split(',', Qt::SkipEmptyParts);
+    if (!controllers.isEmpty()) {
+        m_controllers[nodeId] = controllers;
+        QStringList deciders;
+        for (const QString& controller : controllers) {
+            const QStringList parts = controller.split(':');
+            deciders << (parts.size() > 1 ? QString("%1 (%2)").arg(parts[0], parts[1] == "T" ? "true" : "false")
+                                          : parts[0]);
+        }
+        tooltip << QString("decided by: %1").arg(deciders.join(", "));
+    }
+    if (hasFrequency) {
+        tooltip << QString("estimated runs per call: %1").arg(frequency, 0, 'g', 3);
+    }
+    if (!tooltip.isEmpty()) {
+        node->setToolTip(tooltip.join('\n'));
+    }
     
     scene()->addItem(node);
 }
 
 void CustomGraphView::createEdgeFromDot(int source, int target, const QMap<QString, QString>& attributes) {
+    createEdgeFromDot(QString::number(source), QString::number(target), attributes);
+}
+
+void CustomGraphView::createEdgeFromDot(const QString& source, const QString& target, const QMap<QString, QString>& attributes) {
+    // Record the relationship for layout; back edges are tagged
+    // constraint=false by the generator and must not add a level.
+    QPair<QString, QString> relation = qMakePair(source, target);
+    m_edges.append(relation);
+    if (attributes.value("constraint") == "false") {
+        m_backEdges.insert(relation);
+    }
+    
     // Find source and target nodes in scene
-    QGraphicsItem* sourceItem = findNodeById(source);
-    QGraphicsItem* targetItem = findNodeById(target);
+    QGraphicsItem* sourceItem = m_nodes.value(source);
+    QGraphicsItem* targetItem = m_nodes.value(target);
     
     if (sourceItem && targetItem) {
         QLineF line(sourceItem->sceneBoundingRect().center(),
                    targetItem->sceneBoundingRect().center());
         QGraphicsLineItem* edge = new QGraphicsLineItem(line);
         edge->setData(MainWindow::EdgeItemType, 1);
+        edge->setData(1, relation.first);   // Store source node ID
+        edge->setData(2, relation.second);  // Store target node ID
         
         // Apply attributes
         if (attributes.contains("color")) {
             edge->setPen(QPen(QColor(attributes["color"])));
         }
+        if (m_unreachableNodes.contains(relation.first) || m_unreachableNodes.contains(relation.second)) {
+            edge->setOpacity(0.35);
+            edge->setVisible(!m_hideUnreachable);
+        }
         
         scene()->addItem(edge);
     }
@@ -654,6 +799,133 @@ void CustomGraphView::mousePressEvent(QMouseEvent *event)
         event->accept();
         return;
     }
+
+    // Alt-clicking a block offers the variables it accesses; picking one
+    // highlights all of that variable's definitions and uses. Shift-clicking
+    // two blocks highlights everything on the paths between them. A plain
+    // click is left to the scene, for selecting and dragging.
+    if (event->button() == Qt::LeftButton) {
+        QGraphicsItem* item = itemAt(event->pos());
+        const bool isExpandMarker = item && item->data(SliceExpandMarker).toBool();
+        if (item && item->parentItem()) {
+            item = item->parentItem();  // the label of a node
+        }
+        const QString nodeId = item ? item->data(0).toString() : QString();
+        if (isExpandMarker && expandSlice(nodeId.toInt())) {
+            event->accept();
+            return;
+        }
+        if (regionOfItem(nodeId) != GraphGenerator::ProgramStructureTree::NoRegion) {
+            expandRegion(regionOfItem(nodeId));
+            event->accept();
+            return;
+        }
+        if ((event->modifiers() & Qt::ControlModifier) && m_nodes.contains(nodeId)) {
+            if (!highlightControlDependence(nodeId)) {
+                qDebug() << "Block" << nodeId << "has no control dependences";
+            }
+            event->accept();
+            return;
+        }
+        if ((event->modifiers() & Qt::ShiftModifier) && m_nodes.contains(nodeId)) {
+            if (m_pathSource.isEmpty()) {
+                m_pathSource = nodeId;
+                m_nodes[nodeId]->setPen(QPen(QColor("purple"), 3));
+            } else {
+                if (!highlightBetween(m_pathSource, nodeId)) {
+                    qDebug() << "No path from block" << m_pathSource << "to block" << nodeId;
+                }
+                m_pathSource.clear();
+            }
+            event->accept();
+            return;
+        }
+        auto variables = m_nodeVariables.constFind(nodeId);
+        if ((event->modifiers() & Qt::AltModifier) && variables != m_nodeVariables.constEnd()) {
+            QMenu menu(this);
+            for (const QString& variable : variables.value()) {
+                menu.addAction(variable);
+            }
+            if (QAction* chosen = menu.exec(event->globalPos())) {
+                highlightVariable(chosen->text());
+            }
+            event->accept();
+            return;
+        }
+    }
+    // For large graphs, right-clicking a block re-centres the view on it
+    // as a slice; both blocks and region boxes can also switch regions.
+    if (event->button() == Qt::RightButton && m_sliceGraph) {
+        QGraphicsItem* item = itemAt(event->pos());
+        if (item && item->parentItem()) {
+            item = item->parentItem();
+        }
+        const QString nodeId = item ? item->data(0).toString() : QString();
+        if (m_nodes.contains(nodeId)) {
+            using Tree = GraphGenerator::ProgramStructureTree;
+            QMenu menu(this);
+            const uint32_t region = regionOfItem(nodeId);
+            if (region == Tree::NoRegion) {
+                const QList<QPair<QString, SliceKind>> kinds = {
+                    {"Neighbourhood", SliceKind::Neighborhood},
+                    {"Enclosing loop", SliceKind::Loop},
+                    {"Dominated region", SliceKind::DominatorRegion},
+                    {"Paths to exit", SliceKind::PathsToExit},
+                    {"Paths from entry", SliceKind::PathsFromEntry},
+                };
+                for (const auto& kind : kinds) {
+                    menu.addAction(kind.first)->setData(static_cast<int>(kind.second));
+                }
+            } else {
+                menu.addAction("Expand region", [this, region]() { expandRegion(region); });
+            }
+            // The innermost expanded region around the item, if not the root
+            uint32_t enclosing = Tree::NoRegion;
+            if (m_regionView) {
+                enclosing = region != Tree::NoRegion ? m_sliceRegions->region(region).parent
+                                                     : m_sliceRegions->regionOf(m_sliceGraph->indexOf(nodeId.toInt()));
+                while (enclosing != Tree::NoRegion && !m_expandedRegions[enclosing]) {
+                    enclosing = m_sliceRegions->region(enclosing).parent;
+                }
+            }
+            if (enclosing != Tree::NoRegion && enclosing != Tree::Root) {
+                menu.addAction("Collapse enclosing region", [this, enclosing]() { collapseRegion(enclosing); });
+            }
+            if (m_sliceRegions) {
+                menu.addAction("Region overview", [this]() { showRegions(); });
+            }
+            QAction* chosen = menu.exec(event->globalPos());
+            if (chosen && chosen->data().isValid()) {
+                showSlice(static_cast<SliceKind>(chosen->data().toInt()), nodeId.toInt());
+            }
+            event->accept();
+            return;
+        }
+    }
+    if (event->button() == Qt::RightButton && !itemAt(event->pos()) &&
+        (!m_unreachableNodes.isEmpty() || !m_blockFrequencies.isEmpty())) {
+        QMenu menu(this);
+        QAction* hide = nullptr;
+        QAction* heat = nullptr;
+        if (!m_unreachableNodes.isEmpty()) {
+            hide = menu.addAction("Hide unreachable blocks");
+            hide->setCheckable(true);
+            hide->setChecked(m_hideUnreachable);
+        }
+        if (!m_blockFrequencies.isEmpty()) {
+            heat = menu.addAction("Heat map (estimated frequency)");
+            heat->setCheckable(true);
+            heat->setChecked(m_heatMap);
+        }
+        QAction* chosen = menu.exec(event->globalPos());
+        if (chosen && chosen == hide) {
+            setUnreachableHidden(hide->isChecked());
+        } else if (chosen && chosen == heat) {
+            setHeatMapEnabled(heat->isChecked());
+        }
+        event->accept();
+        return;
+    }
     QGraphicsView::mousePressEvent(event);
 }
 
@@ -702,6 +974,481 @@ void CustomGraphView::highlightFunction(const QString& functionName)
     }
 }
 
+bool CustomGraphView::highlightVariable(const QString& variable)
+{
+    const QSet<QString> defs = m_variableDefs.value(variable);
+    const QSet<QString> uses = m_variableUses.value(variable);
+
+    for (auto it = m_nodes.begin(); it != m_nodes.end(); ++it) {
+        QGraphicsEllipseItem* node = it.value();
+        const bool isDef = defs.contains(it.key());
+        const bool isUse = uses.contains(it.key());
+        // A block that both reads and writes the variable gets the def
+        // colour with a green outline.
+        node->setBrush(QBrush(isDef ? QColor("orange") : isUse ? QColor("lightgreen") : QColor(Qt::lightGray)));
+        node->setPen(isDef && isUse ? QPen(QColor("green"), 3) : QPen(Qt::black));
+    }
+    return !defs.isEmpty() || !uses.isEmpty();
+}
+
+bool CustomGraphView::hasVariable(const QString& variable) const
+{
+    return m_variableDefs.contains(variable) || m_variableUses.contains(variable);
+}
+
+void CustomGraphView::ensureReachabilityIndex()
+{
+    // Nodes are only ever added together with their edges, so the edge
+    // count tells whether the index still matches the scene.
+    if (m_reachability && m_reachabilityEdgeCount == m_edges.size() &&
+        m_reachabilityIds.size() == m_nodes.size()) {
+        return;
+    }
+
+    m_reachabilityIds = m_nodes.keys();
+    m_reachabilityIndexOf.clear();
+    m_reachabilityIndexOf.reserve(m_reachabilityIds.size());
+    GraphGenerator::CSRGraphBuilder builder;
+    builder.reserve(m_reachabilityIds.size(), m_edges.size(), 0);
+    for (int i = 0; i < m_reachabilityIds.size(); ++i) {
+        m_reachabilityIndexOf.insert(m_reachabilityIds[i], i);
+        builder.addNode(i);
+    }
+    for (const auto& edge : m_edges) {
+        auto from = m_reachabilityIndexOf.constFind(edge.first);
+        auto to = m_reachabilityIndexOf.constFind(edge.second);
+        if (from != m_reachabilityIndexOf.constEnd() && to != m_reachabilityIndexOf.constEnd()) {
+            builder.addEdge(*from, *to);
+        }
+    }
+    m_reachability = std::make_unique<GraphGenerator::ReachabilityIndex>(
+        GraphGenerator::ReachabilityIndex::build(builder.freeze()));
+    m_reachabilityEdgeCount = m_edges.size();
+}
+
+bool CustomGraphView::highlightBetween(const QString& from, const QString& to)
+{
+    if (!m_nodes.contains(from) || !m_nodes.contains(to)) return false;
+    ensureReachabilityIndex();
+
+    // Builder IDs are the positions in m_reachabilityIds and freeze()
+    // orders nodes by ID, so graph indices and positions coincide.
+    QSet<QString> onPath;
+    for (GraphGenerator::CSRGraph::Index n :
+         m_reachability->between(m_reachabilityIndexOf.value(from), m_reachabilityIndexOf.value(to))) {
+        onPath.insert(m_reachabilityIds[n]);
+    }
+
+    for (auto it = m_nodes.begin(); it != m_nodes.end(); ++it) {
+        const bool isEndpoint = it.key() == from || it.key() == to;
+        it.value()->setBrush(QBrush(onPath.contains(it.key()) ? QColor("plum") : QColor(Qt::lightGray)));
+        it.value()->setPen(isEndpoint ? QPen(QColor("purple"), 3) : QPen(Qt::black));
+    }
+    for (QGraphicsItem* item : m_scene->items()) {
+        if (auto edge = dynamic_cast<QGraphicsLineItem*>(item)) {
+            const bool inSubgraph = onPath.contains(edge->data(1).toString()) &&
+                                    onPath.contains(edge->data(2).toString());
+            QPen pen = edge->pen();
+            pen.setWidthF(inSubgraph ? 3.0 : 1.0);
+            edge->setPen(pen);
+        }
+    }
+    return !onPath.isEmpty();
+}
+
+bool CustomGraphView::showSlice(SliceKind kind, int blockId)
+{
+    if (!m_sliceGraph) return false;
+    const GraphGenerator::CSRGraph& graph = *m_sliceGraph;
+    const GraphGenerator::CSRGraph::Index focus = graph.indexOf(blockId);
+    if (focus == GraphGenerator::CSRGraph::InvalidIndex) return false;
+
+    switch (kind) {
+    case SliceKind::Neighborhood:
+        m_slice = GraphGenerator::neighborhoodSlice(graph, focus, SliceHops);
+        break;
+    case SliceKind::Loop:
+        m_slice = GraphGenerator::loopSlice(graph, *m_sliceLoops, focus);
+        break;
+    case SliceKind::DominatorRegion:
+        if (!m_sliceDominators) {
+            m_sliceDominators = std::make_unique<GraphGenerator::DominatorTree>(
+                GraphGenerator::DominatorTree::build(graph));
+        }
+        m_slice = GraphGenerator::dominatorRegionSlice(graph, *m_sliceDominators, focus);
+        break;
+    case SliceKind::PathsToExit:
+        m_slice = GraphGenerator::exitPathSlice(graph, focus);
+        break;
+    case SliceKind::PathsFromEntry:
+        m_slice = GraphGenerator::entryPathSlice(graph, focus);
+        break;
+    }
+    if (m_slice.truncated) {
+        qDebug() << "Slice around block" << blockId << "truncated to" << m_slice.nodes.size() << "blocks";
+    }
+    m_regionView = false;
+    syncSliceItems();
+    return true;
+}
+
+bool CustomGraphView::expandSlice(int blockId)
+{
+    if (!m_sliceGraph) return false;
+    const GraphGenerator::CSRGraph::Index n = m_sliceGraph->indexOf(blockId);
+    if (n == GraphGenerator::CSRGraph::InvalidIndex || !m_slice.isBoundary(n)) return false;
+    m_slice = GraphGenerator::expandSlice(*m_sliceGraph, m_slice, n);
+    syncSliceItems();
+    return true;
+}
+
+bool CustomGraphView::showRegions()
+{
+    if (!m_sliceRegions) return false;
+    const size_t topLevel = m_sliceRegions->children(GraphGenerator::ProgramStructureTree::Root).size() +
+                            m_sliceRegions->blocks(GraphGenerator::ProgramStructureTree::Root).size();
+    if (topLevel > static_cast<size_t>(SliceThreshold)) return false;
+    m_expandedRegions.assign(m_sliceRegions->regionCount(), 0);
+    m_expandedRegions[GraphGenerator::ProgramStructureTree::Root] = 1;
+    m_regionView = true;
+    syncRegionItems();
+    return true;
+}
+
+bool CustomGraphView::expandRegion(uint32_t region)
+{
+    if (!m_regionView || region >= m_expandedRegions.size() || m_expandedRegions[region]) return false;
+    m_expandedRegions[region] = 1;
+    syncRegionItems();
+    return true;
+}
+
+bool CustomGraphView::collapseRegion(uint32_t region)
+{
+    if (!m_regionView || region == GraphGenerator::ProgramStructureTree::Root ||
+        region >= m_expandedRegions.size() || !m_expandedRegions[region]) {
+        return false;
+    }
+    m_expandedRegions[region] = 0;
+    syncRegionItems();
+    return true;
+}
+
+uint32_t CustomGraphView::regionOfItem(const QString& id) const
+{
+    if (!m_sliceRegions || !id.startsWith('R')) return GraphGenerator::ProgramStructureTree::NoRegion;
+    bool ok = false;
+    const uint32_t region = id.mid(1).toUInt(&ok);
+    return ok && region < m_sliceRegions->regionCount() ? region : GraphGenerator::ProgramStructureTree::NoRegion;
+}
+
+void CustomGraphView::syncRegionItems()
+{
+    using Tree = GraphGenerator::ProgramStructureTree;
+    const GraphGenerator::CSRGraph& graph = *m_sliceGraph;
+    const Tree& tree = *m_sliceRegions;
+
+    // Each block is drawn as the outermost collapsed region around it, or
+    // as itself. Regions of a single block are never worth a box. Parents
+    // precede children in preorder, so one pass settles every region.
+    std::vector<uint32_t> shownAs(tree.regionCount(), Tree::NoRegion);
+    for (uint32_t r = 1; r < tree.regionCount(); ++r) {
+        const uint32_t outer = shownAs[tree.region(r).parent];
+        shownAs[r] = outer != Tree::NoRegion ? outer
+                   : m_expandedRegions[r] || tree.region(r).blockCount <= 1 ? Tree::NoRegion : r;
+    }
+    auto unitOf = [&](GraphGenerator::CSRGraph::Index n) {
+        const uint32_t region = shownAs[tree.regionOf(n)];
+        return region != Tree::NoRegion ? QString("R%1").arg(region) : QString::number(graph.blockId(n));
+    };
+
+    QSet<QString> visible;
+    for (GraphGenerator::CSRGraph::Index n = 0; n < graph.nodeCount(); ++n) {
+        visible.insert(unitOf(n));
+    }
+    pruneSliceItems(visible);
+    for (GraphGenerator::CSRGraph::Index n = 0; n < graph.nodeCount(); ++n) {
+        const QString unit = unitOf(n);
+        if (m_nodes.contains(unit)) continue;
+        if (unit.startsWith('R')) createRegionItem(shownAs[tree.regionOf(n)]);
+        else createSliceBlockItem(n);
+    }
+
+    // One edge per pair of items; an edge closing a loop stays a back edge
+    // even when it now joins two regions.
+    QSet<QPair<QString, QString>> shownEdges;
+    for (const auto& edge : m_edges) {
+        shownEdges.insert(edge);
+    }
+    for (GraphGenerator::CSRGraph::Index n = 0; n < graph.nodeCount(); ++n) {
+        const QString from = unitOf(n);
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            const QString to = unitOf(graph.edgeTarget(e));
+            if (from == to || shownEdges.contains(qMakePair(from, to))) continue;
+            shownEdges.insert(qMakePair(from, to));
+            QMap<QString, QString> attributes;
+            attributes["color"] = graph.edgeFlags(e) & GraphGenerator::EdgeException ? "red" : "black";
+            if (m_sliceLoops->isBackEdge(e)) {
+                attributes["constraint"] = "false";
+            }
+            createEdgeFromDot(from, to, attributes);
+        }
+    }
+
+    // Blocks carried over from a slice lose its focus and "+n" markers.
+    for (QGraphicsEllipseItem* node : m_nodes) {
+        if (regionOfItem(node->data(0).toString()) != Tree::NoRegion) continue;
+        for (QGraphicsItem* child : node->childItems()) {
+            if (child->data(SliceExpandMarker).toBool()) delete child;
+        }
+        node->setPen(QPen(Qt::black));
+    }
+
+    m_reachability.reset();
+    applyHierarchicalLayout();
+    updateEdgeGeometry();
+    m_scene->setSceneRect(m_scene->itemsBoundingRect().adjusted(-20, -20, 20, 20));
+}
+
+void CustomGraphView::createRegionItem(uint32_t region)
+{
+    const GraphGenerator::ProgramStructureTree::Region& info = m_sliceRegions->region(region);
+    const GraphGenerator::CSRGraph& graph = *m_sliceGraph;
+    const QString id = QString("R%1").arg(region);
+
+    // The ellipse stays the node item the layout and highlighting expect;
+    // the box drawn over it is what the user sees.
+    QGraphicsEllipseItem* node = new QGraphicsEllipseItem(-45, -25, 90, 50);
+    node->setData(MainWindow::NodeItemType, 1);
+    node->setData(0, id);
+    node->setPen(Qt::NoPen);
+    m_nodes[id] = node;
+    QGraphicsRectItem* box = new QGraphicsRectItem(node->rect(), node);
+    box->setBrush(QBrush(QColor("lightsteelblue")));
+    box->setPen(QPen(QColor("darkblue"), 1, info.sequence ? Qt::DashLine : Qt::SolidLine));
+    QGraphicsTextItem* text = new QGraphicsTextItem(QString("%1 blocks").arg(info.blockCount), node);
+    text->setPos(-35, -12);
+
+    // The blocks just inside the entry and exit edges
+    const QString from = QString::number(graph.blockId(graph.edgeTarget(info.entryEdge)));
+    QString to = "exit";
+    if (info.exitEdge != GraphGenerator::ProgramStructureTree::NoEdge) {
+        const GraphGenerator::CSRGraph::Index after = graph.edgeTarget(info.exitEdge);
+        const llvm::ArrayRef<uint32_t> incoming = graph.predecessorEdges(after);
+        const auto it = std::find(incoming.begin(), incoming.end(), info.exitEdge);
+        to = QString::number(graph.blockId(graph.predecessors(after)[it - incoming.begin()]));
+    }
+    node->setToolTip(QString("%1 from block %2 to block %3\nclick to expand")
+                         .arg(info.sequence ? "Sequence of regions" : "Single-entry/single-exit region", from, to));
+    scene()->addItem(node);
+}
+
+void CustomGraphView::syncSliceItems()
+{
+    const GraphGenerator::CSRGraph& graph = *m_sliceGraph;
+    auto idOf = [&](GraphGenerator::CSRGraph::Index n) { return QString::number(graph.blockId(n)); };
+
+    QSet<QString> visible;
+    for (GraphGenerator::CSRGraph::Index n : m_slice.nodes) {
+        visible.insert(idOf(n));
+    }
+    pruneSliceItems(visible);
+    for (GraphGenerator::CSRGraph::Index n : m_slice.nodes) {
+        if (!m_nodes.contains(idOf(n))) createSliceBlockItem(n);
+    }
+    QSet<QPair<QString, QString>> shownEdges;
+    for (const auto& edge : m_edges) {
+        shownEdges.insert(edge);
+    }
+    for (GraphGenerator::CSRGraph::Index n : m_slice.nodes) {
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            const GraphGenerator::CSRGraph::Index target = graph.edgeTarget(e);
+            if (!m_slice.contains(target) || shownEdges.contains(qMakePair(idOf(n), idOf(target)))) continue;
+            QMap<QString, QString> attributes;
+            attributes["color"] = graph.edgeFlags(e) & GraphGenerator::EdgeException ? "red" : "black";
+            if (m_sliceLoops->isBackEdge(e)) {
+                attributes["constraint"] = "false";
+            }
+            createEdgeFromDot(graph.blockId(n), graph.blockId(target), attributes);
+        }
+    }
+
+    // Boundary blocks carry a "+n" marker counting their hidden neighbours.
+    for (GraphGenerator::CSRGraph::Index n : m_slice.nodes) {
+        QGraphicsEllipseItem* node = m_nodes.value(idOf(n));
+        QGraphicsSimpleTextItem* marker = nullptr;
+        for (QGraphicsItem* child : node->childItems()) {
+            if (child->data(SliceExpandMarker).toBool()) marker = static_cast<QGraphicsSimpleTextItem*>(child);
+        }
+        int hidden = 0;
+        if (m_slice.isBoundary(n)) {
+            for (GraphGenerator::CSRGraph::Index succ : graph.successors(n)) hidden += !m_slice.contains(succ);
+            for (GraphGenerator::CSRGraph::Index pred : graph.predecessors(n)) hidden += !m_slice.contains(pred);
+        }
+        if (hidden == 0) {
+            delete marker;
+        } else {
+            if (!marker) {
+                marker = new QGraphicsSimpleTextItem(node);
+                marker->setData(SliceExpandMarker, true);
+                marker->setBrush(QBrush(QColor("darkblue")));
+                marker->setPos(16, -28);
+                marker->setToolTip("Show hidden neighbours");
+            }
+            marker->setText(QString("+%1").arg(hidden));
+        }
+        node->setPen(n == m_slice.focus ? QPen(QColor("darkblue"), 3)
+                     : hidden ? QPen(Qt::black, 1, Qt::DashLine) : QPen(Qt::black));
+    }
+
+    m_reachability.reset();
+    applyHierarchicalLayout();
+    updateEdgeGeometry();
+    m_scene->setSceneRect(m_scene->itemsBoundingRect().adjusted(-20, -20, 20, 20));
+}
+
+void CustomGraphView::pruneSliceItems(const QSet<QString>& visible)
+{
+    // Items that stay visible are kept as they are; the rest are removed.
+    QSet<QString> removed;
+    for (auto it = m_nodes.constBegin(); it != m_nodes.constEnd(); ++it) {
+        if (!visible.contains(it.key())) removed.insert(it.key());
+    }
+    if (!removed.isEmpty()) {
+        for (QGraphicsItem* item : m_scene->items()) {
+            auto edge = dynamic_cast<QGraphicsLineItem*>(item);
+            if (edge && (removed.contains(edge->data(1).toString()) || removed.contains(edge->data(2).toString()))) {
+                m_scene->removeItem(edge);
+                delete edge;
+            }
+        }
+        for (int i = m_edges.size() - 1; i >= 0; --i) {
+            if (removed.contains(m_edges[i].first) || removed.contains(m_edges[i].second)) {
+                m_backEdges.remove(m_edges[i]);
+                m_edges.removeAt(i);
+            }
+        }
+        for (const QString& id : removed) {
+            removeNodeItem(id);
+        }
+    }
+}
+
+void CustomGraphView::createSliceBlockItem(GraphGenerator::CSRGraph::Index n)
+{
+    const GraphGenerator::CSRGraph& graph = *m_sliceGraph;
+    QMap<QString, QString> attributes;
+    attributes["fillcolor"] = graph.attributes(n) & GraphGenerator::NodeThrowsException ? "lightcoral"
+                            : graph.attributes(n) & GraphGenerator::NodeTryBlock ? "lightblue" : "lightgray";
+    QStringList defs, uses;
+    for (uint32_t v : graph.variablesDefinedIn(n)) {
+        defs << QString::fromUtf8(graph.variableName(v).data(), static_cast<int>(graph.variableName(v).size()));
+    }
+    for (uint32_t v : graph.variablesUsedIn(n)) {
+        uses << QString::fromUtf8(graph.variableName(v).data(), static_cast<int>(graph.variableName(v).size()));
+    }
+    attributes["defs"] = defs.join(',');
+    attributes["uses"] = uses.join(',');
+    if (std::binary_search(m_sliceUnreachable.begin(), m_sliceUnreachable.end(), n)) {
+        attributes["unreachable"] = "true";
+    }
+    QStringList controllers;
+    const llvm::ArrayRef<uint32_t> controllingEdges = m_sliceControlDependence.controllingEdges(n);
+    for (size_t i = 0; i < controllingEdges.size(); ++i) {
+        const uint8_t flags = graph.edgeFlags(controllingEdges[i]);
+        controllers << QString::number(graph.blockId(m_sliceControlDependence.controllers(n)[i])) +
+                       (flags & GraphGenerator::EdgeTrueBranch ? ":T" : flags & GraphGenerator::EdgeFalseBranch ? ":F" : "");
+    }
+    attributes["cdeps"] = controllers.join(',');
+    attributes["freq"] = QString::number(m_sliceFrequencies[n]);
+    const std::string_view label = graph.label(n);
+    createNodeFromDot(graph.blockId(n), QString::fromUtf8(label.data(), static_cast<int>(label.size())), attributes);
+}
+
+void CustomGraphView::removeNodeItem(const QString& id)
+{
+    QGraphicsEllipseItem* node = m_nodes.take(id);
+    for (const QString& variable : m_nodeVariables.take(id)) {
+        for (QHash<QString, QSet<QString>>* blocks : {&m_variableDefs, &m_variableUses}) {
+            auto it = blocks->find(variable);
+            if (it == blocks->end()) continue;
+            it->remove(id);
+            if (it->isEmpty()) blocks->erase(it);
+        }
+    }
+    m_nodeLevels.remove(id);
+    m_unreachableNodes.remove(id);
+    m_controllers.remove(id);
+    m_blockFrequencies.remove(id);
+    if (node) {
+        m_scene->removeItem(node);
+        delete node;
+    }
+}
+
+void CustomGraphView::setUnreachableHidden(bool hidden)
+{
+    m_hideUnreachable = hidden;
+    for (const QString& id : m_unreachableNodes) {
+        if (QGraphicsEllipseItem* node = m_nodes.value(id)) node->setVisible(!hidden);
+    }
+    for (QGraphicsItem* item : m_scene->items()) {
+        auto edge = dynamic_cast<QGraphicsLineItem*>(item);
+        if (edge && (m_unreachableNodes.contains(edge->data(1).toString()) ||
+                     m_unreachableNodes.contains(edge->data(2).toString()))) {
+            edge->setVisible(!hidden);
+        }
+    }
+}
+
+void CustomGraphView::setHeatMapEnabled(bool enabled)
+{
+    m_heatMap = enabled;
+    for (auto it = m_blockFrequencies.constBegin(); it != m_blockFrequencies.constEnd(); ++it) {
+        QGraphicsEllipseItem* node = m_nodes.value(it.key());
+        if (!node) continue;
+        node->setBrush(enabled ? QBrush(QColor(QString::fromStdString(GraphGenerator::heatColor(it.value(), m_maxFrequency))))
+                               : QBrush(Qt::lightGray));
+    }
+}
+
+void CustomGraphView::updateEdgeGeometry()
+{
+    for (QGraphicsItem* item : m_scene->items()) {
+        auto edge = dynamic_cast<QGraphicsLineItem*>(item);
+        if (!edge) continue;
+        QGraphicsEllipseItem* from = m_nodes.value(edge->data(1).toString());
+        QGraphicsEllipseItem* to = m_nodes.value(edge->data(2).toString());
+        if (from && to) {
+            edge->setLine(QLineF(from->sceneBoundingRect().center(), to->sceneBoundingRect().center()));
+        }
+    }
+}
+
+bool CustomGraphView::highlightControlDependence(const QString& block)
+{
+    if (!m_nodes.contains(block)) return false;
+
+    QSet<QString> controllers;
+    for (const QString& controller : m_controllers.value(block)) {
+        controllers.insert(controller.section(':', 0, 0));
+    }
+    QSet<QString> dependents;
+    for (auto it = m_controllers.constBegin(); it != m_controllers.constEnd(); ++it) {
+        for (const QString& controller : it.value()) {
+            if (controller.section(':', 0, 0) == block) dependents.insert(it.key());
+        }
+    }
+
+    for (auto it = m_nodes.begin(); it != m_nodes.end(); ++it) {
+        const QColor fill = controllers.contains(it.key()) ? QColor("gold")
+                          : dependents.contains(it.key()) ? QColor("lightcyan") : QColor(Qt::lightGray);
+        it.value()->setBrush(QBrush(fill));
+        it.value()->setPen(it.key() == block ? QPen(QColor("purple"), 3) : QPen(Qt::black));
+    }
+    return !controllers.isEmpty() || !dependents.isEmpty();
+}
+
 bool CustomGraphView::hasHighlightedItems() const
 {
     if (!m_scene) return false;
@@ -857,7 +1604,29 @@ void CustomGraphView::clear()
     }
     m_nodes.clear();
     m_edges.clear();
+    m_backEdges.clear();
+    m_variableDefs.clear();
+    m_variableUses.clear();
+    m_nodeVariables.clear();
+    m_controllers.clear();
     m_nodeLevels.clear();
+    m_reachability.reset();
+    m_reachabilityIndexOf.clear();
+    m_reachabilityIds.clear();
+    m_pathSource.clear();
+    m_sliceGraph.reset();
+    m_sliceLoops.reset();
+    m_sliceDominators.reset();
+    m_slice = GraphGenerator::GraphSlice();
+    m_sliceUnreachable.clear();
+    m_unreachableNodes.clear();
+    m_sliceFrequencies.clear();
+    m_blockFrequencies.clear();
+    m_maxFrequency = 0;
+    m_sliceControlDependence = GraphGenerator::ControlDependence();
+    m_sliceRegions.reset();
+    m_expandedRegions.clear();
+    m_regionView = false;
     
     // Reinitialize basic items
     if (m_scene) {
@@ -871,7 +1640,29 @@ CustomGraphView::~CustomGraphView()
     // Clear containers first (items are owned by scene)
     m_nodes.clear();
     m_edges.clear();
+    m_backEdges.clear();
+    m_variableDefs.clear();
+    m_variableUses.clear();
+    m_nodeVariables.clear();
+    m_controllers.clear();
     m_nodeLevels.clear();
+    m_reachability.reset();
+    m_reachabilityIndexOf.clear();
+    m_reachabilityIds.clear();
+    m_pathSource.clear();
+    m_sliceGraph.reset();
+    m_sliceLoops.reset();
+    m_sliceDominators.reset();
+    m_slice = GraphGenerator::GraphSlice();
+    m_sliceUnreachable.clear();
+    m_unreachableNodes.clear();
+    m_sliceFrequencies.clear();
+    m_blockFrequencies.clear();
+    m_maxFrequency = 0;
+    m_sliceControlDependence = GraphGenerator::ControlDependence();
+    m_sliceRegions.reset();
+    m_expandedRegions.clear();
+    m_regionView = false;
     
     // Delete the scene if we own it
     if (m_scene) {
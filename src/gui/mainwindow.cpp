@@ -3,6 +3,7 @@
 #include "ui_mainwindow.h"
 #include "visualizer.h"
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QMessageBox>
 #include <QFile>
 #include <QJsonDocument>
@@ -335,7 +336,10 @@ void MainWindow::visualizeCFG(std::shared_ptr<GraphGenerator::CFGGraph> graph)
 
 std::shared_ptr<GraphGenerator::CFGGraph> MainWindow::parseDotToCFG(const QString& dotContent)
 {
-    auto graph = std::make_shared<GraphGenerator::CFGGraph>();
+    // Each parsed graph gets its own session: parsing runs on worker
+    // threads, and replacing m_currentGraph frees the previous graph's
+    // memory in one go.
+    GraphGenerator::CSRGraphBuilder graph(std::make_shared<GraphGenerator::AnalysisSession>());
         
     // Initialize regular expressions with properly escaped patterns
     QRegularExpression nodeRegex(R"(^\s*(\d+)\s*\[([^\]]*)\]\s*;?\s*$)");
@@ -343,6 +347,8 @@ std::shared_ptr<GraphGenerator::CFGGraph> MainWindow::parseDotToCFG(const QStrin
     QRegularExpression labelRegex(R"~(label\s*=\\s*"([^"]*)")~");
     QRegularExpression colorRegex(R"~(color\s*=\s*"?(red|blue|green|black|white|gray)"?)~");
     QRegularExpression shapeRegex(R"~(shape\s*=\s*"?(box|ellipse|diamond|circle)"?)~");
+    QRegularExpression defsRegex(R"~(defs\s*=\s*"([^"]*)")~");
+    QRegularExpression usesRegex(R"~(uses\s*=\s*"([^"]*)")~");
 
     // Verify regex validity
     auto checkRegex = [](const QRegularExpression& re, const QString& name) {
@@ -358,7 +364,7 @@ std::shared_ptr<GraphGenerator::CFGGraph> MainWindow::parseDotToCFG(const QStrin
         !checkRegex(labelRegex, "label") ||
         !checkRegex(colorRegex, "color") ||
         !checkRegex(shapeRegex, "shape")) {
-        return graph;
+        return std::make_shared<GraphGenerator::CFGGraph>();
     }
 
     // Split and process DOT content
@@ -381,22 +387,33 @@ std::shared_ptr<GraphGenerator::CFGGraph> MainWindow::parseDotToCFG(const QStrin
             int id = nodeMatch.captured(1).toInt(&ok);
             if (!ok) continue;
             
-            graph->addNode(id);
+            graph.addNode(id);
             
             QString attributes = nodeMatch.captured(2);
             auto labelMatch = labelRegex.match(attributes);
             if (labelMatch.hasMatch()) {
-                graph->addStatement(id, labelMatch.captured(1).toStdString());
+                graph.addStatement(id, labelMatch.captured(1).toStdString());
             }
             
             auto colorMatch = colorRegex.match(attributes);
             if (colorMatch.hasMatch() && colorMatch.captured(1) == "red") {
-                graph->markNodeAsThrowingException(id);
+                graph.addAttributes(id, GraphGenerator::NodeThrowsException);
             }
             
             auto shapeMatch = shapeRegex.match(attributes);
             if (shapeMatch.hasMatch() && shapeMatch.captured(1) == "box") {
-                graph->markNodeAsTryBlock(id);
+                graph.addAttributes(id, GraphGenerator::NodeTryBlock);
+            }
+
+            // DOT keeps def-use sets per block only, so every access is
+            // recorded at element 0.
+            const auto defsMatch = defsRegex.match(attributes);
+            for (const QString& name : defsMatch.captured(1).split(',', Qt::SkipEmptyParts)) {
+                graph.addVariableAccess(id, 0, name.toStdString(), nullptr, GraphGenerator::AccessKind::Write);
+            }
+            const auto usesMatch = usesRegex.match(attributes);
+            for (const QString& name : usesMatch.captured(1).split(',', Qt::SkipEmptyParts)) {
+                graph.addVariableAccess(id, 0, name.toStdString(), nullptr, GraphGenerator::AccessKind::Read);
             }
             continue;
         }
@@ -409,17 +426,15 @@ std::shared_ptr<GraphGenerator::CFGGraph> MainWindow::parseDotToCFG(const QStrin
             int toId = edgeMatch.captured(2).toInt(&ok2);
             if (!ok1 || !ok2) continue;
             
-            graph->addEdge(fromId, toId);
-            
             QString attributes = edgeMatch.captured(3);
             auto colorMatch = colorRegex.match(attributes);
-            if (colorMatch.hasMatch() && colorMatch.captured(1) == "red") {
-                graph->addExceptionEdge(fromId, toId);
-            }
+            const bool isException = colorMatch.hasMatch() && colorMatch.captured(1) == "red";
+            graph.addEdge(fromId, toId, isException ? GraphGenerator::EdgeException : GraphGenerator::EdgeNone);
         }
     }
     
-    return graph;
+    return std::make_shared<GraphGenerator::CFGGraph>(
+        std::make_shared<const GraphGenerator::CSRGraph>(graph.freeze()));
 }
 
 void MainWindow::loadAndProcessJson(const QString& filePath) 
@@ -844,6 +859,12 @@ void MainWindow::on_searchButton_clicked()
 {
     QString searchText = ui->search->text().trimmed();
     if (!searchText.isEmpty()) {
+        // Variables of the displayed CFG highlight their defs and uses
+        if (m_graphView->hasVariable(searchText)) {
+            m_graphView->highlightVariable(searchText);
+            return;
+        }
+
         // First try to highlight existing nodes
         m_graphView->highlightFunction(searchText);
         
@@ -865,7 +886,11 @@ void MainWindow::on_toggleFunctionGraph_clicked()
 void MainWindow::onLoadJsonClicked()
 {
     QString fileName = QFileDialog::getOpenFileName(this, "Open CFG JSON", 
-                                                  "", "JSON Files (*.json)");
+                                                  "", "JSON Files (*.json);;CFG Corpus (*.bin)");
+    if (fileName.endsWith(".bin")) {
+        openCorpus(fileName);
+        return;
+    }
     if (!fileName.isEmpty()) {
         QFile file(fileName);
         if (file.open(QIODevice::ReadOnly)) {
@@ -885,6 +910,52 @@ void MainWindow::onLoadJsonClicked()
     }
 }
 
+bool MainWindow::openCorpus(const QString& filePath, const QString& functionName)
+{
+    auto corpus = GraphGenerator::CFGCorpus::open(filePath.toStdString());
+    if (!corpus || corpus->size() == 0) {
+        QMessageBox::warning(this, "Error", "Not a CFG corpus: " + filePath);
+        return false;
+    }
+
+    QString name = functionName;
+    if (name.isEmpty()) {
+        QStringList names;
+        names.reserve(static_cast<int>(corpus->size()));
+        for (size_t i = 0; i < corpus->size(); ++i) {
+            const std::string_view function = corpus->name(i);
+            names << QString::fromUtf8(function.data(), static_cast<int>(function.size()));
+        }
+        names.sort();
+        bool ok = false;
+        name = QInputDialog::getItem(this, "Open CFG Corpus", "Function:", names, 0, false, &ok);
+        if (!ok) return false;
+    }
+
+    // The corpus is indexed by USR; names are few enough to scan.
+    const QByteArray utf8 = name.toUtf8();
+    size_t index = GraphGenerator::CFGCorpus::npos;
+    for (size_t i = 0; i < corpus->size() && index == GraphGenerator::CFGCorpus::npos; ++i) {
+        if (corpus->name(i) == std::string_view(utf8.constData(), utf8.size())) index = i;
+    }
+    auto graph = index != GraphGenerator::CFGCorpus::npos ? corpus->graph(index) : nullptr;
+    if (!graph || !m_graphView || !m_graphView->showGraph(graph)) {
+        QMessageBox::warning(this, "Error", "Could not load " + name + " from " + filePath);
+        return false;
+    }
+
+    const GraphGenerator::SourceSpan span = corpus->span(index);
+    if (span.beginLine > 0) {
+        statusBar()->showMessage(QString("%1 (%2:%3-%4)").arg(name, QString::fromStdString(span.file))
+                                     .arg(span.beginLine).arg(span.endLine));
+    }
+    if (!m_graphView->isSliced()) {
+        m_graphView->applyHierarchicalLayout();
+    }
+    m_graphView->fitInView(m_graphView->scene()->itemsBoundingRect(), Qt::KeepAspectRatio);
+    return true;
+}
+
 void MainWindow::onMergeCfgsClicked() {
     if (m_loadedFiles.size() < 2) {
         QMessageBox::warning(this, "Merge Error", "Need at least 2 CFGs to merge");
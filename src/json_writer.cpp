@@ -0,0 +1,155 @@
+#include "json_writer.h"
+#include <llvm/Support/ConvertUTF.h>
+
+namespace GraphGenerator {
+
+void JsonWriter::separator() {
+    if (m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+    if (m_empty.empty()) return;
+    if (!m_empty.back()) m_out << ',';
+    m_empty.back() = false;
+    newline(m_empty.size());
+}
+
+void JsonWriter::newline(size_t depth) {
+    if (m_indent == 0) return;
+    m_out << '\n';
+    m_out.indent(static_cast<unsigned>(depth * m_indent));
+}
+
+void JsonWriter::beginObject() {
+    separator();
+    m_out << '{';
+    m_empty.push_back(true);
+}
+
+void JsonWriter::endObject() {
+    const bool empty = m_empty.pop_back_val();
+    if (!empty) newline(m_empty.size());
+    m_out << '}';
+}
+
+void JsonWriter::beginArray() {
+    separator();
+    m_out << '[';
+    m_empty.push_back(true);
+}
+
+void JsonWriter::endArray() {
+    const bool empty = m_empty.pop_back_val();
+    if (!empty) newline(m_empty.size());
+    m_out << ']';
+}
+
+void JsonWriter::key(std::string_view name) {
+    separator();
+    writeString(name);
+    m_out << (m_indent ? ": " : ":");
+    m_afterKey = true;
+}
+
+void JsonWriter::value(std::string_view text) {
+    separator();
+    writeString(text);
+}
+
+void JsonWriter::value(bool flag) {
+    separator();
+    m_out << (flag ? "true" : "false");
+}
+
+void JsonWriter::null() {
+    separator();
+    m_out << "null";
+}
+
+void JsonWriter::embed(const nlohmann::json& json) {
+    switch (json.type()) {
+    case nlohmann::json::value_t::object:
+        beginObject();
+        for (auto it = json.begin(); it != json.end(); ++it) {
+            key(it.key());
+            embed(it.value());
+        }
+        endObject();
+        break;
+    case nlohmann::json::value_t::array:
+        beginArray();
+        for (const nlohmann::json& element : json) {
+            embed(element);
+        }
+        endArray();
+        break;
+    case nlohmann::json::value_t::string:
+        value(json.get_ref<const std::string&>());
+        break;
+    case nlohmann::json::value_t::boolean:
+        value(json.get<bool>());
+        break;
+    case nlohmann::json::value_t::number_integer:
+        value(json.get<int64_t>());
+        break;
+    case nlohmann::json::value_t::number_unsigned:
+        value(json.get<uint64_t>());
+        break;
+    case nlohmann::json::value_t::null:
+        null();
+        break;
+    default:
+        // Floating point and the rest keep nlohmann's own formatting;
+        // none of them spans lines.
+        separator();
+        m_out << json.dump();
+        break;
+    }
+}
+
+// Escapes as nlohmann does: the short forms for quote, backslash and the
+// usual control characters, \u00xx for the other control characters, and
+// everything else, including non-ASCII text, as is.
+void JsonWriter::writeString(std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    m_out << '"';
+    const char* run = text.data();
+    const char* end = text.data() + text.size();
+    for (const char* p = run; p != end;) {
+        const auto c = static_cast<unsigned char>(*p);
+        if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+            ++p;
+            continue;
+        }
+        if (c >= 0x80) {
+            const auto* bytes = reinterpret_cast<const llvm::UTF8*>(p);
+            if (llvm::isLegalUTF8Sequence(bytes, reinterpret_cast<const llvm::UTF8*>(end))) {
+                p += llvm::getNumBytesForUTF8(c);
+                continue;
+            }
+        }
+        m_out.write(run, p - run);
+        switch (c) {
+        case '"': m_out << "\\\""; break;
+        case '\\': m_out << "\\\\"; break;
+        case '\b': m_out << "\\b"; break;
+        case '\f': m_out << "\\f"; break;
+        case '\n': m_out << "\\n"; break;
+        case '\r': m_out << "\\r"; break;
+        case '\t': m_out << "\\t"; break;
+        default:
+            if (c < 0x20) {
+                const char escape[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                m_out.write(escape, sizeof(escape));
+            } else {
+                m_out << "\xEF\xBF\xBD";
+            }
+            break;
+        }
+        run = ++p;
+    }
+    m_out.write(run, end - run);
+    m_out << '"';
+}
+
+} // namespace GraphGenerator
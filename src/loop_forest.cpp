@@ -0,0 +1,221 @@
+#include "loop_forest.h"
+#include "parallel_for.h"
+#include <algorithm>
+
+namespace GraphGenerator {
+
+LoopForest LoopForest::build(const CSRGraph& graph) {
+    using Number = uint32_t;
+    constexpr Number None = ~Number(0);
+
+    LoopForest forest;
+    const size_t nodeCount = graph.nodeCount();
+    forest.m_innermost.assign(nodeCount, NoLoop);
+    forest.m_backEdges.assign(graph.edgeCount(), false);
+
+    // Preorder numbering over a DFS forest; last[w] is the highest number in
+    // w's subtree, so v descends from w iff w <= v <= last[w].
+    std::vector<Number> number(nodeCount, None);
+    std::vector<Index> vertex;
+    std::vector<Number> last(nodeCount, 0);
+    vertex.reserve(nodeCount);
+    {
+        std::vector<std::pair<Index, uint32_t>> stack;
+        auto visit = [&](Index root) {
+            number[root] = static_cast<Number>(vertex.size());
+            vertex.push_back(root);
+            stack.push_back({root, graph.edgeBegin(root)});
+            while (!stack.empty()) {
+                auto& [node, edge] = stack.back();
+                if (edge == graph.edgeEnd(node)) {
+                    last[number[node]] = static_cast<Number>(vertex.size() - 1);
+                    stack.pop_back();
+                    continue;
+                }
+                Index succ = graph.edgeTarget(edge++);
+                if (number[succ] == None) {
+                    number[succ] = static_cast<Number>(vertex.size());
+                    vertex.push_back(succ);
+                    stack.push_back({succ, graph.edgeBegin(succ)});
+                }
+            }
+        };
+        if (graph.entry() != CSRGraph::InvalidIndex) {
+            visit(graph.entry());
+        }
+        for (Index n = 0; n < nodeCount; ++n) {
+            if (number[n] == None) visit(n);
+        }
+    }
+    auto isAncestor = [&](Number w, Number v) { return w <= v && v <= last[w]; };
+
+    // Split incoming edges into back edges and the rest.
+    const Number count = static_cast<Number>(vertex.size());
+    std::vector<std::vector<Number>> backPreds(count);
+    std::vector<std::vector<Number>> nonBackPreds(count);
+    for (Number w = 0; w < count; ++w) {
+        Index node = vertex[w];
+        auto preds = graph.predecessors(node);
+        auto predEdges = graph.predecessorEdges(node);
+        for (size_t i = 0; i < preds.size(); ++i) {
+            Number v = number[preds[i]];
+            if (isAncestor(w, v)) {
+                backPreds[w].push_back(v);
+                forest.m_backEdges[predEdges[i]] = true;
+                ++forest.m_backEdgeCount;
+            } else {
+                nonBackPreds[w].push_back(v);
+            }
+        }
+    }
+
+    // Union-find with path compression; a set is represented by the header
+    // of the outermost loop collapsed into it so far.
+    std::vector<Number> unionParent(count);
+    for (Number i = 0; i < count; ++i) unionParent[i] = i;
+    std::vector<Number> compressPath;
+    auto find = [&](Number x) {
+        Number root = x;
+        while (unionParent[root] != root) root = unionParent[root];
+        while (unionParent[x] != root) {
+            Number next = unionParent[x];
+            unionParent[x] = root;
+            x = next;
+        }
+        return root;
+    };
+
+    std::vector<uint32_t> loopOfHeader(count, NoLoop);
+    std::vector<Number> header(count, None);  // innermost enclosing header
+    std::vector<Number> nodePool;
+    std::vector<Number> worklist;
+    std::vector<bool> inPool(count, false);
+
+    // Innermost loops first: headers in decreasing preorder.
+    for (Number w = count; w-- > 0;) {
+        nodePool.clear();
+        bool selfLoop = false;
+        for (Number v : backPreds[w]) {
+            if (v == w) {
+                selfLoop = true;
+                continue;
+            }
+            Number rep = find(v);
+            if (!inPool[rep]) {
+                inPool[rep] = true;
+                nodePool.push_back(rep);
+            }
+        }
+        if (nodePool.empty() && !selfLoop) continue;
+
+        bool irreducible = false;
+        worklist.assign(nodePool.begin(), nodePool.end());
+        while (!worklist.empty()) {
+            Number x = worklist.back();
+            worklist.pop_back();
+            for (Number y : nonBackPreds[x]) {
+                Number rep = find(y);
+                if (!isAncestor(w, rep)) {
+                    // Entered from outside w's subtree: w is not the only
+                    // way in. Keep the edge for the enclosing loops.
+                    irreducible = true;
+                    nonBackPreds[w].push_back(rep);
+                } else if (rep != w && !inPool[rep]) {
+                    inPool[rep] = true;
+                    nodePool.push_back(rep);
+                    worklist.push_back(rep);
+                }
+            }
+        }
+
+        uint32_t loopId = static_cast<uint32_t>(forest.m_loops.size());
+        forest.m_loops.push_back({vertex[w], NoLoop, 0, irreducible});
+        loopOfHeader[w] = loopId;
+        for (Number x : nodePool) {
+            inPool[x] = false;
+            header[x] = w;
+            unionParent[x] = w;
+            if (loopOfHeader[x] != NoLoop) {
+                forest.m_loops[loopOfHeader[x]].parent = loopId;
+            }
+        }
+    }
+
+    // Loops were created innermost first, so parents come later.
+    for (size_t id = forest.m_loops.size(); id-- > 0;) {
+        Loop& loop = forest.m_loops[id];
+        loop.depth = loop.parent == NoLoop ? 1 : forest.m_loops[loop.parent].depth + 1;
+    }
+    for (Number x = 0; x < count; ++x) {
+        if (loopOfHeader[x] != NoLoop) {
+            forest.m_innermost[vertex[x]] = loopOfHeader[x];
+        } else if (header[x] != None) {
+            forest.m_innermost[vertex[x]] = loopOfHeader[header[x]];
+        }
+    }
+
+    // Bodies: each node belongs to its innermost loop and all its ancestors.
+    const size_t loopCount = forest.m_loops.size();
+    forest.m_bodyOffsets.assign(loopCount + 1, 0);
+    for (Index n = 0; n < nodeCount; ++n) {
+        for (uint32_t l = forest.m_innermost[n]; l != NoLoop; l = forest.m_loops[l].parent) {
+            ++forest.m_bodyOffsets[l + 1];
+        }
+    }
+    for (size_t l = 0; l < loopCount; ++l) {
+        forest.m_bodyOffsets[l + 1] += forest.m_bodyOffsets[l];
+    }
+    forest.m_bodies.resize(forest.m_bodyOffsets[loopCount]);
+    {
+        std::vector<uint32_t> cursor(forest.m_bodyOffsets.begin(), forest.m_bodyOffsets.end() - 1);
+        for (Index n = 0; n < nodeCount; ++n) {
+            for (uint32_t l = forest.m_innermost[n]; l != NoLoop; l = forest.m_loops[l].parent) {
+                forest.m_bodies[cursor[l]++] = n;
+            }
+        }
+    }
+
+    // Exits: an edge u -> v leaves every loop that contains u but not v.
+    std::vector<std::pair<uint32_t, uint32_t>> exits;  // (loop, edge)
+    for (Index u = 0; u < nodeCount; ++u) {
+        for (uint32_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); ++e) {
+            Index v = graph.edgeTarget(e);
+            for (uint32_t l = forest.m_innermost[u]; l != NoLoop && !forest.contains(l, v); l = forest.m_loops[l].parent) {
+                exits.push_back({l, e});
+            }
+        }
+    }
+    std::stable_sort(exits.begin(), exits.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    forest.m_exitOffsets.assign(loopCount + 1, 0);
+    forest.m_exits.reserve(exits.size());
+    for (const auto& [loopId, edge] : exits) {
+        ++forest.m_exitOffsets[loopId + 1];
+        forest.m_exits.push_back(edge);
+    }
+    for (size_t l = 0; l < loopCount; ++l) {
+        forest.m_exitOffsets[l + 1] += forest.m_exitOffsets[l];
+    }
+
+    return forest;
+}
+
+bool LoopForest::contains(uint32_t loopId, Index n) const {
+    const uint32_t depth = m_loops[loopId].depth;
+    uint32_t l = m_innermost[n];
+    while (l != NoLoop && m_loops[l].depth > depth) {
+        l = m_loops[l].parent;
+    }
+    return l == loopId;
+}
+
+std::vector<LoopForest> buildLoopForestsBatch(
+    llvm::ArrayRef<std::shared_ptr<const CSRGraph>> graphs, unsigned threads) {
+    std::vector<LoopForest> results(graphs.size());
+    parallelFor(graphs.size(), [&](size_t i) {
+        if (graphs[i]) results[i] = LoopForest::build(*graphs[i]);
+    }, threads);
+    return results;
+}
+
+} // namespace GraphGenerator
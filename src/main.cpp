@@ -1,17 +1,114 @@
 #include "mainwindow.h"
+#include "cfg_analyzer.h"
 #include <QApplication>
 #include <QMessageBox>
 #include <iostream>
 #include <QApplication>
 #include <QSurfaceFormat>
 
+namespace {
+
+void printResult(const CFGAnalyzer::AnalysisResult& result)
+{
+    (result.success ? std::cout : std::cerr) << result.report;
+}
+
+// Batch modes print the analyzer's report and exit without a window:
+//   CFGParser --diff <before dir> <after dir>
+//       compares two earlier runs' output directories and writes a
+//       <function>_diff.dot into the second for each changed function.
+//   CFGParser --clones [--min-similarity <0..1>] <file>...
+//       analyzes the files and lists groups of near-duplicate functions.
+//   CFGParser --dead-code [--root <pattern>]... [--whole-program] <file>
+//       analyzes the file and reports, among the rest, the functions no
+//       root reaches. --root adds a name pattern to the default roots;
+//       --whole-program stops treating external functions as roots.
+// Returns the exit status, or -1 when no batch mode is asked for.
+int runBatchMode(const QStringList& args)
+{
+    if (args.size() < 2) return -1;
+    const QString mode = args[1];
+    if (mode == "--diff") {
+        if (args.size() != 4) {
+            std::cerr << "usage: CFGParser --diff <before dir> <after dir>\n";
+            return 2;
+        }
+        CFGAnalyzer::CFGAnalyzer analyzer;
+        const CFGAnalyzer::AnalysisResult result = analyzer.compareRuns(args[2].toStdString(), args[3].toStdString());
+        printResult(result);
+        return result.success ? 0 : 1;
+    }
+    if (mode == "--clones") {
+        GraphGenerator::CloneDetectionOptions options;
+        std::vector<std::string> files;
+        for (int i = 2; i < args.size(); ++i) {
+            if (args[i] == "--min-similarity" && i + 1 < args.size()) {
+                bool ok = false;
+                options.minSimilarity = args[++i].toDouble(&ok);
+                if (!ok || options.minSimilarity < 0 || options.minSimilarity > 1) {
+                    std::cerr << "--min-similarity takes a number between 0 and 1\n";
+                    return 2;
+                }
+            } else {
+                files.push_back(args[i].toStdString());
+            }
+        }
+        if (files.empty()) {
+            std::cerr << "usage: CFGParser --clones [--min-similarity <0..1>] <file>...\n";
+            return 2;
+        }
+        CFGAnalyzer::CFGAnalyzer analyzer;
+        const CFGAnalyzer::AnalysisResult result = analyzer.findClones(files, options);
+        printResult(result);
+        return result.success ? 0 : 1;
+    }
+    if (mode == "--dead-code") {
+        GraphGenerator::CallGraphRoots roots;
+        std::vector<std::string> files;
+        for (int i = 2; i < args.size(); ++i) {
+            if (args[i] == "--root" && i + 1 < args.size()) {
+                roots.patterns.push_back(args[++i].toStdString());
+            } else if (args[i] == "--whole-program") {
+                roots.exported = false;
+            } else {
+                files.push_back(args[i].toStdString());
+            }
+        }
+        if (files.size() != 1) {
+            std::cerr << "usage: CFGParser --dead-code [--root <pattern>]... [--whole-program] <file>\n";
+            return 2;
+        }
+        CFGAnalyzer::CFGAnalyzer analyzer;
+        analyzer.setCallGraphRoots(std::move(roots));
+        const CFGAnalyzer::AnalysisResult result = analyzer.analyze(files[0]);
+        printResult(result);
+        return result.success ? 0 : 1;
+    }
+    return -1;
+}
+
+} // namespace
+
 int main(int argc, char *argv[])
 {
+    QStringList args;
+    for (int i = 0; i < argc; ++i) {
+        args << QString::fromLocal8Bit(argv[i]);
+    }
+    if (const int status = runBatchMode(args); status >= 0) {
+        return status;
+    }
+
     QApplication app(argc, argv);
     
     try {
         MainWindow window;
         window.show();
+        // CFGParser [cfg_corpus.bin [function]] opens a corpus right away.
+        const QStringList args = app.arguments();
+        if (args.size() > 1 && args[1].endsWith(".bin")) {
+            window.openCorpus(args[1], args.size() > 2 ? args[2] : QString());
+        }
         return app.exec();
     } catch (const std::exception& e) {
         qCritical() << "Fatal error:" << e.what();
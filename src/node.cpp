@@ -1,29 +1,26 @@
 #include "node.h"
-#include <algorithm>
-#include <sstream>
-#include <iomanip>
+#include <cstdio>
 
-size_t CFGNode::s_nodeCounter = 0;
-
-CFGNode::CFGNode(const std::string& content, NodeType type)
-    : m_content(content), m_type(type)
-{
-    // Generate a unique identifier
-    std::ostringstream oss;
-    oss << "node_" << std::setw(4) << std::setfill('0') << s_nodeCounter++;
-    m_uniqueId = oss.str();
+CFGNodeGraph::NodeId CFGNodeGraph::addNode(const std::string& content, NodeType type) {
+    m_nodes.push_back(Node{content, type, {}, {}});
+    return static_cast<NodeId>(m_nodes.size() - 1);
 }
 
-std::string CFGNode::getContent() const {
-    return m_content;
+bool CFGNodeGraph::addEdge(NodeId from, NodeId to) {
+    if (!m_edges.insert(edgeKey(from, to)).second) {
+        return false;
+    }
+    m_nodes[from].successors.push_back(to);
+    m_nodes[to].predecessors.push_back(from);
+    return true;
 }
 
-CFGNode::NodeType CFGNode::getType() const {
-    return m_type;
+bool CFGNodeGraph::hasEdge(NodeId from, NodeId to) const {
+    return m_edges.contains(edgeKey(from, to));
 }
 
-std::string CFGNode::getTypeString() const {
-    switch(m_type) {
+std::string CFGNodeGraph::getTypeString(NodeId node) const {
+    switch(m_nodes[node].type) {
         case ENTRY: return "Entry";
         case EXIT: return "Exit";
         case BASIC_BLOCK: return "Basic Block";
@@ -33,28 +30,8 @@ std::string CFGNode::getTypeString() const {
     }
 }
 
-void CFGNode::addSuccessor(std::shared_ptr<CFGNode> node) {
-    // Prevent duplicate successors
-    if (std::find(m_successors.begin(), m_successors.end(), node) == m_successors.end()) {
-        m_successors.push_back(node);
-    }
-}
-
-void CFGNode::addPredecessor(std::shared_ptr<CFGNode> node) {
-    // Prevent duplicate predecessors
-    if (std::find(m_predecessors.begin(), m_predecessors.end(), node) == m_predecessors.end()) {
-        m_predecessors.push_back(node);
-    }
-}
-
-std::vector<std::shared_ptr<CFGNode>> CFGNode::getSuccessors() const {
-    return m_successors;
-}
-
-std::vector<std::shared_ptr<CFGNode>> CFGNode::getPredecessors() const {
-    return m_predecessors;
-}
-
-std::string CFGNode::getUniqueId() const {
-    return m_uniqueId;
+std::string CFGNodeGraph::getUniqueId(NodeId node) const {
+    char id[16];
+    std::snprintf(id, sizeof(id), "node_%04u", static_cast<unsigned>(node));
+    return id;
 }
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "path_analysis.h"
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+namespace GraphGenerator {
+
+BigUInt::BigUInt(uint64_t value) {
+    while (value) {
+        m_limbs.push_back(static_cast<uint32_t>(value));
+        value >>= 32;
+    }
+}
+
+BigUInt& BigUInt::operator+=(const BigUInt& other) {
+    if (other.m_limbs.size() > m_limbs.size()) {
+        m_limbs.resize(other.m_limbs.size(), 0);
+    }
+    uint64_t carry = 0;
+    for (size_t i = 0; i < m_limbs.size(); ++i) {
+        const uint64_t sum = uint64_t(m_limbs[i]) + (i < other.m_limbs.size() ? other.m_limbs[i] : 0) + carry;
+        m_limbs[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+        if (!carry && i >= other.m_limbs.size()) break;
+    }
+    if (carry) {
+        m_limbs.push_back(static_cast<uint32_t>(carry));
+    }
+    return *this;
+}
+
+uint64_t BigUInt::toUInt64() const {
+    if (!fitsUInt64()) return std::numeric_limits<uint64_t>::max();
+    uint64_t value = 0;
+    for (size_t i = m_limbs.size(); i-- > 0;) {
+        value = (value << 32) | m_limbs[i];
+    }
+    return value;
+}
+
+std::string BigUInt::toString() const {
+    if (m_limbs.empty()) return "0";
+
+    // Repeated division by 10^9 yields nine decimal digits per step.
+    std::vector<uint32_t> limbs = m_limbs;
+    std::vector<uint32_t> chunks;
+    while (!limbs.empty()) {
+        uint64_t remainder = 0;
+        for (size_t i = limbs.size(); i-- > 0;) {
+            const uint64_t current = (remainder << 32) | limbs[i];
+            limbs[i] = static_cast<uint32_t>(current / 1000000000u);
+            remainder = current % 1000000000u;
+        }
+        chunks.push_back(static_cast<uint32_t>(remainder));
+        while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+    }
+
+    std::string text = std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        const std::string digits = std::to_string(chunks[i]);
+        text.append(9 - digits.size(), '0');
+        text += digits;
+    }
+    return text;
+}
+
+namespace {
+
+// Topological order of the graph without its back edges (Kahn's algorithm).
+std::vector<CSRGraph::Index> acyclicOrder(const CSRGraph& graph, const LoopForest& loops) {
+    using Index = CSRGraph::Index;
+    std::vector<uint32_t> inDegree(graph.nodeCount(), 0);
+    for (uint32_t e = 0; e < graph.edgeCount(); ++e) {
+        if (!loops.isBackEdge(e)) ++inDegree[graph.edgeTarget(e)];
+    }
+    std::vector<Index> order;
+    order.reserve(graph.nodeCount());
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        if (inDegree[n] == 0) order.push_back(n);
+    }
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Index n = order[i];
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            if (!loops.isBackEdge(e) && --inDegree[graph.edgeTarget(e)] == 0) {
+                order.push_back(graph.edgeTarget(e));
+            }
+        }
+    }
+    return order;
+}
+
+bool isSink(const CSRGraph& graph, const LoopForest& loops, CSRGraph::Index n) {
+    for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+        if (!loops.isBackEdge(e)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+PathCount countPaths(const CSRGraph& graph, const LoopForest& loops) {
+    PathCount result;
+    if (graph.empty() || graph.entry() == CSRGraph::InvalidIndex) return result;
+
+    const std::vector<CSRGraph::Index> order = acyclicOrder(graph, loops);
+    constexpr uint64_t Saturated = std::numeric_limits<uint64_t>::max();
+
+    // Paths from each node to a sink, sinks first.
+    std::vector<uint64_t> counts(graph.nodeCount(), 0);
+    bool saturated = false;
+    for (size_t i = order.size(); i-- > 0;) {
+        const CSRGraph::Index n = order[i];
+        uint64_t count = isSink(graph, loops, n) ? 1 : 0;
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            if (loops.isBackEdge(e)) continue;
+            const uint64_t add = counts[graph.edgeTarget(e)];
+            count = add > Saturated - count ? Saturated : count + add;
+        }
+        saturated |= count == Saturated;
+        counts[n] = count;
+    }
+    result.saturated = counts[graph.entry()];
+    if (!saturated) {
+        result.exact = BigUInt(result.saturated);
+        return result;
+    }
+
+    std::vector<BigUInt> exact(graph.nodeCount());
+    for (size_t i = order.size(); i-- > 0;) {
+        const CSRGraph::Index n = order[i];
+        BigUInt& count = exact[n];
+        if (isSink(graph, loops, n)) count = BigUInt(1);
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            if (!loops.isBackEdge(e)) count += exact[graph.edgeTarget(e)];
+        }
+    }
+    result.exact = exact[graph.entry()];
+    result.saturated = result.exact.toUInt64();
+    return result;
+}
+
+std::vector<WeightedPath> topKPaths(const CSRGraph& graph, const LoopForest& loops,
+                                    size_t k, NodeWeight weight) {
+    using Index = CSRGraph::Index;
+    std::vector<WeightedPath> paths;
+    if (graph.empty() || graph.entry() == CSRGraph::InvalidIndex || k == 0) return paths;
+
+    // One of a node's k best suffixes: its weight and where it continues.
+    struct Suffix {
+        double weight;
+        Index next;     // InvalidIndex at a sink
+        uint32_t rank;  // position in next's list
+    };
+    std::vector<std::vector<Suffix>> best(graph.nodeCount());
+
+    // Successor lists are sorted, so a k-way merge with a heap over the
+    // heads takes the k best without looking at the rest.
+    struct Head {
+        double weight;
+        Index next;
+        uint32_t rank;
+        bool operator<(const Head& other) const {
+            return weight != other.weight ? weight < other.weight : next > other.next;
+        }
+    };
+    const std::vector<Index> order = acyclicOrder(graph, loops);
+    std::priority_queue<Head> heads;
+    for (size_t i = order.size(); i-- > 0;) {
+        const Index n = order[i];
+        const double own = weight ? weight(n) : 1.0;
+        std::vector<Suffix>& list = best[n];
+        if (isSink(graph, loops, n)) {
+            list.push_back({own, CSRGraph::InvalidIndex, 0});
+            continue;
+        }
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            const Index succ = graph.edgeTarget(e);
+            if (!loops.isBackEdge(e) && !best[succ].empty()) {
+                heads.push({best[succ][0].weight, succ, 0});
+            }
+        }
+        while (!heads.empty() && list.size() < k) {
+            const Head head = heads.top();
+            heads.pop();
+            list.push_back({own + head.weight, head.next, head.rank});
+            if (head.rank + 1 < best[head.next].size()) {
+                heads.push({best[head.next][head.rank + 1].weight, head.next, head.rank + 1});
+            }
+        }
+        heads = {};
+    }
+
+    for (uint32_t rank = 0; rank < best[graph.entry()].size(); ++rank) {
+        WeightedPath path;
+        path.weight = best[graph.entry()][rank].weight;
+        Index node = graph.entry();
+        uint32_t position = rank;
+        while (node != CSRGraph::InvalidIndex) {
+            path.nodes.push_back(node);
+            const Suffix& suffix = best[node][position];
+            node = suffix.next;
+            position = suffix.rank;
+        }
+        paths.push_back(std::move(path));
+    }
+    return paths;
+}
+
+std::vector<int> pathBlockIds(const CSRGraph& graph, const WeightedPath& path) {
+    std::vector<int> ids;
+    ids.reserve(path.nodes.size());
+    for (CSRGraph::Index n : path.nodes) {
+        ids.push_back(graph.blockId(n));
+    }
+    return ids;
+}
+
+PathSummary summarizePaths(const CSRGraph& graph, const LoopForest& loops, size_t k, NodeWeight weight) {
+    PathSummary summary;
+    summary.count = countPaths(graph, loops).exact.toString();
+    for (const WeightedPath& path : topKPaths(graph, loops, k, weight)) {
+        summary.heaviest.push_back(pathBlockIds(graph, path));
+    }
+    return summary;
+}
+
+} // namespace GraphGenerator
@@ -0,0 +1,435 @@
+#include "profile_plan.h"
+#include "block_frequency.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace GraphGenerator {
+
+namespace {
+
+using Index = CSRGraph::Index;
+constexpr uint32_t None = ~uint32_t(0);
+constexpr double Forced = std::numeric_limits<double>::infinity();   // must be a tree edge
+constexpr double Free = -1.0;   // costs nothing as a chord, so a tree edge only if needed
+constexpr double Excluded = -std::numeric_limits<double>::infinity();   // not in the graph at all
+constexpr uint64_t MaxPaths = uint64_t(1) << 62;
+
+struct Candidate {
+    Index from;
+    Index to;
+    double weight;
+};
+
+// Kruskal over the candidates, heaviest first (ties by position); true for
+// those in the maximum spanning forest.
+std::vector<char> maximumSpanningForest(size_t nodeCount, const std::vector<Candidate>& edges) {
+    std::vector<uint32_t> order(edges.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return edges[a].weight > edges[b].weight; });
+    std::vector<uint32_t> parent(nodeCount);
+    std::iota(parent.begin(), parent.end(), 0);
+    std::vector<uint32_t> size(nodeCount, 1);
+    auto find = [&](uint32_t x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    };
+    std::vector<char> inTree(edges.size(), 0);
+    for (uint32_t e : order) {
+        uint32_t a = find(edges[e].from), b = find(edges[e].to);
+        if (a == b) continue;
+        if (size[a] < size[b]) std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+        inTree[e] = 1;
+    }
+    return inTree;
+}
+
+// Tree edges as an undirected adjacency list: offsets per node, then
+// candidate indices.
+void treeAdjacency(size_t nodeCount, const std::vector<Candidate>& edges, const std::vector<char>& inTree,
+                   std::vector<uint32_t>& offsets, std::vector<uint32_t>& adjacent) {
+    offsets.assign(nodeCount + 1, 0);
+    for (uint32_t e = 0; e < edges.size(); ++e) {
+        if (!inTree[e]) continue;
+        ++offsets[edges[e].from + 1];
+        ++offsets[edges[e].to + 1];
+    }
+    for (size_t n = 0; n < nodeCount; ++n) offsets[n + 1] += offsets[n];
+    adjacent.resize(offsets.back());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t e = 0; e < edges.size(); ++e) {
+        if (!inTree[e]) continue;
+        adjacent[fill[edges[e].from]++] = e;
+        adjacent[fill[edges[e].to]++] = e;
+    }
+}
+
+std::vector<char> reachableFromEntry(const CSRGraph& graph) {
+    std::vector<char> reached(graph.nodeCount(), 0);
+    if (graph.entry() == CSRGraph::InvalidIndex) return reached;
+    std::vector<Index> stack{graph.entry()};
+    reached[graph.entry()] = 1;
+    while (!stack.empty()) {
+        const Index n = stack.back();
+        stack.pop_back();
+        for (Index succ : graph.successors(n)) {
+            if (!reached[succ]) {
+                reached[succ] = 1;
+                stack.push_back(succ);
+            }
+        }
+    }
+    return reached;
+}
+
+std::vector<Index> edgeSources(const CSRGraph& graph) {
+    std::vector<Index> sources(graph.edgeCount());
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        std::fill(sources.begin() + graph.edgeBegin(n), sources.begin() + graph.edgeEnd(n), n);
+    }
+    return sources;
+}
+
+} // namespace
+
+std::vector<double> estimateEdgeWeights(const CSRGraph& graph, const LoopForest& loops) {
+    std::vector<double> weights(graph.edgeCount());
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        if (graph.outDegree(n) == 0) continue;
+        const double weight = std::pow(LoopWeight, loops.loopDepth(n)) / graph.outDegree(n);
+        std::fill(weights.begin() + graph.edgeBegin(n), weights.begin() + graph.edgeEnd(n), weight);
+    }
+    return weights;
+}
+
+EdgeProfilePlan planEdgeProfile(const CSRGraph& graph, llvm::ArrayRef<double> edgeWeights) {
+    EdgeProfilePlan plan;
+    if (graph.entry() == CSRGraph::InvalidIndex) return plan;
+    std::vector<double> estimated;
+    if (edgeWeights.empty()) {
+        estimated = estimateEdgeWeights(graph, LoopForest::build(graph));
+        edgeWeights = estimated;
+    }
+
+    // Candidates: the CSR edges under their own IDs, then the virtual
+    // edges. Unreachable edges go last, so they only join unreachable
+    // blocks to the tree and can be dropped from it afterwards.
+    const std::vector<char> reached = reachableFromEntry(graph);
+    const uint32_t edgeCount = static_cast<uint32_t>(graph.edgeCount());
+    std::vector<Candidate> candidates(edgeCount);
+    std::vector<char> counted(edgeCount, 0);
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            candidates[e] = {n, graph.edgeTarget(e), reached[n] ? edgeWeights[e] : Excluded};
+            counted[e] = reached[n];
+        }
+        if (reached[n] && graph.outDegree(n) == 0 && n != graph.entry()) {
+            plan.virtualSources.push_back(n);
+            candidates.push_back({n, graph.entry(), Forced});
+        }
+    }
+    std::vector<char> inTree = maximumSpanningForest(graph.nodeCount(), candidates);
+    for (uint32_t e = 0; e < edgeCount; ++e) {
+        if (!counted[e]) {
+            inTree[e] = 0;
+        } else if (!inTree[e]) {
+            plan.counters.push_back(e);
+        }
+    }
+
+    // Tree edges solve leaves first: by the time a block is left, every
+    // other edge at it is a counter or was solved in its subtree.
+    std::vector<uint32_t> offsets, adjacent;
+    treeAdjacency(graph.nodeCount(), candidates, inTree, offsets, adjacent);
+    std::vector<uint32_t> parentEdge(graph.nodeCount(), None);
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    std::vector<char> visited(graph.nodeCount(), 0);
+    std::vector<Index> stack{graph.entry()};
+    visited[graph.entry()] = 1;
+    while (!stack.empty()) {
+        const Index n = stack.back();
+        if (cursor[n] == offsets[n + 1]) {
+            stack.pop_back();
+            if (parentEdge[n] != None) plan.derived.emplace_back(parentEdge[n], n);
+            continue;
+        }
+        const uint32_t e = adjacent[cursor[n]++];
+        const Index other = candidates[e].from == n ? candidates[e].to : candidates[e].from;
+        if (visited[other]) continue;
+        visited[other] = 1;
+        parentEdge[other] = e;
+        stack.push_back(other);
+    }
+    return plan;
+}
+
+std::vector<uint64_t> reconstructEdgeCounts(const CSRGraph& graph, const EdgeProfilePlan& plan,
+                                            llvm::ArrayRef<uint64_t> counterValues) {
+    const uint32_t edgeCount = static_cast<uint32_t>(graph.edgeCount());
+    std::vector<int64_t> counts(edgeCount + plan.virtualSources.size(), 0);
+    for (size_t i = 0; i < plan.counters.size() && i < counterValues.size(); ++i) {
+        counts[plan.counters[i]] = static_cast<int64_t>(counterValues[i]);
+    }
+    std::vector<uint32_t> virtualOf(graph.nodeCount(), None);
+    for (uint32_t i = 0; i < plan.virtualSources.size(); ++i) virtualOf[plan.virtualSources[i]] = edgeCount + i;
+
+    for (const auto& [edge, n] : plan.derived) {
+        // Flow into n minus flow out of it, leaving out the edge solved.
+        int64_t balance = 0;
+        for (uint32_t e : graph.predecessorEdges(n)) balance += e == edge ? 0 : counts[e];
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) balance -= e == edge ? 0 : counts[e];
+        if (virtualOf[n] != None && virtualOf[n] != edge) balance -= counts[virtualOf[n]];
+        if (n == graph.entry()) {
+            for (uint32_t i = 0; i < plan.virtualSources.size(); ++i) {
+                if (edgeCount + i != edge) balance += counts[edgeCount + i];
+            }
+        }
+        const bool leaves = edge < edgeCount ? edge >= graph.edgeBegin(n) && edge < graph.edgeEnd(n)
+                                             : plan.virtualSources[edge - edgeCount] == n;
+        counts[edge] = std::max<int64_t>(0, leaves ? balance : -balance);
+    }
+    return std::vector<uint64_t>(counts.begin(), counts.begin() + edgeCount);
+}
+
+PathProfilePlan planPathProfile(const CSRGraph& graph, const LoopForest& loops, llvm::ArrayRef<double> edgeWeights) {
+    PathProfilePlan plan;
+    const Index entry = graph.entry();
+    if (entry == CSRGraph::InvalidIndex) return plan;
+    std::vector<double> estimated;
+    if (edgeWeights.empty()) {
+        estimated = estimateEdgeWeights(graph, loops);
+        edgeWeights = estimated;
+    }
+    const std::vector<char> reached = reachableFromEntry(graph);
+    const std::vector<Index> sources = edgeSources(graph);
+    const size_t nodeCount = graph.nodeCount();
+
+    // The path graph: the graph without back edges, each back edge u -> h
+    // replaced by dummies entry -> h and u -> T, and every block without
+    // remaining successors joined to T, the end of all paths.
+    std::vector<uint32_t> loopEdgeOf(graph.edgeCount(), None);
+    for (uint32_t e = 0; e < graph.edgeCount(); ++e) {
+        if (reached[sources[e]] && loops.isBackEdge(e)) {
+            loopEdgeOf[e] = static_cast<uint32_t>(plan.loopEdges.size());
+            plan.loopEdges.push_back({e, 0, 0, 0, 0});
+        }
+    }
+
+    // Topological order over the forward edges, then path counts and edge
+    // values from the sinks up: an edge's value is the number of paths
+    // through the successors listed before it.
+    std::vector<uint32_t> inDegree(nodeCount, 0);
+    for (uint32_t e = 0; e < graph.edgeCount(); ++e) {
+        if (reached[sources[e]] && !loops.isBackEdge(e)) ++inDegree[graph.edgeTarget(e)];
+    }
+    std::vector<Index> order{entry};
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (uint32_t e = graph.edgeBegin(order[i]); e < graph.edgeEnd(order[i]); ++e) {
+            if (!loops.isBackEdge(e) && --inDegree[graph.edgeTarget(e)] == 0) order.push_back(graph.edgeTarget(e));
+        }
+    }
+    plan.edgeValues.assign(graph.edgeCount(), 0);
+    std::vector<uint64_t> paths(nodeCount, 0);
+    auto add = [&](uint64_t& total, uint64_t more) {
+        total += more;
+        if (total > MaxPaths) plan.overflow = true;
+        total = std::min(total, MaxPaths + 1);
+    };
+    for (size_t i = order.size(); i-- > 0;) {
+        const Index n = order[i];
+        uint64_t total = 0;
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            if (loops.isBackEdge(e)) continue;
+            plan.edgeValues[e] = total;
+            add(total, paths[graph.edgeTarget(e)]);
+        }
+        // Paths ending in any of a block's back edges are one path.
+        bool endsLoop = false;
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            if (!loops.isBackEdge(e)) continue;
+            plan.loopEdges[loopEdgeOf[e]].endValue = total;
+            endsLoop = true;
+        }
+        if (endsLoop) add(total, 1);
+        if (n == entry) {
+            // One restart per loop header, shared by its back edges; a
+            // loop at the entry restarts like a new call, from r = 0.
+            std::unordered_map<Index, uint64_t> startValues;
+            for (PathProfilePlan::LoopEdge& loop : plan.loopEdges) {
+                const Index header = graph.edgeTarget(loop.edge);
+                if (header == entry) continue;
+                auto [it, inserted] = startValues.emplace(header, total);
+                loop.startValue = it->second;
+                if (inserted) add(total, paths[header]);
+            }
+        }
+        if (graph.outDegree(n) == 0) add(total, 1);
+        paths[n] = total;
+    }
+    plan.pathCount = std::min(paths[entry], MaxPaths);
+    if (plan.overflow) return plan;
+
+    // Spanning tree over the path graph plus T -> entry. Path values of
+    // the candidates: forward edges keep their CSR IDs, then come the
+    // start and end dummies per loop edge, the sink edges, and T -> entry.
+    const Index end = static_cast<Index>(nodeCount);
+    const uint32_t edgeCount = static_cast<uint32_t>(graph.edgeCount());
+    std::vector<Candidate> candidates(edgeCount);
+    std::vector<uint64_t> values(edgeCount);
+    std::vector<char> forward(edgeCount, 0);
+    for (uint32_t e = 0; e < edgeCount; ++e) {
+        forward[e] = reached[sources[e]] && !loops.isBackEdge(e);
+        candidates[e] = {sources[e], graph.edgeTarget(e), forward[e] ? edgeWeights[e] : Excluded};
+        values[e] = plan.edgeValues[e];
+    }
+    const uint32_t firstDummy = edgeCount;
+    for (const PathProfilePlan::LoopEdge& loop : plan.loopEdges) {
+        candidates.push_back({entry, graph.edgeTarget(loop.edge), Free});
+        values.push_back(loop.startValue);
+        candidates.push_back({sources[loop.edge], end, Free});
+        values.push_back(loop.endValue);
+    }
+    const uint32_t firstSink = static_cast<uint32_t>(candidates.size());
+    std::vector<Index> sinks;
+    for (Index n : order) {
+        if (graph.outDegree(n) != 0) continue;
+        sinks.push_back(n);
+        candidates.push_back({n, end, Free});
+        values.push_back(0);
+    }
+    candidates.push_back({end, entry, Forced});
+    values.push_back(0);
+    std::vector<char> inTree = maximumSpanningForest(nodeCount + 1, candidates);
+    for (uint32_t e = 0; e < edgeCount; ++e) {
+        if (!forward[e]) inTree[e] = 0;
+    }
+
+    // Potentials making every tree edge's increment zero; a chord u -> v
+    // then adds value + phi(u) - phi(v). Summed along a path the
+    // potentials cancel, as phi(entry) = phi(T).
+    std::vector<uint32_t> offsets, adjacent;
+    treeAdjacency(nodeCount + 1, candidates, inTree, offsets, adjacent);
+    std::vector<int64_t> phi(nodeCount + 1, 0);
+    std::vector<char> visited(nodeCount + 1, 0);
+    std::vector<Index> stack{end};
+    visited[end] = 1;
+    while (!stack.empty()) {
+        const Index n = stack.back();
+        stack.pop_back();
+        for (uint32_t i = offsets[n]; i < offsets[n + 1]; ++i) {
+            const Candidate& c = candidates[adjacent[i]];
+            const int64_t value = static_cast<int64_t>(values[adjacent[i]]);
+            const Index other = c.from == n ? c.to : c.from;
+            if (visited[other]) continue;
+            visited[other] = 1;
+            phi[other] = c.from == n ? phi[n] + value : phi[n] - value;
+            stack.push_back(other);
+        }
+    }
+    auto increment = [&](uint32_t c) {
+        return inTree[c] ? 0 : static_cast<int64_t>(values[c]) + phi[candidates[c].from] - phi[candidates[c].to];
+    };
+    for (uint32_t e = 0; e < edgeCount; ++e) {
+        if (forward[e] && increment(e) != 0) plan.increments.emplace_back(e, increment(e));
+    }
+    for (uint32_t i = 0; i < plan.loopEdges.size(); ++i) {
+        plan.loopEdges[i].restart = increment(firstDummy + 2 * i);
+        plan.loopEdges[i].endIncrement = increment(firstDummy + 2 * i + 1);
+    }
+    for (uint32_t i = 0; i < sinks.size(); ++i) {
+        plan.pathEnds.emplace_back(sinks[i], increment(firstSink + i));
+    }
+    std::sort(plan.pathEnds.begin(), plan.pathEnds.end());
+    return plan;
+}
+
+std::vector<CSRGraph::Index> decodePath(const CSRGraph& graph, const LoopForest& loops,
+                                        const PathProfilePlan& plan, uint64_t pathId) {
+    std::vector<Index> path;
+    if (plan.overflow || pathId >= plan.pathCount) return path;
+    std::vector<uint32_t> loopEdgeOf(graph.edgeCount(), None);
+    for (uint32_t i = 0; i < plan.loopEdges.size(); ++i) loopEdgeOf[plan.loopEdges[i].edge] = i;
+
+    // At each block take the last way on whose value the rest of the ID
+    // does not fall short: forward edges, then back edges, then (at the
+    // entry) the loop restarts.
+    Index n = graph.entry();
+    uint64_t rest = pathId;
+    while (true) {
+        path.push_back(n);
+        uint32_t chosen = None;
+        uint64_t chosenValue = 0;
+        enum { Forward, Back, Restart } kind = Forward;
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            const bool back = loops.isBackEdge(e);
+            const uint64_t value = back ? plan.loopEdges[loopEdgeOf[e]].endValue : plan.edgeValues[e];
+            if (value <= rest && (chosen == None || value >= chosenValue)) {
+                chosen = e;
+                chosenValue = value;
+                kind = back ? Back : Forward;
+            }
+        }
+        if (n == graph.entry() && path.size() == 1) {
+            for (uint32_t i = 0; i < plan.loopEdges.size(); ++i) {
+                if (graph.edgeTarget(plan.loopEdges[i].edge) == n) continue;
+                if (plan.loopEdges[i].startValue <= rest && (chosen == None || plan.loopEdges[i].startValue >= chosenValue)) {
+                    chosen = i;
+                    chosenValue = plan.loopEdges[i].startValue;
+                    kind = Restart;
+                }
+            }
+        }
+        if (chosen == None) break;   // the path ends at a block without successors
+        rest -= chosenValue;
+        if (kind == Back) break;
+        if (kind == Restart) {
+            path.clear();
+            n = graph.edgeTarget(plan.loopEdges[chosen].edge);
+        } else {
+            n = graph.edgeTarget(chosen);
+        }
+    }
+    return path;
+}
+
+InstrumentationPlan planInstrumentation(const CSRGraph& graph, const LoopForest& loops,
+                                        llvm::ArrayRef<double> edgeWeights) {
+    InstrumentationPlan result;
+    if (graph.entry() == CSRGraph::InvalidIndex) return result;
+    std::vector<double> estimated;
+    if (edgeWeights.empty()) {
+        const std::vector<double> probabilities = estimateBranchProbabilities(graph, loops);
+        estimated = edgeFrequencies(graph, estimateBlockFrequencies(graph, loops, probabilities), probabilities);
+        edgeWeights = estimated;
+    }
+    const std::vector<Index> sources = edgeSources(graph);
+    auto blocks = [&](uint32_t e) { return std::make_pair(graph.blockId(sources[e]), graph.blockId(graph.edgeTarget(e))); };
+
+    const EdgeProfilePlan edges = planEdgeProfile(graph, edgeWeights);
+    result.edges = static_cast<uint32_t>(edges.counters.size() + edges.derived.size() - edges.virtualSources.size());
+    for (uint32_t e : edges.counters) result.counters.push_back(blocks(e));
+
+    const PathProfilePlan paths = planPathProfile(graph, loops, edgeWeights);
+    if (paths.overflow) return result;
+    result.paths = paths.pathCount;
+    for (const auto& [e, amount] : paths.increments) {
+        result.pathIncrements.emplace_back(blocks(e).first, blocks(e).second, amount);
+    }
+    for (const PathProfilePlan::LoopEdge& loop : paths.loopEdges) {
+        result.loopEdges.emplace_back(blocks(loop.edge).first, blocks(loop.edge).second, loop.endIncrement, loop.restart);
+    }
+    for (const auto& [n, amount] : paths.pathEnds) {
+        result.pathEnds.emplace_back(graph.blockId(n), amount);
+    }
+    return result;
+}
+
+} // namespace GraphGenerator
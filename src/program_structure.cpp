@@ -0,0 +1,379 @@
+#include "program_structure.h"
+#include <algorithm>
+#include <limits>
+
+namespace GraphGenerator {
+
+namespace {
+
+constexpr uint32_t None = ~uint32_t(0);
+
+// Undirected view of the CFG plus the exit -> entry edge, whose ID is the
+// CSR edge count. Neighbours of n are its out edges, then its in edges,
+// then the added edge at the entry and exit.
+struct UndirectedView {
+    const CSRGraph& graph;
+    uint32_t addedEdge;   // None when the entry or exit is missing
+    uint32_t degree(CSRGraph::Index n) const {
+        const bool added = addedEdge != None && (n == graph.entry() || n == graph.exit());
+        return static_cast<uint32_t>(graph.outDegree(n) + graph.inDegree(n)) + (added ? 1 : 0);
+    }
+    // (edge, other end) of n's k-th neighbour.
+    std::pair<uint32_t, CSRGraph::Index> neighbour(CSRGraph::Index n, uint32_t k) const {
+        const uint32_t out = static_cast<uint32_t>(graph.outDegree(n));
+        if (k < out) return {graph.edgeBegin(n) + k, graph.edgeTarget(graph.edgeBegin(n) + k)};
+        k -= out;
+        if (k < graph.inDegree(n)) return {graph.predecessorEdges(n)[k], graph.predecessors(n)[k]};
+        return {addedEdge, n == graph.exit() ? graph.entry() : graph.exit()};
+    }
+};
+
+// Bracket lists of the cycle-equivalence algorithm: intrusive doubly
+// linked lists over bracket IDs, with O(1) push, delete and concatenation.
+struct BracketLists {
+    struct List {
+        uint32_t head = None;
+        uint32_t tail = None;
+        uint32_t size = 0;
+    };
+    std::vector<uint32_t> prev;
+    std::vector<uint32_t> next;
+
+    uint32_t add() {
+        prev.push_back(None);
+        next.push_back(None);
+        return static_cast<uint32_t>(prev.size() - 1);
+    }
+    void push(List& list, uint32_t b) {
+        prev[b] = None;
+        next[b] = list.head;
+        if (list.head != None) prev[list.head] = b; else list.tail = b;
+        list.head = b;
+        ++list.size;
+    }
+    void erase(List& list, uint32_t b) {
+        if (prev[b] != None) next[prev[b]] = next[b]; else list.head = next[b];
+        if (next[b] != None) prev[next[b]] = prev[b]; else list.tail = prev[b];
+        --list.size;
+    }
+    // Puts front ahead of back, leaving the result in back.
+    void splice(List& front, List& back) {
+        if (front.size == 0) return;
+        if (back.size != 0) {
+            next[front.tail] = back.head;
+            prev[back.head] = front.tail;
+            front.tail = back.tail;
+        }
+        front.size += back.size;
+        back = front;
+        front = List();
+    }
+};
+
+struct DraftRegion {
+    uint32_t entryEdge;
+    uint32_t exitEdge;
+    uint32_t parent;
+    uint32_t edgeClass;
+    bool sequence;
+};
+
+// Wraps runs of consecutive same-class children of parent into sequence
+// regions until it has at most about maxChildren children, then does the
+// same inside each new sequence.
+void groupSequences(std::vector<DraftRegion>& regions, std::vector<std::vector<uint32_t>>& children,
+                    uint32_t parent, uint32_t maxChildren) {
+    std::vector<uint32_t>& kids = children[parent];
+    if (kids.size() <= maxChildren) return;
+    const size_t groupSize = (kids.size() + maxChildren - 1) / maxChildren;
+
+    // Chains per class, in DFS order.
+    std::vector<std::vector<uint32_t>> chains;
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> byClass;
+        byClass.reserve(kids.size());
+        for (uint32_t i = 0; i < kids.size(); ++i) byClass.emplace_back(regions[kids[i]].edgeClass, i);
+        std::stable_sort(byClass.begin(), byClass.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < byClass.size(); ++i) {
+            if (i == 0 || byClass[i].first != byClass[i - 1].first ||
+                regions[kids[byClass[i - 1].second]].exitEdge != regions[kids[byClass[i].second]].entryEdge) {
+                chains.emplace_back();
+            }
+            chains.back().push_back(kids[byClass[i].second]);
+        }
+    }
+
+    std::vector<uint32_t> groupOf(regions.size(), None);
+    std::vector<uint32_t> created;
+    for (const std::vector<uint32_t>& chain : chains) {
+        if (chain.size() < std::max<size_t>(groupSize, 2)) continue;
+        for (size_t start = 0; start < chain.size(); start += groupSize) {
+            const size_t end = std::min(chain.size(), start + groupSize);
+            if (end - start < 2) continue;
+            const uint32_t group = static_cast<uint32_t>(regions.size());
+            regions.push_back({regions[chain[start]].entryEdge, regions[chain[end - 1]].exitEdge,
+                               parent, regions[chain[start]].edgeClass, true});
+            children.emplace_back(chain.begin() + start, chain.begin() + end);
+            groupOf.resize(regions.size(), None);
+            for (size_t i = start; i < end; ++i) {
+                groupOf[chain[i]] = group;
+                regions[chain[i]].parent = group;
+            }
+            created.push_back(group);
+        }
+    }
+    if (created.empty()) return;
+
+    // A group takes the place of its first member.
+    std::vector<uint32_t> regrouped;
+    for (uint32_t kid : children[parent]) {
+        const uint32_t group = groupOf[kid];
+        if (group == None) regrouped.push_back(kid);
+        else if (children[group].front() == kid) regrouped.push_back(group);
+    }
+    children[parent] = std::move(regrouped);
+    for (uint32_t group : created) groupSequences(regions, children, group, maxChildren);
+}
+
+} // namespace
+
+std::vector<uint32_t> cycleEquivalenceClasses(const CSRGraph& graph) {
+    const size_t nodeCount = graph.nodeCount();
+    const uint32_t edgeCount = static_cast<uint32_t>(graph.edgeCount());
+    const bool augmented = graph.entry() != CSRGraph::InvalidIndex && graph.exit() != CSRGraph::InvalidIndex &&
+                           graph.entry() != graph.exit();
+    const UndirectedView view{graph, augmented ? edgeCount : None};
+    std::vector<uint32_t> edgeClass(edgeCount + 1, None);
+    uint32_t classCount = 0;
+
+    if (graph.entry() != CSRGraph::InvalidIndex) {
+        const uint32_t Infinity = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> dfsNum(nodeCount, None);
+        std::vector<CSRGraph::Index> nodeAt;
+        std::vector<uint32_t> parentEdge(nodeCount, None);
+        std::vector<CSRGraph::Index> parentNode(nodeCount, CSRGraph::InvalidIndex);
+        std::vector<uint32_t> cursor(nodeCount, 0);
+        std::vector<uint32_t> hi(nodeCount, Infinity);
+        std::vector<uint32_t> childHi(nodeCount, Infinity);      // lowest hi over children
+        std::vector<uint32_t> childHi2(nodeCount, Infinity);     // lowest over the other children
+        std::vector<BracketLists::List> lists(nodeCount);
+
+        // Per bracket: the undirected edge (None for capping brackets), the
+        // lists of brackets leaving and reaching each node, and the size and
+        // class it last topped a list with.
+        BracketLists brackets;
+        std::vector<uint32_t> bracketEdge;
+        std::vector<uint32_t> nextFrom, nextTo;
+        std::vector<uint32_t> fromHead(nodeCount, None), toHead(nodeCount, None);
+        std::vector<uint32_t> bracketTarget;
+        std::vector<uint32_t> recentSize, recentClass;
+        auto newBracket = [&](uint32_t edge, CSRGraph::Index to) {
+            const uint32_t b = brackets.add();
+            bracketEdge.push_back(edge);
+            bracketTarget.push_back(to);
+            nextFrom.push_back(None);
+            nextTo.push_back(toHead[to]);
+            toHead[to] = b;
+            recentSize.push_back(None);
+            recentClass.push_back(None);
+            return b;
+        };
+
+        std::vector<CSRGraph::Index> stack{graph.entry()};
+        dfsNum[graph.entry()] = 0;
+        nodeAt.push_back(graph.entry());
+        while (!stack.empty()) {
+            const CSRGraph::Index n = stack.back();
+            if (cursor[n] < view.degree(n)) {
+                const auto [edge, other] = view.neighbour(n, cursor[n]++);
+                if (other == n || edge == parentEdge[n]) continue;
+                if (dfsNum[other] == None) {
+                    dfsNum[other] = static_cast<uint32_t>(nodeAt.size());
+                    nodeAt.push_back(other);
+                    parentEdge[other] = edge;
+                    parentNode[other] = n;
+                    stack.push_back(other);
+                } else if (dfsNum[other] < dfsNum[n]) {
+                    const uint32_t b = newBracket(edge, other);
+                    nextFrom[b] = fromHead[n];
+                    fromHead[n] = b;
+                }
+                continue;
+            }
+            stack.pop_back();
+
+            // All of n's subtree is done and its brackets are in lists[n].
+            uint32_t hi0 = Infinity;
+            for (uint32_t b = fromHead[n]; b != None; b = nextFrom[b]) hi0 = std::min(hi0, dfsNum[bracketTarget[b]]);
+            hi[n] = std::min(hi0, childHi[n]);
+            BracketLists::List& list = lists[n];
+            for (uint32_t b = toHead[n]; b != None; b = nextTo[b]) {
+                brackets.erase(list, b);
+                if (bracketEdge[b] != None && edgeClass[bracketEdge[b]] == None) edgeClass[bracketEdge[b]] = classCount++;
+            }
+            for (uint32_t b = fromHead[n]; b != None; b = nextFrom[b]) brackets.push(list, b);
+            if (childHi2[n] < hi0 && childHi2[n] < dfsNum[n]) {
+                // Capping bracket: a second child also has brackets passing
+                // above n, so the edge into n must not match the edges
+                // below it. Brackets that end at n itself pass nothing.
+                const uint32_t capping = newBracket(None, nodeAt[childHi2[n]]);
+                brackets.push(list, capping);
+            }
+
+            const CSRGraph::Index parent = parentNode[n];
+            if (parent == CSRGraph::InvalidIndex) continue;
+            const uint32_t treeEdge = parentEdge[n];
+            if (list.size == 0) {
+                edgeClass[treeEdge] = classCount++;   // a bridge
+            } else {
+                const uint32_t top = list.head;
+                if (recentSize[top] != list.size) {
+                    recentSize[top] = list.size;
+                    recentClass[top] = classCount++;
+                }
+                edgeClass[treeEdge] = recentClass[top];
+                if (recentSize[top] == 1 && bracketEdge[top] != None) edgeClass[bracketEdge[top]] = edgeClass[treeEdge];
+            }
+            brackets.splice(list, lists[parent]);
+            if (hi[n] < childHi[parent]) {
+                childHi2[parent] = childHi[parent];
+                childHi[parent] = hi[n];
+            } else {
+                childHi2[parent] = std::min(childHi2[parent], hi[n]);
+            }
+        }
+    }
+
+    // Self loops and edges the search never reached each form a class.
+    for (uint32_t e = 0; e < edgeCount; ++e) {
+        if (edgeClass[e] == None) edgeClass[e] = classCount++;
+    }
+    edgeClass.pop_back();
+    return edgeClass;
+}
+
+ProgramStructureTree ProgramStructureTree::build(const CSRGraph& graph, uint32_t maxChildren) {
+    ProgramStructureTree tree;
+    const size_t nodeCount = graph.nodeCount();
+    tree.m_edgeClass = cycleEquivalenceClasses(graph);
+
+    std::vector<DraftRegion> regions{{NoEdge, NoEdge, NoRegion, None, false}};
+    std::vector<uint32_t> regionOf(nodeCount, Root);
+    if (graph.entry() != CSRGraph::InvalidIndex) {
+        // Edges of each class the directed search will cross, so that the
+        // last one closes a region without opening another.
+        std::vector<char> reached(nodeCount, 0);
+        std::vector<CSRGraph::Index> stack{graph.entry()};
+        reached[graph.entry()] = 1;
+        std::vector<uint32_t> remaining(graph.edgeCount() + 1, 0);
+        while (!stack.empty()) {
+            const CSRGraph::Index n = stack.back();
+            stack.pop_back();
+            for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+                ++remaining[tree.m_edgeClass[e]];
+                if (!reached[graph.edgeTarget(e)]) {
+                    reached[graph.edgeTarget(e)] = 1;
+                    stack.push_back(graph.edgeTarget(e));
+                }
+            }
+        }
+
+        // Directed DFS in dominance order: an edge closes the open region of
+        // its class, if any, and opens the next one unless it is the last.
+        // Leaving a node restores the region it was found in.
+        std::vector<uint32_t> open(graph.edgeCount() + 1, None);
+        std::vector<uint32_t> cursor(nodeCount, 0);
+        std::vector<char> visited(nodeCount, 0);
+        visited[graph.entry()] = 1;
+        stack.push_back(graph.entry());
+        while (!stack.empty()) {
+            const CSRGraph::Index n = stack.back();
+            if (cursor[n] == graph.outDegree(n)) {
+                stack.pop_back();
+                continue;
+            }
+            const uint32_t e = graph.edgeBegin(n) + cursor[n]++;
+            const uint32_t c = tree.m_edgeClass[e];
+            uint32_t current = regionOf[n];
+            if (open[c] != None) {
+                regions[open[c]].exitEdge = e;
+                current = regions[open[c]].parent;
+                open[c] = None;
+            }
+            if (--remaining[c] > 0) {
+                open[c] = static_cast<uint32_t>(regions.size());
+                regions.push_back({e, NoEdge, current, c, false});
+                current = open[c];
+            }
+            const CSRGraph::Index target = graph.edgeTarget(e);
+            if (!visited[target]) {
+                visited[target] = 1;
+                regionOf[target] = current;
+                stack.push_back(target);
+            }
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> children(regions.size());
+    for (uint32_t r = 1; r < regions.size(); ++r) children[regions[r].parent].push_back(r);
+    if (maxChildren > 0) {
+        const size_t canonical = regions.size();
+        for (uint32_t r = 0; r < canonical; ++r) groupSequences(regions, children, r, maxChildren);
+    }
+
+    // Renumber in preorder and lay the tree out as CSR arrays.
+    std::vector<uint32_t> preorder(regions.size(), None);
+    std::vector<uint32_t> order;
+    order.reserve(regions.size());
+    std::vector<uint32_t> stack{Root};
+    while (!stack.empty()) {
+        const uint32_t r = stack.back();
+        stack.pop_back();
+        preorder[r] = static_cast<uint32_t>(order.size());
+        order.push_back(r);
+        for (auto it = children[r].rbegin(); it != children[r].rend(); ++it) stack.push_back(*it);
+    }
+
+    const size_t regionCount = order.size();
+    tree.m_regions.resize(regionCount);
+    tree.m_childOffsets.assign(regionCount + 1, 0);
+    tree.m_children.reserve(regionCount - 1);
+    for (uint32_t i = 0; i < regionCount; ++i) {
+        const DraftRegion& draft = regions[order[i]];
+        Region& region = tree.m_regions[i];
+        region.entryEdge = draft.entryEdge;
+        region.exitEdge = draft.exitEdge;
+        region.parent = draft.parent == NoRegion ? NoRegion : preorder[draft.parent];
+        region.depth = draft.parent == NoRegion ? 0 : tree.m_regions[region.parent].depth + 1;
+        region.blockCount = 0;
+        region.sequence = draft.sequence;
+        for (uint32_t child : children[order[i]]) tree.m_children.push_back(preorder[child]);
+        tree.m_childOffsets[i + 1] = static_cast<uint32_t>(tree.m_children.size());
+    }
+
+    tree.m_regionOf.resize(nodeCount);
+    tree.m_blockOffsets.assign(regionCount + 1, 0);
+    for (size_t n = 0; n < nodeCount; ++n) {
+        tree.m_regionOf[n] = preorder[regionOf[n]];
+        ++tree.m_blockOffsets[tree.m_regionOf[n] + 1];
+    }
+    for (size_t r = 0; r < regionCount; ++r) tree.m_blockOffsets[r + 1] += tree.m_blockOffsets[r];
+    tree.m_blocks.resize(nodeCount);
+    std::vector<uint32_t> fill(tree.m_blockOffsets.begin(), tree.m_blockOffsets.end() - 1);
+    for (Index n = 0; n < nodeCount; ++n) tree.m_blocks[fill[tree.m_regionOf[n]]++] = n;
+
+    // Children follow their parent in preorder, so one backward pass sums
+    // block counts and finds where each subtree ends.
+    tree.m_subtreeEnd.resize(regionCount);
+    for (uint32_t r = static_cast<uint32_t>(regionCount); r-- > 0;) {
+        Region& region = tree.m_regions[r];
+        region.blockCount += tree.m_blockOffsets[r + 1] - tree.m_blockOffsets[r];
+        const auto kids = tree.children(r);
+        tree.m_subtreeEnd[r] = kids.empty() ? r + 1 : tree.m_subtreeEnd[kids.back()];
+        if (region.parent != NoRegion) tree.m_regions[region.parent].blockCount += region.blockCount;
+    }
+    return tree;
+}
+
+} // namespace GraphGenerator
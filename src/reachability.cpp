@@ -0,0 +1,245 @@
+#include "reachability.h"
+#include <algorithm>
+#include <limits>
+
+namespace GraphGenerator {
+
+namespace {
+
+constexpr uint32_t Unvisited = std::numeric_limits<uint32_t>::max();
+
+// Tarjan's algorithm without recursion. Components are completed sinks
+// first, so numbering them backwards yields a topological order.
+std::vector<uint32_t> stronglyConnectedComponents(const CSRGraph& graph, uint32_t& componentCount) {
+    using Index = CSRGraph::Index;
+    const size_t n = graph.nodeCount();
+    std::vector<uint32_t> preorder(n, Unvisited);
+    std::vector<uint32_t> low(n, 0);
+    std::vector<uint32_t> component(n, Unvisited);
+    std::vector<Index> pending;                          // nodes not yet assigned
+    std::vector<std::pair<Index, uint32_t>> stack;       // node, next edge
+    uint32_t counter = 0;
+    uint32_t completed = 0;
+
+    for (Index root = 0; root < n; ++root) {
+        if (preorder[root] != Unvisited) continue;
+        stack.push_back({root, graph.edgeBegin(root)});
+        preorder[root] = low[root] = counter++;
+        pending.push_back(root);
+        while (!stack.empty()) {
+            auto& [node, edge] = stack.back();
+            if (edge < graph.edgeEnd(node)) {
+                const Index succ = graph.edgeTarget(edge++);
+                if (preorder[succ] == Unvisited) {
+                    preorder[succ] = low[succ] = counter++;
+                    pending.push_back(succ);
+                    stack.push_back({succ, graph.edgeBegin(succ)});
+                } else if (component[succ] == Unvisited) {
+                    low[node] = std::min(low[node], preorder[succ]);
+                }
+                continue;
+            }
+            const Index done = node;
+            stack.pop_back();
+            if (!stack.empty()) {
+                low[stack.back().first] = std::min(low[stack.back().first], low[done]);
+            }
+            if (low[done] == preorder[done]) {
+                Index member;
+                do {
+                    member = pending.back();
+                    pending.pop_back();
+                    component[member] = completed;
+                } while (member != done);
+                ++completed;
+            }
+        }
+    }
+
+    for (uint32_t& c : component) {
+        c = completed - 1 - c;
+    }
+    componentCount = completed;
+    return component;
+}
+
+// Turns (key, value) pairs into CSR offsets and values grouped by key.
+void buildRows(size_t rows, const std::vector<std::pair<uint32_t, uint32_t>>& pairs,
+               std::vector<uint32_t>& offsets, std::vector<uint32_t>& values) {
+    offsets.assign(rows + 1, 0);
+    for (const auto& pair : pairs) ++offsets[pair.first + 1];
+    for (size_t r = 0; r < rows; ++r) offsets[r + 1] += offsets[r];
+    values.resize(pairs.size());
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (const auto& pair : pairs) values[cursor[pair.first]++] = pair.second;
+}
+
+} // namespace
+
+ReachabilityIndex ReachabilityIndex::build(const CSRGraph& graph) {
+    ReachabilityIndex index;
+    uint32_t count = 0;
+    index.m_component = stronglyConnectedComponents(graph, count);
+
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    pairs.reserve(graph.nodeCount());
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        pairs.push_back({index.m_component[n], n});
+    }
+    buildRows(count, pairs, index.m_memberOffsets, index.m_members);
+
+    // Condensation edges, without self loops and duplicates.
+    pairs.clear();
+    for (Index n = 0; n < graph.nodeCount(); ++n) {
+        for (uint32_t e = graph.edgeBegin(n); e < graph.edgeEnd(n); ++e) {
+            const uint32_t from = index.m_component[n];
+            const uint32_t to = index.m_component[graph.edgeTarget(e)];
+            if (from != to) pairs.push_back({from, to});
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    buildRows(count, pairs, index.m_dagOffsets, index.m_dagTargets);
+    for (auto& pair : pairs) std::swap(pair.first, pair.second);
+    buildRows(count, pairs, index.m_dagPredOffsets, index.m_dagSources);
+
+    // One DFS over the condensation, started from every source component
+    // in topological order, assigns post numbers and tree intervals.
+    index.m_post.assign(count, Unvisited);
+    index.m_treeLow.assign(count, 0);
+    uint32_t counter = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> stack;  // component, next edge
+    for (uint32_t root = 0; root < count; ++root) {
+        if (index.m_post[root] != Unvisited) continue;
+        index.m_post[root] = 0;  // visited; replaced when finished
+        index.m_treeLow[root] = counter;
+        stack.push_back({root, index.m_dagOffsets[root]});
+        while (!stack.empty()) {
+            auto& [c, edge] = stack.back();
+            if (edge < index.m_dagOffsets[c + 1]) {
+                const uint32_t succ = index.m_dagTargets[edge++];
+                if (index.m_post[succ] == Unvisited) {
+                    index.m_post[succ] = 0;
+                    index.m_treeLow[succ] = counter;
+                    stack.push_back({succ, index.m_dagOffsets[succ]});
+                }
+                continue;
+            }
+            index.m_post[c] = counter++;
+            stack.pop_back();
+        }
+    }
+
+    // Descendants finish later in topological order, so sweeping it
+    // backwards sees every successor's label first.
+    index.m_reachLow.resize(count);
+    for (uint32_t c = count; c-- > 0;) {
+        uint32_t low = index.m_treeLow[c];
+        for (uint32_t e = index.m_dagOffsets[c]; e < index.m_dagOffsets[c + 1]; ++e) {
+            low = std::min(low, index.m_reachLow[index.m_dagTargets[e]]);
+        }
+        index.m_reachLow[c] = low;
+    }
+
+    if (count <= ClosureComponentLimit) {
+        index.m_closure = BitMatrix(count, count);
+        const size_t words = index.m_closure.words();
+        for (uint32_t c = count; c-- > 0;) {
+            uint64_t* row = index.m_closure.row(c);
+            index.m_closure.set(c, c);
+            for (uint32_t e = index.m_dagOffsets[c]; e < index.m_dagOffsets[c + 1]; ++e) {
+                // Successors only reach components after themselves.
+                const uint32_t succ = index.m_dagTargets[e];
+                const uint64_t* other = index.m_closure.row(succ);
+                for (size_t w = succ / 64; w < words; ++w) row[w] |= other[w];
+            }
+        }
+    }
+    return index;
+}
+
+bool ReachabilityIndex::reachesComponent(uint32_t from, uint32_t to) const {
+    if (from == to) return true;
+    if (from > to) return false;  // topological numbering
+    if (hasClosure()) return m_closure.test(from, to);
+
+    auto inTree = [&](uint32_t a, uint32_t b) {
+        return m_treeLow[a] <= m_post[b] && m_post[b] <= m_post[a];
+    };
+    auto mayReach = [&](uint32_t a, uint32_t b) {
+        return a <= b && m_reachLow[a] <= m_reachLow[b] && m_post[b] <= m_post[a];
+    };
+    if (inTree(from, to)) return true;
+    if (!mayReach(from, to)) return false;
+
+    std::vector<bool> visited(componentCount(), false);
+    std::vector<uint32_t> stack{from};
+    visited[from] = true;
+    while (!stack.empty()) {
+        const uint32_t c = stack.back();
+        stack.pop_back();
+        for (uint32_t e = m_dagOffsets[c]; e < m_dagOffsets[c + 1]; ++e) {
+            const uint32_t succ = m_dagTargets[e];
+            if (visited[succ] || !mayReach(succ, to)) continue;
+            if (inTree(succ, to)) return true;
+            visited[succ] = true;
+            stack.push_back(succ);
+        }
+    }
+    return false;
+}
+
+bool ReachabilityIndex::reaches(Index from, Index to) const {
+    return reachesComponent(m_component[from], m_component[to]);
+}
+
+std::vector<bool> ReachabilityIndex::reachableComponents(uint32_t start, uint32_t bound, bool forward) const {
+    // Components between start and bound in topological order that start
+    // reaches (forward) or that reach start (backward).
+    const std::vector<uint32_t>& offsets = forward ? m_dagOffsets : m_dagPredOffsets;
+    const std::vector<uint32_t>& targets = forward ? m_dagTargets : m_dagSources;
+    std::vector<bool> visited(componentCount(), false);
+    std::vector<uint32_t> stack{start};
+    visited[start] = true;
+    while (!stack.empty()) {
+        const uint32_t c = stack.back();
+        stack.pop_back();
+        for (uint32_t e = offsets[c]; e < offsets[c + 1]; ++e) {
+            const uint32_t next = targets[e];
+            if (visited[next] || (forward ? next > bound : next < bound)) continue;
+            visited[next] = true;
+            stack.push_back(next);
+        }
+    }
+    return visited;
+}
+
+std::vector<CSRGraph::Index> ReachabilityIndex::between(Index from, Index to) const {
+    std::vector<Index> nodes;
+    const uint32_t first = m_component[from];
+    const uint32_t last = m_component[to];
+    if (!reachesComponent(first, last)) return nodes;
+
+    // Only components topologically between the two can lie on a path.
+    std::vector<uint32_t> components;
+    if (hasClosure()) {
+        for (uint32_t c = first; c <= last; ++c) {
+            if (m_closure.test(first, c) && m_closure.test(c, last)) components.push_back(c);
+        }
+    } else {
+        const std::vector<bool> forward = reachableComponents(first, last, true);
+        const std::vector<bool> backward = reachableComponents(last, first, false);
+        for (uint32_t c = first; c <= last; ++c) {
+            if (forward[c] && backward[c]) components.push_back(c);
+        }
+    }
+
+    for (uint32_t c : components) {
+        nodes.insert(nodes.end(), m_members.begin() + m_memberOffsets[c],
+                     m_members.begin() + m_memberOffsets[c + 1]);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+} // namespace GraphGenerator
@@ -1,29 +1,157 @@
 #include "visualizer.h"
+#include "loop_forest.h"
+#include "graph_simplify.h"
+#include "cfg_hash.h"
+#include "dead_code.h"
+#include "control_dependence.h"
+#include "block_frequency.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <optional>
+#include <set>
 #include <stdexcept>
+#include <unordered_set>
 #include <QDebug>
 
 namespace Visualizer {
 
+// Comma-separated variable names, written as a node attribute so the GUI
+// can highlight definitions and uses without the AST.
+static void writeVariables(std::stringstream& dot, const char* attribute,
+                           const GraphGenerator::CSRGraph& csr, llvm::ArrayRef<uint32_t> variables)
+{
+    if (variables.empty()) return;
+    dot << ", " << attribute << "=\"";
+    for (size_t i = 0; i < variables.size(); ++i) {
+        dot << (i ? "," : "") << csr.variableName(variables[i]);
+    }
+    dot << "\"";
+}
+
+// Variables accessed by any block merged into a simplified node.
+static std::vector<uint32_t> memberVariables(const GraphGenerator::SimplifiedGraph& simplified,
+                                             GraphGenerator::CSRGraph::Index n, bool definitions)
+{
+    std::vector<uint32_t> variables;
+    for (GraphGenerator::CSRGraph::Index member : simplified.members(n)) {
+        llvm::ArrayRef<uint32_t> own = definitions ? simplified.original().variablesDefinedIn(member)
+                                                   : simplified.original().variablesUsedIn(member);
+        variables.insert(variables.end(), own.begin(), own.end());
+    }
+    std::sort(variables.begin(), variables.end());
+    variables.erase(std::unique(variables.begin(), variables.end()), variables.end());
+    return variables;
+}
+
 std::string generateDotRepresentation(
     const GraphGenerator::CFGGraph* graph,
     bool showLineNumbers,
     bool simplifyGraph,
-    const std::vector<int>& highlightPaths)
+    const std::vector<int>& highlightPaths,
+    bool heatMap)
 {
     if (!graph) {
         throw std::invalid_argument("Graph pointer cannot be null");
     }
+    return generateDotRepresentation(graph->freeze(), GraphAnalyses{}, showLineNumbers, simplifyGraph,
+                                     highlightPaths, heatMap);
+}
+
+std::string generateDotRepresentation(
+    std::shared_ptr<const GraphGenerator::CSRGraph> csr,
+    const GraphAnalyses& analyses,
+    bool showLineNumbers,
+    bool simplifyGraph,
+    const std::vector<int>& highlightPaths,
+    bool heatMap)
+{
+    if (!csr) {
+        throw std::invalid_argument("Graph pointer cannot be null");
+    }
+
+    // simplifyGraph draws the reduced graph instead, with chains merged
+    // and empty blocks collapsed. Block IDs given by the caller are mapped
+    // to the node they were merged into.
+    std::optional<GraphGenerator::SimplifiedGraph> simplified;
+    if (simplifyGraph) {
+        simplified = GraphGenerator::SimplifiedGraph::build(csr);
+    }
+    const GraphGenerator::CSRGraph& shown = simplified ? simplified->graph() : *csr;
+    auto shownId = [&](int blockId) {
+        const GraphGenerator::CSRGraph::Index n = simplified ? csr->indexOf(blockId) : GraphGenerator::CSRGraph::InvalidIndex;
+        return n == GraphGenerator::CSRGraph::InvalidIndex ? blockId : shown.blockId(simplified->reducedNode(n));
+    };
+    // The caller's loops are those of the snapshot; a reduced graph needs
+    // its own as well.
+    std::optional<GraphGenerator::LoopForest> builtLoops, shownLoops;
+    if (!analyses.loops) {
+        builtLoops = GraphGenerator::LoopForest::build(*csr);
+    }
+    const GraphGenerator::LoopForest& csrLoops = analyses.loops ? *analyses.loops : *builtLoops;
+    if (simplified) {
+        shownLoops = GraphGenerator::LoopForest::build(shown);
+    }
+    const GraphGenerator::LoopForest& loops = shownLoops ? *shownLoops : csrLoops;
+    const std::vector<GraphGenerator::CSRGraph::Index> unreachable = GraphGenerator::unreachableBlocks(shown);
+    std::optional<GraphGenerator::ControlDependence> builtDependence;
+    if (simplified || !analyses.controlDependence) {
+        builtDependence = GraphGenerator::ControlDependence::build(
+            shown, GraphGenerator::DominatorTree::build(GraphGenerator::ReversedGraph(shown)));
+    }
+    const GraphGenerator::ControlDependence& controlDependence =
+        builtDependence ? *builtDependence : *analyses.controlDependence;
+
+    // Static block frequencies, written as freq on every node and drawn as
+    // a heat map on request. They are estimated on the original graph,
+    // whose blocks still carry the branch conditions; a merged node shows
+    // its hottest block.
+    std::vector<double> estimated;
+    llvm::ArrayRef<double> frequencies = analyses.frequencies;
+    if (frequencies.size() != csr->nodeCount()) {
+        estimated = GraphGenerator::estimateBlockFrequencies(
+            *csr, csrLoops, GraphGenerator::estimateBranchProbabilities(*csr, csrLoops));
+        frequencies = estimated;
+    }
+    auto frequencyOf = [&](GraphGenerator::CSRGraph::Index n) {
+        if (!simplified) return frequencies[n];
+        double hottest = 0;
+        for (GraphGenerator::CSRGraph::Index member : simplified->members(n)) {
+            hottest = std::max(hottest, frequencies[member]);
+        }
+        return hottest;
+    };
+    const double maxFrequency = frequencies.empty() ? 0 : *std::max_element(frequencies.begin(), frequencies.end());
+
+    // highlightPaths is read as a path in block order: its blocks are
+    // filled and the edges between consecutive blocks drawn thick.
+    std::unordered_set<int> highlightedNodes;
+    std::set<std::pair<int, int>> highlightedEdges;
+    for (size_t i = 0; i < highlightPaths.size(); ++i) {
+        highlightedNodes.insert(shownId(highlightPaths[i]));
+        if (i > 0 && shownId(highlightPaths[i - 1]) != shownId(highlightPaths[i])) {
+            highlightedEdges.emplace(shownId(highlightPaths[i - 1]), shownId(highlightPaths[i]));
+        }
+    }
 
     std::stringstream dot;
     dot << "digraph CFG {\n";
+    // Lets tools compare function shapes across files without parsing
+    // them; entry and exit let loadCfgDot rebuild the graph faithfully.
+    const uint64_t shapeHash = analyses.shapeHash ? *analyses.shapeHash : GraphGenerator::computeStructuralHash(*csr);
+    dot << "  graph [shape_hash=\"" << GraphGenerator::formatStructuralHash(shapeHash) << "\"";
+    if (shown.entry() != GraphGenerator::CSRGraph::InvalidIndex) {
+        dot << ", entry=\"" << shown.blockId(shown.entry()) << "\"";
+    }
+    if (shown.exit() != GraphGenerator::CSRGraph::InvalidIndex) {
+        dot << ", exit=\"" << shown.blockId(shown.exit()) << "\"";
+    }
+    dot << "];\n";
     dot << "  node [shape=box, fontname=\"Courier\", fontsize=10];\n";
     dot << "  edge [fontsize=8];\n";
     
     // Add nodes
-    for (const auto& [id, node] : graph->getNodes()) {
+    for (const auto& [id, node] : shown.nodes()) {
         dot << "  " << id << " [label=\"";
         
         if (showLineNumbers) {
@@ -36,40 +164,114 @@ std::string generateDotRepresentation(
             //     dot << "Line " << lineNum << ": ";
             // }
         }
-        dot << graph->getNodeLabel(id) << "\"";
+        dot << node.label << "\"";
+        if (simplified) {
+            writeVariables(dot, "defs", *csr, memberVariables(*simplified, node.index, true));
+            writeVariables(dot, "uses", *csr, memberVariables(*simplified, node.index, false));
+            if (simplified->members(node.index).size() > 1) {
+                dot << ", blocks=\"";
+                const char* separator = "";
+                for (GraphGenerator::CSRGraph::Index member : simplified->members(node.index)) {
+                    dot << separator << csr->blockId(member);
+                    separator = ",";
+                }
+                dot << "\"";
+            }
+        } else {
+            writeVariables(dot, "defs", *csr, csr->variablesDefinedIn(node.index));
+            writeVariables(dot, "uses", *csr, csr->variablesUsedIn(node.index));
+        }
+        // Blocks whose branch decides whether this one runs, suffixed :T
+        // or :F when the deciding edge is a true or false branch.
+        llvm::ArrayRef<GraphGenerator::CSRGraph::Index> controllers = controlDependence.controllers(node.index);
+        if (!controllers.empty()) {
+            llvm::ArrayRef<uint32_t> edges = controlDependence.controllingEdges(node.index);
+            dot << ", cdeps=\"";
+            for (size_t i = 0; i < controllers.size(); ++i) {
+                dot << (i ? "," : "") << shown.blockId(controllers[i]);
+                if (shown.edgeFlags(edges[i]) & GraphGenerator::EdgeTrueBranch) dot << ":T";
+                if (shown.edgeFlags(edges[i]) & GraphGenerator::EdgeFalseBranch) dot << ":F";
+            }
+            dot << "\"";
+        }
+        dot << ", freq=\"" << frequencyOf(node.index) << "\"";
         
-        // Apply styles based on node properties
-        if (graph->isNodeTryBlock(id)) {
-            dot << ", style=filled, fillcolor=lightblue";
+        // Apply styles based on node properties. Graphviz keeps only the
+        // last of a repeated attribute, so each node gets one style and
+        // one fill: highlighted, else unreachable, else heat, else the
+        // exception colours. try and throws keep the kinds readable.
+        const bool isTry = node.attributes & GraphGenerator::NodeTryBlock;
+        const bool isThrow = node.attributes & GraphGenerator::NodeThrowsException;
+        const bool isHighlighted = highlightedNodes.count(id) != 0;
+        const bool isBranch = node.successors.size() > 1;
+        const bool isUnreachable = std::binary_search(unreachable.begin(), unreachable.end(), node.index);
+        std::string fill;
+        if (isHighlighted) {
+            fill = "yellow";
+        } else if (isUnreachable) {
+            fill = "gray92";
+        } else if (heatMap) {
+            fill = GraphGenerator::heatColor(frequencyOf(node.index), maxFrequency);
+        } else if (isThrow) {
+            fill = "lightcoral";
+        } else if (isTry) {
+            fill = "lightblue";
+        }
+        std::string style = fill.empty() ? "" : "filled";
+        if (isBranch || isUnreachable) {
+            style += style.empty() ? "dashed" : ",dashed";
         }
-        if (graph->isNodeThrowingException(id)) {
-            dot << ", style=filled, fillcolor=lightcoral";
+        if (!style.empty()) {
+            dot << ", style=\"" << style << "\"";
         }
-        if (std::find(highlightPaths.begin(), highlightPaths.end(), id) != highlightPaths.end()) {
-            dot << ", style=filled, fillcolor=yellow, penwidth=2";
+        if (!fill.empty()) {
+            dot << ", fillcolor=\"" << fill << "\"";
+        }
+        if (isHighlighted) {
+            dot << ", penwidth=2";
+        }
+        if (isBranch) {
+            dot << ", color=gray";
         }
         if (simplifyGraph && node.successors.size() == 1) {
             dot << ", shape=ellipse";
         }
-        if (node.successors.size() > 1) {
-            dot << ", style=dashed, color=gray";
+        if (isTry) {
+            dot << ", try=\"true\"";
+        }
+        if (isThrow) {
+            dot << ", throws=\"true\"";
+        }
+        // Dimmed, and tagged so viewers can hide them.
+        if (isUnreachable) {
+            dot << ", fontcolor=gray50, unreachable=\"true\"";
         }
         
         dot << "];\n";
     }
     
     // Add edges
-    for (const auto& [id, node] : graph->getNodes()) {
-        for (int succ : node.successors) {
+    for (GraphGenerator::CSRGraph::Index n = 0; n < shown.nodeCount(); ++n) {
+        const int id = shown.blockId(n);
+        for (uint32_t e = shown.edgeBegin(n); e < shown.edgeEnd(n); ++e) {
+            const int succ = shown.blockId(shown.edgeTarget(e));
             dot << "  " << id << " -> " << succ;
             
-            if (graph->isExceptionEdge(id, succ)) {
-                dot << " [color=red, style=dashed, label=\"exception\"]";
+            // Back edges come from the loop forest. constraint=false keeps
+            // them from pulling loop headers below their bodies in the layout.
+            const bool isBackEdge = loops.isBackEdge(e);
+            const bool isHighlighted = highlightedEdges.count({id, succ}) != 0;
+            if (shown.edgeFlags(e) & GraphGenerator::EdgeException) {
+                dot << " [color=red, style=dashed, label=\"exception\""
+                    << (isBackEdge ? ", constraint=false" : "")
+                    << (isHighlighted ? ", penwidth=3" : "") << "]";
             } 
-            // Remove or replace with alternative approach
-            // else if (simplifyGraph && graph->isBackEdge(id, succ)) {
-            else if (simplifyGraph && succ <= id) {  // Simple heuristic for back edges
-                dot << " [color=blue, style=bold]";
+            else if (isBackEdge) {
+                dot << (simplifyGraph ? " [color=blue, style=bold, constraint=false" : " [constraint=false")
+                    << (isHighlighted ? ", penwidth=3" : "") << "]";
+            }
+            else if (isHighlighted) {
+                dot << " [color=orange, penwidth=3]";
             }
             
             dot << ";\n";
@@ -85,7 +287,25 @@ bool exportToDot(
     const std::string& filename,
     bool showLineNumbers,
     bool simplifyGraph,
-    const std::vector<int>& highlightPaths)
+    const std::vector<int>& highlightPaths,
+    bool heatMap)
+{
+    if (!graph) {
+        qWarning() << "Cannot export null graph";
+        return false;
+    }
+    return exportToDot(graph->freeze(), filename, GraphAnalyses{}, showLineNumbers, simplifyGraph,
+                       highlightPaths, heatMap);
+}
+
+bool exportToDot(
+    std::shared_ptr<const GraphGenerator::CSRGraph> graph,
+    const std::string& filename,
+    const GraphAnalyses& analyses,
+    bool showLineNumbers,
+    bool simplifyGraph,
+    const std::vector<int>& highlightPaths,
+    bool heatMap)
 {
     try {
         if (!graph) {
@@ -99,7 +319,8 @@ bool exportToDot(
             return false;
         }
 
-        outFile << generateDotRepresentation(graph, showLineNumbers, simplifyGraph, highlightPaths);
+        outFile << generateDotRepresentation(std::move(graph), analyses, showLineNumbers, simplifyGraph,
+                                             highlightPaths, heatMap);
         return true;
     } catch (const std::exception& e) {
         qCritical() << "Export failed:" << e.what();
@@ -113,14 +334,15 @@ bool exportGraph(
     ExportFormat format,
     bool showLineNumbers,
     bool simplifyGraph,
-    const std::vector<int>& highlightPaths)
+    const std::vector<int>& highlightPaths,
+    bool heatMap)
 {
     if (format != ExportFormat::DOT) {
         qWarning() << "Only DOT export is currently supported";
         return false;
     }
     
-    return exportToDot(graph, filename, showLineNumbers, simplifyGraph, highlightPaths);
+    return exportToDot(graph, filename, showLineNumbers, simplifyGraph, highlightPaths, heatMap);
 }
 
 } // namespace Visualizer
\ No newline at end of file